@@ -0,0 +1,5 @@
+#ifndef OUT_LAST_COMMIT_POSITION_H_
+#define OUT_LAST_COMMIT_POSITION_H_
+#define LAST_COMMIT_POSITION_NUM 1
+#define LAST_COMMIT_POSITION "1 (local)"
+#endif
@@ -669,11 +669,14 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/command_outputs.cc',
         'src/gn/command_path.cc',
         'src/gn/command_refs.cc',
+        'src/gn/command_server.cc',
         'src/gn/commands.cc',
         'src/gn/compile_commands_writer.cc',
+        'src/gn/compressed_bit_set.cc',
         'src/gn/rust_project_writer.cc',
         'src/gn/config.cc',
         'src/gn/config_values.cc',
+        'src/gn/config_values_cache.cc',
         'src/gn/config_values_extractors.cc',
         'src/gn/config_values_generator.cc',
         'src/gn/copy_target_generator.cc',
@@ -707,9 +710,11 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/function_write_file.cc',
         'src/gn/functions.cc',
         'src/gn/functions_target.cc',
+        'src/gn/gen_snapshot.cc',
         'src/gn/general_tool.cc',
         'src/gn/generated_file_target_generator.cc',
         'src/gn/group_target_generator.cc',
+        'src/gn/header_check_cache.cc',
         'src/gn/header_checker.cc',
         'src/gn/import_manager.cc',
         'src/gn/input_conversion.cc',
@@ -736,6 +741,7 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/ninja_group_target_writer.cc',
         'src/gn/ninja_outputs_writer.cc',
         'src/gn/ninja_rust_binary_target_writer.cc',
+        'src/gn/ninja_shared_vars_writer.cc',
         'src/gn/ninja_target_command_util.cc',
         'src/gn/ninja_target_writer.cc',
         'src/gn/ninja_toolchain_writer.cc',
@@ -745,6 +751,8 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/operators.cc',
         'src/gn/output_conversion.cc',
         'src/gn/output_file.cc',
+        'src/gn/parse_cache.cc',
+        'src/gn/parse_node_arena.cc',
         'src/gn/parse_node_value_adapter.cc',
         'src/gn/parse_tree.cc',
         'src/gn/parser.cc',
@@ -752,6 +760,7 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/pattern.cc',
         'src/gn/pool.cc',
         'src/gn/qt_creator_writer.cc',
+        'src/gn/query_server.cc',
         'src/gn/resolved_target_data.cc',
         'src/gn/runtime_deps.cc',
         'src/gn/rust_substitution_type.cc',
@@ -778,6 +787,7 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/swift_values_generator.cc',
         'src/gn/swift_variables.cc',
         'src/gn/switches.cc',
+        'src/gn/synthetic_build.cc',
         'src/gn/target.cc',
         'src/gn/target_generator.cc',
         'src/gn/template.cc',
@@ -809,6 +819,8 @@ def WriteGNNinja(path, platform, host, options, args_list):
   executables = {
       'gn': {'sources': [ 'src/gn/gn_main.cc' ], 'libs': []},
 
+      'gn_perftests': {'sources': [ 'src/gn/gn_perftests.cc' ], 'libs': []},
+
       'gn_unittests': { 'sources': [
         'src/gn/action_target_generator_unittest.cc',
         'src/gn/analyzer_unittest.cc',
@@ -820,7 +832,9 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/command_format_unittest.cc',
         'src/gn/commands_unittest.cc',
         'src/gn/compile_commands_writer_unittest.cc',
+        'src/gn/compressed_bit_set_unittest.cc',
         'src/gn/config_unittest.cc',
+        'src/gn/config_values_cache_unittest.cc',
         'src/gn/config_values_extractors_unittest.cc',
         'src/gn/escape_unittest.cc',
         'src/gn/exec_process_unittest.cc',
@@ -844,9 +858,14 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/functions_target_rust_unittest.cc',
         'src/gn/functions_target_unittest.cc',
         'src/gn/functions_unittest.cc',
+        'src/gn/gen_snapshot_unittest.cc',
         'src/gn/hash_table_base_unittest.cc',
+        'src/gn/header_check_cache_unittest.cc',
         'src/gn/header_checker_unittest.cc',
+        'src/gn/import_manager_unittest.cc',
         'src/gn/input_conversion_unittest.cc',
+        'src/gn/input_file_manager_unittest.cc',
+        'src/gn/input_file_unittest.cc',
         'src/gn/json_project_writer_unittest.cc',
         'src/gn/rust_project_writer_unittest.cc',
         'src/gn/rust_project_writer_helpers_unittest.cc',
@@ -869,17 +888,22 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/ninja_target_command_util_unittest.cc',
         'src/gn/ninja_target_writer_unittest.cc',
         'src/gn/ninja_toolchain_writer_unittest.cc',
+        'src/gn/ninja_writer_unittest.cc',
         'src/gn/operators_unittest.cc',
         'src/gn/output_conversion_unittest.cc',
+        'src/gn/parse_cache_unittest.cc',
+        'src/gn/parse_node_arena_unittest.cc',
         'src/gn/parse_tree_unittest.cc',
         'src/gn/parser_unittest.cc',
         'src/gn/path_output_unittest.cc',
         'src/gn/pattern_unittest.cc',
         'src/gn/pointer_set_unittest.cc',
+        'src/gn/query_server_unittest.cc',
         'src/gn/resolved_target_data_unittest.cc',
         'src/gn/resolved_target_deps_unittest.cc',
         'src/gn/runtime_deps_unittest.cc',
         'src/gn/scope_per_file_provider_unittest.cc',
+        'src/gn/scope_record_map_unittest.cc',
         'src/gn/scope_unittest.cc',
         'src/gn/setup_unittest.cc',
         'src/gn/source_dir_unittest.cc',
@@ -889,6 +913,7 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/string_utils_unittest.cc',
         'src/gn/substitution_pattern_unittest.cc',
         'src/gn/substitution_writer_unittest.cc',
+        'src/gn/synthetic_build_unittest.cc',
         'src/gn/target_public_pair_unittest.cc',
         'src/gn/target_unittest.cc',
         'src/gn/template_unittest.cc',
@@ -905,6 +930,7 @@ def WriteGNNinja(path, platform, host, options, args_list):
         'src/gn/xcode_object_unittest.cc',
         'src/gn/xml_element_writer_unittest.cc',
         'src/util/atomic_write_unittest.cc',
+        'src/util/worker_pool_unittest.cc',
         'src/util/test/gn_test.cc',
       ], 'libs': []},
   }
@@ -966,6 +992,7 @@ def WriteGNNinja(path, platform, host, options, args_list):
   # we just build static libraries that GN needs
   executables['gn']['libs'].extend(static_libraries.keys())
   executables['gn_unittests']['libs'].extend(static_libraries.keys())
+  executables['gn_perftests']['libs'].extend(static_libraries.keys())
 
   WriteGenericNinja(path, static_libraries, executables, cxx, ar, ld,
                     platform, host, options, args_list,
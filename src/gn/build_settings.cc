@@ -7,9 +7,12 @@
 #include <utility>
 
 #include "base/files/file_util.h"
+#include "gn/config_values_cache.h"
 #include "gn/filesystem_utils.h"
+#include "gn/ninja_shared_vars_writer.h"
 
-BuildSettings::BuildSettings() = default;
+BuildSettings::BuildSettings()
+    : config_values_cache_(std::make_unique<ConfigValuesCache>()) {}
 
 BuildSettings::BuildSettings(const BuildSettings& other)
     : dotfile_name_(other.dotfile_name_),
@@ -21,7 +24,15 @@ BuildSettings::BuildSettings(const BuildSettings& other)
       build_config_file_(other.build_config_file_),
       arg_file_template_path_(other.arg_file_template_path_),
       build_dir_(other.build_dir_),
-      build_args_(other.build_args_) {}
+      build_args_(other.build_args_),
+      config_values_cache_(std::make_unique<ConfigValuesCache>()) {}
+
+BuildSettings::~BuildSettings() = default;
+
+void BuildSettings::set_ninja_shared_vars_writer(
+    std::unique_ptr<NinjaSharedVarsWriter> writer) {
+  ninja_shared_vars_writer_ = std::move(writer);
+}
 
 void BuildSettings::SetRootTargetLabel(const Label& r) {
   root_target_label_ = r;
@@ -20,7 +20,9 @@
 #include "gn/source_file.h"
 #include "gn/version.h"
 
+class ConfigValuesCache;
 class Item;
+class NinjaSharedVarsWriter;
 
 // Settings for one build, which is one toplevel output directory. There
 // may be multiple Settings objects that refer to this, one for each toolchain.
@@ -31,6 +33,7 @@ class BuildSettings {
 
   BuildSettings();
   BuildSettings(const BuildSettings& other);
+  ~BuildSettings();
 
   // Root target label.
   const Label& root_target_label() const { return root_target_label_; }
@@ -151,6 +154,19 @@ class BuildSettings {
     exec_script_allowlist_ = std::move(list);
   }
 
+  // The flattened values of the config lists of the targets of this build.
+  ConfigValuesCache* config_values_cache() const {
+    return config_values_cache_.get();
+  }
+
+  // Writes the compiler variables of targets to shared files when set, see
+  // "gn gen --share-compiler-vars". Null by default.
+  NinjaSharedVarsWriter* ninja_shared_vars_writer() const {
+    return ninja_shared_vars_writer_.get();
+  }
+  void set_ninja_shared_vars_writer(
+      std::unique_ptr<NinjaSharedVarsWriter> writer);
+
  private:
   Label root_target_label_;
   std::vector<LabelPattern> root_patterns_;
@@ -175,6 +191,9 @@ class BuildSettings {
 
   std::unique_ptr<SourceFileSet> exec_script_allowlist_;
 
+  std::unique_ptr<ConfigValuesCache> config_values_cache_;
+  std::unique_ptr<NinjaSharedVarsWriter> ninja_shared_vars_writer_;
+
   BuildSettings& operator=(const BuildSettings&) = delete;
 };
 
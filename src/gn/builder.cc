@@ -6,6 +6,9 @@
 
 #include <stddef.h>
 #include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "gn/action_values.h"
@@ -23,34 +26,117 @@ namespace {
 
 using BuilderRecordSet = BuilderRecord::BuilderRecordSet;
 
-// Recursively looks in the tree for a given node, returning true if it
-// was found in the dependency graph. This is used to see if a given node
-// participates in a cycle.
-//
-// If this returns true, the cycle will be in *path. This should point to an
-// empty vector for the first call. During computation, the path will contain
-// the full dependency path to the current node.
-//
-// Return false means no cycle was found.
-bool RecursiveFindCycle(const BuilderRecord* search_in,
-                        std::vector<const BuilderRecord*>* path) {
-  path->push_back(search_in);
-  for (const auto& cur : search_in->GetSortedUnresolvedDeps()) {
-    std::vector<const BuilderRecord*>::iterator found =
-        std::find(path->begin(), path->end(), cur);
-    if (found != path->end()) {
-      // This item is already in the set, we found the cycle. Everything before
-      // the first definition of cur is irrelevant to the cycle.
-      path->erase(path->begin(), found);
-      path->push_back(cur);
-      return true;
+// Returns the strongly connected components of the graph of unresolved
+// dependencies reachable from the given records that contain a cycle, each
+// sorted by label. This is Tarjan's algorithm with an explicit stack so that
+// long dependency chains can't overflow the call stack.
+std::vector<std::vector<const BuilderRecord*>> FindCycleComponents(
+    const std::vector<const BuilderRecord*>& records) {
+  struct NodeState {
+    size_t index = 0;
+    size_t lowlink = 0;
+    bool on_stack = false;
+  };
+  struct Frame {
+    const BuilderRecord* record;
+    std::vector<const BuilderRecord*> deps;
+    size_t next_dep = 0;
+  };
+
+  std::unordered_map<const BuilderRecord*, NodeState> states;
+  std::vector<const BuilderRecord*> component_stack;
+  std::vector<Frame> call_stack;
+  std::vector<std::vector<const BuilderRecord*>> result;
+
+  auto visit = [&](const BuilderRecord* record) {
+    NodeState& state = states[record];
+    state.index = state.lowlink = states.size();
+    state.on_stack = true;
+    component_stack.push_back(record);
+    call_stack.push_back({record, record->GetSortedUnresolvedDeps()});
+  };
+
+  for (const BuilderRecord* root : records) {
+    if (states.count(root))
+      continue;
+    visit(root);
+    while (!call_stack.empty()) {
+      Frame& frame = call_stack.back();
+      if (frame.next_dep < frame.deps.size()) {
+        const BuilderRecord* dep = frame.deps[frame.next_dep++];
+        auto found = states.find(dep);
+        if (found == states.end()) {
+          visit(dep);  // Invalidates |frame|.
+        } else if (found->second.on_stack) {
+          NodeState& state = states[frame.record];
+          state.lowlink = std::min(state.lowlink, found->second.index);
+        }
+        continue;
+      }
+
+      const BuilderRecord* record = frame.record;
+      bool self_dep = std::find(frame.deps.begin(), frame.deps.end(),
+                                record) != frame.deps.end();
+      call_stack.pop_back();
+      const NodeState& state = states[record];
+      if (!call_stack.empty()) {
+        NodeState& parent = states[call_stack.back().record];
+        parent.lowlink = std::min(parent.lowlink, state.lowlink);
+      }
+      if (state.lowlink != state.index)
+        continue;  // Not the root of its component.
+
+      std::vector<const BuilderRecord*> component;
+      const BuilderRecord* member;
+      do {
+        member = component_stack.back();
+        component_stack.pop_back();
+        states[member].on_stack = false;
+        component.push_back(member);
+      } while (member != record);
+
+      if (component.size() > 1 || self_dep) {
+        std::sort(component.begin(), component.end(),
+                  BuilderRecord::LabelCompare);
+        result.push_back(std::move(component));
+      }
     }
+  }
 
-    if (RecursiveFindCycle(cur, path))
-      return true;  // Found cycle.
+  std::sort(result.begin(), result.end(),
+            [](const auto& a, const auto& b) {
+              return BuilderRecord::LabelCompare(a[0], b[0]);
+            });
+  return result;
+}
+
+// Returns the shortest cycle through the first record of the given strongly
+// connected component, starting and ending with that record.
+std::vector<const BuilderRecord*> FindCycleInComponent(
+    const std::vector<const BuilderRecord*>& component) {
+  const BuilderRecord* start = component[0];
+  std::unordered_set<const BuilderRecord*> members(component.begin(),
+                                                   component.end());
+  std::unordered_map<const BuilderRecord*, const BuilderRecord*> parents;
+  std::deque<const BuilderRecord*> queue = {start};
+  while (!queue.empty()) {
+    const BuilderRecord* record = queue.front();
+    queue.pop_front();
+    for (const BuilderRecord* dep : record->GetSortedUnresolvedDeps()) {
+      if (dep == start) {
+        std::vector<const BuilderRecord*> cycle = {start};
+        for (; record != start; record = parents[record])
+          cycle.push_back(record);
+        cycle.push_back(start);
+        std::reverse(cycle.begin(), cycle.end());
+        return cycle;
+      }
+      if (members.count(dep) && parents.emplace(dep, record).second)
+        queue.push_back(dep);
+    }
   }
-  path->pop_back();
-  return false;
+  NOTREACHED();
+  return {};
 }
 
 }  // namespace
@@ -219,32 +305,28 @@ bool Builder::CheckForBadItems(Err* err) const {
     }
   }
 
+  // Cycles are reported along with the missing dependencies so that all the
+  // problems of the graph show up at once.
+  std::vector<std::string> cycles = CheckForCircularDependencies(bad_records);
   if (!depstring.empty()) {
     *err = Err(Location(), "Unresolved dependencies.", depstring);
-    return false;
-  }
-
-  if (!bad_records.empty()) {
-    // Our logic above found a bad node but didn't identify the problem. This
-    // normally means a circular dependency.
-    depstring = CheckForCircularDependencies(bad_records);
-    if (depstring.empty()) {
-      // Something's very wrong, just dump out the bad nodes.
-      depstring =
-          "I have no idea what went wrong, but these are unresolved, "
-          "possibly due to an\ninternal error:";
-      for (auto* bad_record : bad_records) {
-        depstring +=
-            "\n\"" + bad_record->label().GetUserVisibleName(true) + "\"";
-      }
-      *err = Err(Location(), "", depstring);
-    } else {
-      *err = Err(Location(), "Dependency cycle:", depstring);
+  } else if (!cycles.empty()) {
+    *err = Err(Location(), "Dependency cycle:", cycles[0]);
+    cycles.erase(cycles.begin());
+  } else {
+    // Our logic above found a bad node but didn't identify the problem.
+    // Something's very wrong, just dump out the bad nodes.
+    depstring =
+        "I have no idea what went wrong, but these are unresolved, "
+        "possibly due to an\ninternal error:";
+    for (auto* bad_record : bad_records) {
+      depstring += "\n\"" + bad_record->label().GetUserVisibleName(true) + "\"";
     }
-    return false;
+    *err = Err(Location(), "", depstring);
   }
-
-  return true;
+  for (const std::string& cycle : cycles)
+    err->AppendSubErr(Err(Location(), "Dependency cycle:", cycle));
+  return false;
 }
 
 bool Builder::TargetDefined(BuilderRecord* record, Err* err) {
@@ -264,7 +346,9 @@ bool Builder::TargetDefined(BuilderRecord* record, Err* err) {
   // check if this target was previously marked as "required" and force setting
   // the bit again so the target's dependencies (which we now know) get the
   // required bit pushed to them.
-  if (record->should_generate() || target->ShouldGenerate())
+  if (record->should_generate() || target->ShouldGenerate() ||
+      (!extra_generated_labels_.empty() &&
+       extra_generated_labels_.count(record->label())))
     RecursiveSetShouldGenerate(record, true);
 
   return true;
@@ -517,10 +601,22 @@ bool Builder::ResolveItem(BuilderRecord* record, Err* err) {
       return false;
   }
 
+  // Only targets do enough work in OnResolved to be worth a round trip
+  // through the worker pool.
+  if (concurrent_resolution_ && record->type() == BuilderRecord::ITEM_TARGET) {
+    ScheduleOnResolved(record);
+    return true;
+  }
+
   record->set_resolved(true);
 
   if (!record->item()->OnResolved(err))
     return false;
+  return CompleteResolveItem(record, err);
+}
+
+bool Builder::CompleteResolveItem(BuilderRecord* record, Err* err) {
+  DCHECK(record->resolved());
   if (record->should_generate() && resolved_and_generated_callback_)
     resolved_and_generated_callback_(record);
 
@@ -537,6 +633,36 @@ bool Builder::ResolveItem(BuilderRecord* record, Err* err) {
   return true;
 }
 
+void Builder::ScheduleOnResolved(BuilderRecord* record) {
+  // Hold a work item until the result has been handled on the main thread.
+  // Otherwise the pool task finishing could look like the end of all work
+  // before dependents of this record have had a chance to resolve.
+  g_scheduler->IncrementWorkCount();
+  g_scheduler->ScheduleWork([this, record]() {
+    Err err;
+    bool success = record->item()->OnResolved(&err);
+    g_scheduler->task_runner()->PostTask([this, record, success, err]() {
+      DidRunOnResolved(record, success, err);
+      g_scheduler->DecrementWorkCount();
+    });
+  });
+}
+
+void Builder::DidRunOnResolved(BuilderRecord* record,
+                               bool success,
+                               const Err& on_resolved_err) {
+  if (!success) {
+    g_scheduler->FailWithError(on_resolved_err);
+    return;
+  }
+
+  record->set_resolved(true);
+
+  Err err;
+  if (!CompleteResolveItem(record, &err))
+    g_scheduler->FailWithError(err);
+}
+
 bool Builder::ResolveDeps(LabelTargetVector* deps, Err* err) {
   for (LabelTargetPair& cur : *deps) {
     DCHECK(!cur.ptr);
@@ -616,20 +742,20 @@ bool Builder::ResolvePools(Toolchain* toolchain, Err* err) {
   return true;
 }
 
-std::string Builder::CheckForCircularDependencies(
+std::vector<std::string> Builder::CheckForCircularDependencies(
     const std::vector<const BuilderRecord*>& bad_records) const {
-  std::vector<const BuilderRecord*> cycle;
-  if (!RecursiveFindCycle(bad_records[0], &cycle))
-    return std::string();  // Didn't find a cycle, something else is wrong.
-
-  std::string ret;
-  for (size_t i = 0; i < cycle.size(); i++) {
-    ret += "  " +
-           cycle[i]->label().GetUserVisibleName(loader_->GetDefaultToolchain());
-    if (i != cycle.size() - 1)
-      ret += " ->";
-    ret += "\n";
+  std::vector<std::string> result;
+  for (const auto& component : FindCycleComponents(bad_records)) {
+    std::vector<const BuilderRecord*> cycle = FindCycleInComponent(component);
+    std::string ret;
+    for (size_t i = 0; i < cycle.size(); i++) {
+      ret += "  " + cycle[i]->label().GetUserVisibleName(
+                        loader_->GetDefaultToolchain());
+      if (i != cycle.size() - 1)
+        ret += " ->";
+      ret += "\n";
+    }
+    result.push_back(std::move(ret));
   }
-
-  return ret;
+  return result;
 }
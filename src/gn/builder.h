@@ -7,7 +7,9 @@
 
 #include <functional>
 #include <memory>
+#include <set>
 #include <unordered_map>
+#include <utility>
 
 #include "gn/builder_record.h"
 #include "gn/builder_record_map.h"
@@ -22,6 +24,14 @@ class ParseNode;
 
 // The builder assembles the dependency tree. It is not threadsafe and runs on
 // the main thread only. See also BuilderRecord.
+//
+// When concurrent resolution is enabled, the expensive part of resolving a
+// target (Target::OnResolved) is run on the worker pool. All graph
+// bookkeeping stays on the main thread: a target's record is only marked
+// resolved, and its dependents only notified, once the result of OnResolved
+// has been posted back. Since a record's OnResolved is never started before
+// all of its dependencies have completed, each target is only ever touched by
+// one thread at a time.
 class Builder {
  public:
   using ResolvedGeneratedCallback = std::function<void(const BuilderRecord*)>;
@@ -38,6 +48,20 @@ class Builder {
 
   Loader* loader() const { return loader_; }
 
+  // Enables running Target::OnResolved on the worker pool (see above). This
+  // requires the scheduler's message loop to be running so that results can
+  // be posted back, and so is off by default.
+  bool concurrent_resolution() const { return concurrent_resolution_; }
+  void set_concurrent_resolution(bool c) { concurrent_resolution_ = c; }
+
+  // Targets with these labels are generated when defined, in addition to the
+  // ones for which Target::ShouldGenerate() is true. Incremental generation
+  // uses this for targets that are normally only generated because something
+  // in a file it doesn't load depends on them.
+  void set_extra_generated_labels(std::set<Label> labels) {
+    extra_generated_labels_ = std::move(labels);
+  }
+
   void ItemDefined(std::unique_ptr<Item> item);
 
   // Returns NULL if there is not a thing with the corresponding label.
@@ -122,6 +146,18 @@ class Builder {
   // target's Label*Vectors with the resolved pointers.
   bool ResolveItem(BuilderRecord* record, Err* err);
 
+  // Marks the record as resolved, issues the resolved callback if needed, and
+  // resolves any records that were only waiting on this one. Called after the
+  // item's OnResolved has run successfully.
+  bool CompleteResolveItem(BuilderRecord* record, Err* err);
+
+  // Runs the item's OnResolved on the worker pool and posts the result back
+  // to DidRunOnResolved on the main thread.
+  void ScheduleOnResolved(BuilderRecord* record);
+  void DidRunOnResolved(BuilderRecord* record,
+                        bool success,
+                        const Err& on_resolved_err);
+
   // Fills in the pointers in the given vector based on the labels. We assume
   // that everything should be resolved by this point, so will return an error
   // if anything isn't found or if the type doesn't match.
@@ -131,10 +167,10 @@ class Builder {
   bool ResolveToolchain(Target* target, Err* err);
   bool ResolvePools(Toolchain* toolchain, Err* err);
 
-  // Given a list of unresolved records, tries to find any circular
-  // dependencies and returns the string describing the problem. If no circular
-  // deps were found, returns the empty string.
-  std::string CheckForCircularDependencies(
+  // Given a list of unresolved records, finds the circular dependencies among
+  // them and returns a string describing each cycle, ordered by label. If no
+  // circular deps were found, returns an empty vector.
+  std::vector<std::string> CheckForCircularDependencies(
       const std::vector<const BuilderRecord*>& bad_records) const;
 
   // Non owning pointer.
@@ -144,6 +180,10 @@ class Builder {
 
   ResolvedGeneratedCallback resolved_and_generated_callback_;
 
+  bool concurrent_resolution_ = false;
+
+  std::set<Label> extra_generated_labels_;
+
   Builder(const Builder&) = delete;
   Builder& operator=(const Builder&) = delete;
 };
@@ -348,7 +348,88 @@ TEST_F(BuilderTest, GenDepsCircle) {
   EXPECT_TRUE(b_record->should_generate());
 }
 
+// Tests that every dependency cycle is reported along with the missing
+// dependencies.
+TEST_F(BuilderTest, ReportsAllCycles) {
+  DefineToolchain();
+  SourceDir toolchain_dir = settings_.toolchain_label().dir();
+  std::string toolchain_name = settings_.toolchain_label().name();
+
+  // A <-> B, C -> D -> E -> C, F -> A and G -> missing.
+  const char* const kDeps[][2] = {{"a", "b"}, {"b", "a"}, {"c", "d"},
+                                  {"d", "e"}, {"e", "c"}, {"f", "a"},
+                                  {"g", "missing"}};
+  for (const auto& dep : kDeps) {
+    Target* target = new Target(
+        &settings_, Label(SourceDir("//foo/"), dep[0], toolchain_dir,
+                          toolchain_name));
+    target->set_output_type(Target::EXECUTABLE);
+    target->private_deps().push_back(LabelTargetPair(Label(
+        SourceDir("//foo/"), dep[1], toolchain_dir, toolchain_name)));
+    builder_.ItemDefined(std::unique_ptr<Item>(target));
+  }
+
+  Err err;
+  EXPECT_FALSE(builder_.CheckForBadItems(&err));
+  EXPECT_EQ("Unresolved dependencies.", err.message());
+  EXPECT_EQ("//foo:g(//tc:default)\n  needs //foo:missing(//tc:default)\n",
+            err.help_text());
+  ASSERT_EQ(2u, err.sub_errs().size());
+  EXPECT_EQ("Dependency cycle:", err.sub_errs()[0].message());
+  EXPECT_EQ(
+      "  //foo:a(//tc:default) ->\n"
+      "  //foo:b(//tc:default) ->\n"
+      "  //foo:a(//tc:default)\n",
+      err.sub_errs()[0].help_text());
+  EXPECT_EQ(
+      "  //foo:c(//tc:default) ->\n"
+      "  //foo:d(//tc:default) ->\n"
+      "  //foo:e(//tc:default) ->\n"
+      "  //foo:c(//tc:default)\n",
+      err.sub_errs()[1].help_text());
+}
+
 // Tests that configs applied to a config get loaded (bug 536844).
+// Test that extra generated labels force targets outside the default
+// toolchain to be generated, along with their dependencies.
+TEST_F(BuilderTest, ExtraGeneratedLabels) {
+  DefineToolchain();
+
+  Settings settings2(&build_settings_, "secondary/");
+  Label toolchain_label2(SourceDir("//tc/"), "secondary");
+  settings2.set_toolchain_label(toolchain_label2);
+  Toolchain* tc2 = new Toolchain(&settings2, toolchain_label2);
+  TestWithScope::SetupToolchain(tc2);
+  builder_.ItemDefined(std::unique_ptr<Item>(tc2));
+
+  // A -> B, both in the secondary toolchain. Only A is forced.
+  Label a_label(SourceDir("//foo/"), "a", toolchain_label2.dir(),
+                toolchain_label2.name());
+  Label b_label(SourceDir("//foo/"), "b", toolchain_label2.dir(),
+                toolchain_label2.name());
+  Label c_label(SourceDir("//foo/"), "c", toolchain_label2.dir(),
+                toolchain_label2.name());
+  builder_.set_extra_generated_labels({a_label});
+
+  Target* a = new Target(&settings2, a_label);
+  a->public_deps().push_back(LabelTargetPair(b_label));
+  a->set_output_type(Target::EXECUTABLE);
+  builder_.ItemDefined(std::unique_ptr<Item>(a));
+
+  Target* b = new Target(&settings2, b_label);
+  b->visibility().SetPublic();
+  b->set_output_type(Target::STATIC_LIBRARY);
+  builder_.ItemDefined(std::unique_ptr<Item>(b));
+
+  Target* c = new Target(&settings2, c_label);
+  c->set_output_type(Target::EXECUTABLE);
+  builder_.ItemDefined(std::unique_ptr<Item>(c));
+
+  EXPECT_TRUE(builder_.GetRecord(a_label)->should_generate());
+  EXPECT_TRUE(builder_.GetRecord(b_label)->should_generate());
+  EXPECT_FALSE(builder_.GetRecord(c_label)->should_generate());
+}
+
 TEST_F(BuilderTest, ConfigLoad) {
   SourceDir toolchain_dir = settings_.toolchain_label().dir();
   std::string toolchain_name = settings_.toolchain_label().name();
@@ -369,4 +450,72 @@ TEST_F(BuilderTest, ConfigLoad) {
   EXPECT_TRUE(loader_->HasLoadedOne(SourceFile("//b/BUILD.gn")));
 }
 
+// Tests that targets resolve in dependency order when OnResolved runs on the
+// worker pool.
+TEST_F(BuilderTest, ConcurrentResolution) {
+  SourceDir toolchain_dir = settings_.toolchain_label().dir();
+  std::string toolchain_name = settings_.toolchain_label().name();
+
+  builder_.set_concurrent_resolution(true);
+  std::vector<Label> generated;
+  builder_.set_resolved_and_generated_callback(
+      [&generated](const BuilderRecord* record) {
+        if (record->type() == BuilderRecord::ITEM_TARGET)
+          generated.push_back(record->label());
+      });
+
+  // A -> B -> C, with C's public config expected to propagate up to A. The
+  // targets are defined in reverse dependency order so that A and B are
+  // defined while their dependencies are still being resolved.
+  Label a_label(SourceDir("//a/"), "a", toolchain_dir, toolchain_name);
+  Label b_label(SourceDir("//b/"), "b", toolchain_dir, toolchain_name);
+  Label c_label(SourceDir("//c/"), "c", toolchain_dir, toolchain_name);
+  Label config_label(SourceDir("//c/"), "pub", toolchain_dir, toolchain_name);
+
+  // Keep the scheduler from finishing while items are being defined.
+  scheduler().IncrementWorkCount();
+
+  DefineToolchain();
+
+  Config* config = new Config(&settings_, config_label);
+  config->visibility().SetPublic();
+  builder_.ItemDefined(std::unique_ptr<Item>(config));
+
+  Target* c = new Target(&settings_, c_label);
+  c->set_output_type(Target::STATIC_LIBRARY);
+  c->visibility().SetPublic();
+  c->public_configs().push_back(LabelConfigPair(config_label));
+  builder_.ItemDefined(std::unique_ptr<Item>(c));
+
+  Target* b = new Target(&settings_, b_label);
+  b->set_output_type(Target::STATIC_LIBRARY);
+  b->visibility().SetPublic();
+  b->public_deps().push_back(LabelTargetPair(c_label));
+  builder_.ItemDefined(std::unique_ptr<Item>(b));
+
+  Target* a = new Target(&settings_, a_label);
+  a->set_output_type(Target::EXECUTABLE);
+  a->private_deps().push_back(LabelTargetPair(b_label));
+  builder_.ItemDefined(std::unique_ptr<Item>(a));
+
+  // The targets can't be resolved until the main loop runs.
+  EXPECT_FALSE(builder_.GetRecord(a_label)->resolved());
+
+  scheduler().DecrementWorkCount();
+  EXPECT_TRUE(scheduler().Run());
+
+  EXPECT_TRUE(builder_.GetRecord(a_label)->resolved());
+  EXPECT_TRUE(builder_.GetRecord(b_label)->resolved());
+  EXPECT_TRUE(builder_.GetRecord(c_label)->resolved());
+
+  // Each target is reported only after its dependencies.
+  ASSERT_EQ(3u, generated.size());
+  EXPECT_EQ(c_label, generated[0]);
+  EXPECT_EQ(b_label, generated[1]);
+  EXPECT_EQ(a_label, generated[2]);
+
+  // The public config of C was pulled through B into A.
+  EXPECT_TRUE(a->configs().Contains(LabelConfigPair(config_label)));
+}
+
 }  // namespace gn_builder_unittest
@@ -118,10 +118,11 @@ int RunAnalyze(const std::vector<std::string>& args) {
     }
   }
 
-  // Deliberately leaked to avoid expensive process teardown.
-  Setup* setup = new Setup;
-  if (!setup->DoSetup(args[0], false) || !setup->Run())
-    return 1;
+  Setup* setup = GetSetupForQuery();
+  int exit_code;
+  if (!LoadSetupForQuery(setup, args[0], &exit_code,
+                         args[1] == "-" ? input : std::string_view()))
+    return exit_code;
 
   Err err;
   Analyzer analyzer(
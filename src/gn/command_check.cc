@@ -6,6 +6,7 @@
 
 #include "base/command_line.h"
 #include "base/strings/stringprintf.h"
+#include "gn/build_settings.h"
 #include "gn/commands.h"
 #include "gn/header_checker.h"
 #include "gn/setup.h"
@@ -272,8 +273,24 @@ bool CheckPublicHeaders(const BuildSettings* build_settings,
   scoped_refptr<HeaderChecker> header_checker(new HeaderChecker(
       build_settings, all_targets, check_generated, check_system));
 
+  base::FilePath cache_path;
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kCheckCache)) {
+    cache_path = build_settings->GetFullPath(build_settings->build_dir())
+                     .Append(FILE_PATH_LITERAL("gn_check_cache"));
+    header_checker->cache()->Load(cache_path);
+  }
+
   std::vector<Err> header_errors;
   header_checker->Run(to_check, force_check, &header_errors);
+
+  HeaderCheckCache* cache = header_checker->cache();
+  AddTraceCounter("check_cache.hits", cache->hits());
+  AddTraceCounter("check_cache.misses", cache->misses());
+  AddTraceCounter("check_cache.skipped_checks", cache->skipped_checks());
+  if (!cache_path.empty())
+    cache->Save(cache_path);
+
   for (size_t i = 0; i < header_errors.size(); i++) {
     if (i > 0)
       OutputString("___________________\n", DECORATION_YELLOW);
@@ -651,8 +651,7 @@ int RunDesc(const std::vector<std::string>& args) {
   }
   const base::CommandLine* cmdline = base::CommandLine::ForCurrentProcess();
 
-  // Deliberately leaked to avoid expensive process teardown.
-  Setup* setup = new Setup;
+  Setup* setup = GetSetupForQuery();
 
   bool json = cmdline->GetSwitchValueString("format") == "json";
   PrintCallbackHolder print_callback_holder;
@@ -663,10 +662,9 @@ int RunDesc(const std::vector<std::string>& args) {
                                         [](const std::string& str) {});
   }
 
-  if (!setup->DoSetup(args[0], false))
-    return 1;
-  if (!setup->Run())
-    return 1;
+  int exit_code;
+  if (!LoadSetupForQuery(setup, args[0], &exit_code))
+    return exit_code;
 
   // Resolve target(s) and config from inputs.
   UniqueVector<const Target*> target_matches;
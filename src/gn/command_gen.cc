@@ -4,7 +4,9 @@
 
 #include <inttypes.h>
 
+#include <memory>
 #include <mutex>
+#include <sstream>
 #include <thread>
 #include <unordered_map>
 
@@ -18,10 +20,14 @@
 #include "gn/compile_commands_writer.h"
 #include "gn/eclipse_writer.h"
 #include "gn/filesystem_utils.h"
+#include "gn/gen_snapshot.h"
 #include "gn/json_project_writer.h"
 #include "gn/label_pattern.h"
+#include "gn/ninja_build_writer.h"
 #include "gn/ninja_outputs_writer.h"
+#include "gn/ninja_shared_vars_writer.h"
 #include "gn/ninja_target_writer.h"
+#include "gn/ninja_toolchain_writer.h"
 #include "gn/ninja_tools.h"
 #include "gn/ninja_writer.h"
 #include "gn/qt_creator_writer.h"
@@ -55,12 +61,14 @@ const char kSwitchIdeValueWinSdk[] = "winsdk";
 const char kSwitchIdeValueXcode[] = "xcode";
 const char kSwitchIdeValueJson[] = "json";
 const char kSwitchIdeRootTarget[] = "ide-root-target";
+const char kSwitchIncremental[] = "incremental";
 const char kSwitchNinjaExecutable[] = "ninja-executable";
 const char kSwitchNinjaExtraArgs[] = "ninja-extra-args";
 const char kSwitchNinjaOutputsFile[] = "ninja-outputs-file";
 const char kSwitchNinjaOutputsScript[] = "ninja-outputs-script";
 const char kSwitchNinjaOutputsScriptArgs[] = "ninja-outputs-script-args";
 const char kSwitchNoDeps[] = "no-deps";
+const char kSwitchShareCompilerVars[] = "share-compiler-vars";
 const char kSwitchSln[] = "sln";
 const char kSwitchXcodeProject[] = "xcode-project";
 const char kSwitchXcodeBuildSystem[] = "xcode-build-system";
@@ -504,12 +512,209 @@ bool WriteIgnoreFile(Setup& setup, Err* err) {
   return WriteFile(output_path, "# Created by GN\n*\n", err);
 }
 
+// Creates and sets up the Setup used for generating the given directory.
+// Returns null on failure. Deliberately leaked to avoid expensive process
+// teardown.
+Setup* CreateGenSetup(const std::string& build_dir) {
+  Setup* setup = new Setup();
+  // Generate an empty args.gn file if it does not exists
+  if (!base::CommandLine::ForCurrentProcess()->HasSwitch(switches::kArgs)) {
+    setup->set_gen_empty_args(true);
+  }
+  if (!setup->DoSetup(build_dir, true))
+    return nullptr;
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch(
+          kSwitchShareCompilerVars)) {
+    setup->build_settings().set_ninja_shared_vars_writer(
+        std::make_unique<NinjaSharedVarsWriter>(&setup->build_settings()));
+  }
+  return setup;
+}
+
+// Sorts the targets in each toolchain according to their label. This makes
+// the ninja files have deterministic content.
+void SortRules(NinjaWriter::PerToolchainRules* rules) {
+  for (auto& cur_toolchain : *rules) {
+    std::sort(cur_toolchain.second.begin(), cur_toolchain.second.end(),
+              [](const NinjaWriter::TargetRulePair& a,
+                 const NinjaWriter::TargetRulePair& b) {
+                return a.first->label() < b.first->label();
+              });
+  }
+}
+
+base::FilePath GetBuildNinjaPath(const BuildSettings* build_settings) {
+  return build_settings->GetFullPath(
+      SourceFile(build_settings->build_dir().value() + "build.ninja"));
+}
+
+// Returns true if --incremental can be honored. The other outputs of gen
+// need the whole build graph, so an incremental run can't produce them.
+bool SupportsIncrementalGen(Setup& setup) {
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  return command_line->HasSwitch(kSwitchIncremental) &&
+         !command_line->HasSwitch(kSwitchCheck) &&
+         !command_line->HasSwitch(kSwitchIde) &&
+         !command_line->HasSwitch(kSwitchExportCompileCommands) &&
+         !command_line->HasSwitch(kSwitchExportRustProject) &&
+         !command_line->HasSwitch(kSwitchNinjaOutputsFile) &&
+         !command_line->HasSwitch(switches::kRuntimeDepsListFile) &&
+         setup.export_compile_commands().empty() &&
+         setup.build_settings().secondary_source_path().empty();
+}
+
+// Reads the snapshot left by the previous incremental run, along with the
+// build.ninja it describes. Returns null if there is no usable snapshot.
+std::unique_ptr<GenSnapshot> ReadGenSnapshot(
+    const BuildSettings* build_settings,
+    const std::string& invocation,
+    std::string* build_ninja) {
+  std::unique_ptr<GenSnapshot> snapshot =
+      GenSnapshot::Read(GenSnapshot::GetPath(build_settings));
+  if (!snapshot || snapshot->invocation() != invocation)
+    return nullptr;
+  if (!base::ReadFileToString(GetBuildNinjaPath(build_settings),
+                              build_ninja) ||
+      GenSnapshot::HashContents(*build_ninja) != snapshot->build_ninja_hash())
+    return nullptr;
+  return snapshot;
+}
+
+// Captures the state of a full generation for the next incremental run.
+bool WriteGenSnapshot(Setup* setup,
+                      const std::string& invocation,
+                      const NinjaWriter::PerToolchainRules& rules,
+                      Err* err) {
+  std::unique_ptr<GenSnapshot> snapshot = GenSnapshot::Capture(
+      invocation, setup->builder(), *setup->loader(), rules,
+      g_scheduler->GetGenDependencies(), nullptr, nullptr);
+  std::string build_ninja;
+  if (!snapshot ||
+      !base::ReadFileToString(GetBuildNinjaPath(&setup->build_settings()),
+                              &build_ninja)) {
+    return true;  // The next run will just be a full one.
+  }
+  snapshot->set_build_ninja_hash(GenSnapshot::HashContents(build_ninja));
+  if (!snapshot->Write(GenSnapshot::GetPath(&setup->build_settings()))) {
+    *err = Err(Location(), "Failed to write gn_gen_snapshot.");
+    return false;
+  }
+  return true;
+}
+
+enum class IncrementalGenResult {
+  kSucceeded,
+  kFailed,
+  kNeedsFullGen,
+};
+
+// Brings the build directory up to date by running only the build files
+// affected by changes since the generation described by |previous|.
+// |build_ninja| is the build.ninja written by that generation.
+IncrementalGenResult RunIncrementalGen(Setup* setup,
+                                       const GenSnapshot& previous,
+                                       const std::string& invocation,
+                                       const std::string& build_ninja,
+                                       const base::ElapsedTimer& timer) {
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  const BuildSettings* build_settings = &setup->build_settings();
+
+  GenSnapshot::Plan plan;
+  if (!previous.PlanIncrementalLoad(setup->loader(), &plan))
+    return IncrementalGenResult::kNeedsFullGen;
+
+  const GenSnapshot* snapshot = &previous;
+  std::unique_ptr<GenSnapshot> updated;
+  TargetWriteInfo write_info;
+  Err err;
+  if (!plan.up_to_date) {
+    setup->set_build_files_to_load(plan.build_files);
+    setup->builder().set_extra_generated_labels(plan.affected_generated);
+    setup->builder().set_resolved_and_generated_callback(
+        [&write_info](const BuilderRecord* record) {
+          ItemResolvedAndGeneratedCallback(&write_info, record);
+        });
+    if (!setup->Run())
+      return IncrementalGenResult::kFailed;
+
+    // Generated inputs are checked against the dependencies that were
+    // loaded, which is only a part of the graph here.
+    if (!g_scheduler->GetUnknownGeneratedInputs().empty())
+      return IncrementalGenResult::kNeedsFullGen;
+
+    SortRules(&write_info.rules);
+    updated = GenSnapshot::Capture(invocation, setup->builder(),
+                                   *setup->loader(), write_info.rules,
+                                   g_scheduler->GetGenDependencies(),
+                                   &previous, &plan);
+    if (!updated)
+      return IncrementalGenResult::kNeedsFullGen;
+    snapshot = updated.get();
+
+    // Each toolchain file lists all the generated targets of its toolchain,
+    // so rewrite the ones that had targets written.
+    for (const auto& pair : write_info.rules) {
+      const Toolchain* toolchain = pair.first;
+      if (!NinjaToolchainWriter::RunAndWriteFile(
+              setup->loader()->GetToolchainSettings(toolchain->label()),
+              toolchain, snapshot->GetToolchainRules(toolchain->label()))) {
+        Err(Location(), "Couldn't open toolchain buildfile(s) for writing")
+            .PrintToStdout();
+        return IncrementalGenResult::kFailed;
+      }
+    }
+  }
+
+  // build.ninja itself is unchanged, but it must be rewritten to be newer
+  // than the inputs, and the inputs may have changed.
+  std::stringstream depfile;
+  NinjaBuildWriter::WriteBuildInputs(build_settings, snapshot->GetInputPaths(),
+                                     depfile);
+  if (!NinjaBuildWriter::WriteFiles(build_settings, build_ninja, depfile.str(),
+                                    &err) ||
+      !RunNinjaPostProcessTools(
+          build_settings,
+          command_line->GetSwitchValuePath(switches::kNinjaExecutable),
+          command_line->HasSwitch(switches::kRegeneration),
+          command_line->HasSwitch(kSwitchCleanStale), &err) ||
+      !WriteIgnoreFile(*setup, &err)) {
+    err.PrintToStdout();
+    return IncrementalGenResult::kFailed;
+  }
+
+  if (!snapshot->Write(GenSnapshot::GetPath(build_settings))) {
+    Err(Location(), "Failed to write gn_gen_snapshot.").PrintToStdout();
+    return IncrementalGenResult::kFailed;
+  }
+
+  if (!command_line->HasSwitch(switches::kQuiet)) {
+    OutputString("Done. ", DECORATION_GREEN);
+
+    size_t targets_collected = 0;
+    for (const auto& rules : write_info.rules)
+      targets_collected += rules.second.size();
+
+    std::string stats =
+        "Made " + base::NumberToString(targets_collected) + " targets from " +
+        base::IntToString(
+            setup->scheduler().input_file_manager()->GetInputFileCount()) +
+        " files in " + base::Int64ToString(timer.Elapsed().InMilliseconds()) +
+        "ms (incremental)\n";
+    OutputString(stats);
+  }
+
+  write_info.LeakOnPurpose();
+  return IncrementalGenResult::kSucceeded;
+}
+
 }  // namespace
 
 const char kGen[] = "gen";
 const char kGen_HelpShort[] = "gen: Generate ninja files.";
 const char kGen_Help[] =
-    R"(gn gen [--check] [<ide options>] <out_dir>
+    R"(gn gen [--check] [--incremental] [<ide options>] <out_dir>
 
   Generates ninja files from the current tree and puts them in the given output
   directory.
@@ -540,6 +745,28 @@ General options
       option requires a ninja executable of at least version 1.10.0. It can be
       provided by the --ninja-executable switch. Also see "gn help clean_stale".
 
+  --incremental
+      Saves a snapshot of the generation in the build directory, and on later
+      runs with the same command line only re-executes the build files whose
+      inputs changed since then, along with those defining targets that depend
+      on them. Regenerations triggered by ninja keep the switch. Changes that
+      can't be handled this way, such as edits to the build config, args.gn or
+      toolchain definitions, or a change in the set of generated targets, fall
+      back to a full generation. The switch is ignored along with --check,
+      --ide, --export-compile-commands, --export-rust-project,
+      --ninja-outputs-file, --runtime-deps-list-file, the
+      "export_compile_commands" dotfile setting or a secondary source tree,
+      which all need the complete build graph.
+
+  --share-compiler-vars
+      Writes the compiler variables of C-family targets (defines, include_dirs,
+      cflags and so on) to files in the "ninja_vars" directory of the build
+      directory, named after a hash of their contents, and makes the ninja file
+      of each target include the one it needs. Targets with identical flags
+      share a file, which makes the ninja files smaller when many targets use
+      the same configs. Regenerations triggered by ninja keep the switch. Files
+      that no target uses anymore are deleted, except by incremental runs.
+
 IDE options
 
   GN optionally generates files for IDE. Files won't be overwritten if their
@@ -753,13 +980,8 @@ int RunGen(const std::vector<std::string>& args) {
     return 1;
   }
 
-  // Deliberately leaked to avoid expensive process teardown.
-  Setup* setup = new Setup();
-  // Generate an empty args.gn file if it does not exists
-  if (!base::CommandLine::ForCurrentProcess()->HasSwitch(switches::kArgs)) {
-    setup->set_gen_empty_args(true);
-  }
-  if (!setup->DoSetup(args[0], true))
+  Setup* setup = CreateGenSetup(args[0]);
+  if (!setup)
     return 1;
 
   const base::CommandLine* command_line =
@@ -770,6 +992,21 @@ int RunGen(const std::vector<std::string>& args) {
       setup->set_check_system_includes(true);
   }
 
+  // A snapshot only describes the build directory it was written with, so
+  // remove it before anything there changes. Incremental runs write it again
+  // once they're done.
+  bool incremental = SupportsIncrementalGen(*setup);
+  std::string invocation;
+  std::unique_ptr<GenSnapshot> previous;
+  std::string build_ninja;
+  if (incremental) {
+    invocation = GenSnapshot::GetInvocation(&setup->build_settings(),
+                                            setup->GetDotFileContents());
+    previous =
+        ReadGenSnapshot(&setup->build_settings(), invocation, &build_ninja);
+  }
+  base::DeleteFile(GenSnapshot::GetPath(&setup->build_settings()), false);
+
   // If this is a regeneration, replace existing build.ninja and build.ninja.d
   // with just enough for ninja to call GN and regenerate ninja files. This
   // removes any potential soon-to-be-dangling references and ensures that
@@ -780,6 +1017,26 @@ int RunGen(const std::vector<std::string>& args) {
     }
   }
 
+  if (previous) {
+    switch (RunIncrementalGen(setup, *previous, invocation, build_ninja,
+                              timer)) {
+      case IncrementalGenResult::kSucceeded:
+        return 0;
+      case IncrementalGenResult::kFailed:
+        return 1;
+      case IncrementalGenResult::kNeedsFullGen:
+        // The partial load can't be extended, so start over. The first
+        // Setup's scheduler must be gone, with its pool drained, before the
+        // next one becomes the global scheduler. Target files it wrote are
+        // all written again.
+        delete setup;
+        setup = CreateGenSetup(args[0]);
+        if (!setup)
+          return 1;
+        break;
+    }
+  }
+
   // Cause the load to also generate the ninja files for each target.
   TargetWriteInfo write_info;
   write_info.want_ninja_outputs =
@@ -799,15 +1056,7 @@ int RunGen(const std::vector<std::string>& args) {
                  base::Int64ToString(timer.Elapsed().InMilliseconds()) +
                  "ms\n");
 
-  // Sort the targets in each toolchain according to their label. This makes
-  // the ninja files have deterministic content.
-  for (auto& cur_toolchain : write_info.rules) {
-    std::sort(cur_toolchain.second.begin(), cur_toolchain.second.end(),
-              [](const NinjaWriter::TargetRulePair& a,
-                 const NinjaWriter::TargetRulePair& b) {
-                return a.first->label() < b.first->label();
-              });
-  }
+  SortRules(&write_info.rules);
 
   Err err;
   // Write the root ninja files.
@@ -816,6 +1065,8 @@ int RunGen(const std::vector<std::string>& args) {
     err.PrintToStdout();
     return 1;
   }
+  // Variable files that no target includes anymore would otherwise pile up.
+  NinjaSharedVarsWriter::DeleteUnusedFiles(&setup->build_settings());
 
   if (!RunNinjaPostProcessTools(
           &setup->build_settings(),
@@ -890,6 +1141,12 @@ int RunGen(const std::vector<std::string>& args) {
     return 1;
   }
 
+  if (incremental &&
+      !WriteGenSnapshot(setup, invocation, write_info.rules, &err)) {
+    err.PrintToStdout();
+    return 1;
+  }
+
   TickDelta elapsed_time = timer.Elapsed();
 
   if (!command_line->HasSwitch(switches::kQuiet)) {
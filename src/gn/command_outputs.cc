@@ -74,12 +74,10 @@ int RunOutputs(const std::vector<std::string>& args) {
     return 1;
   }
 
-  // Deliberately leaked to avoid expensive process teardown.
-  Setup* setup = new Setup;
-  if (!setup->DoSetup(args[0], false))
-    return 1;
-  if (!setup->Run())
-    return 1;
+  Setup* setup = GetSetupForQuery();
+  int exit_code;
+  if (!LoadSetupForQuery(setup, args[0], &exit_code))
+    return exit_code;
 
   std::vector<std::string> inputs(args.begin() + 1, args.end());
 
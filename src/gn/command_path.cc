@@ -317,12 +317,10 @@ int RunPath(const std::vector<std::string>& args) {
     return 1;
   }
 
-  // Deliberately leaked to avoid expensive process teardown.
-  Setup* setup = new Setup;
-  if (!setup->DoSetup(args[0], false))
-    return 1;
-  if (!setup->Run())
-    return 1;
+  Setup* setup = GetSetupForQuery();
+  int exit_code;
+  if (!LoadSetupForQuery(setup, args[0], &exit_code))
+    return exit_code;
 
   const Target* target1 = ResolveTargetFromCommandLineString(setup, args[1]);
   if (!target1)
@@ -351,10 +351,10 @@ int RunRefs(const std::vector<std::string>& args) {
   bool all = cmdline->HasSwitch("all");
   bool default_toolchain_only = cmdline->HasSwitch(switches::kDefaultToolchain);
 
-  // Deliberately leaked to avoid expensive process teardown.
-  Setup* setup = new Setup;
-  if (!setup->DoSetup(args[0], false) || !setup->Run())
-    return 1;
+  Setup* setup = GetSetupForQuery();
+  int exit_code;
+  if (!LoadSetupForQuery(setup, args[0], &exit_code))
+    return exit_code;
 
   // The inputs are everything but the first arg (which is the build dir).
   std::vector<std::string> inputs;
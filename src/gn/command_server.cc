@@ -0,0 +1,77 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/commands.h"
+#include "gn/err.h"
+#include "gn/input_file.h"
+#include "gn/query_server.h"
+
+namespace commands {
+
+const char kServer[] = "server";
+const char kServer_HelpShort[] =
+    "server: Keep the build graph loaded to answer queries quickly.";
+const char kServer_Help[] =
+    R"(gn server <out_dir>
+
+  Loads the build graph of the given build directory and keeps it in memory
+  until the process is killed. While the server is running, the "analyze",
+  "desc", "outputs", "path" and "refs" commands for that build directory are
+  run by the server instead of loading the graph again, which makes them
+  return much faster on large builds.
+
+  The server listens on the Unix domain socket "gn_server.sock" in the build
+  directory. Only one server can run per build directory. This command is not
+  supported on Windows.
+
+  Before running a command, the server checks whether any file that was read
+  while loading the graph (build files, imports, args.gn, the dotfile, files
+  read by exec_script or read_file, ...) changed, and loads the graph again
+  if so. Build files and imports that did not change are not parsed again.
+
+  Commands are run by the server with their own command line and working
+  directory, except that the server's --root and --dotfile are used. Commands
+  given a different --args, --root-target, --root-pattern or
+  --script-executable than the server's are run locally instead, as are
+  commands from a different version of GN.
+
+  Errors loading the graph are printed by the server and reported to the
+  commands it runs, until a change to the inputs fixes them.
+
+  Unlike other commands, the server reads large input files instead of
+  mapping them in memory, since a mapped file that is truncated while the
+  server runs would crash it.
+
+Example
+
+  gn server out/Default &
+  gn desc out/Default //base
+      Runs "desc" on the server started by the first command.
+)";
+
+int RunServer(const std::vector<std::string>& args) {
+  if (args.size() != 1) {
+    Err(Location(), "Need exactly one build directory.",
+        "Usage: \"gn server <out_dir>\"")
+        .PrintToStdout();
+    return 1;
+  }
+
+  // The files stay loaded for as long as the server runs.
+  InputFile::DisableMapping();
+
+  QueryServer server(args[0]);
+  Err err;
+  if (!server.Start(&err)) {
+    err.PrintToStdout();
+    return 1;
+  }
+  if (!server.Run(&err)) {
+    err.PrintToStdout();
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace commands
@@ -21,6 +21,7 @@
 #include "gn/label.h"
 #include "gn/label_pattern.h"
 #include "gn/ninja_build_writer.h"
+#include "gn/query_server.h"
 #include "gn/setup.h"
 #include "gn/standard_out.h"
 #include "gn/switches.h"
@@ -32,6 +33,9 @@ namespace commands {
 
 namespace {
 
+// See SetResidentSetupForQuery().
+Setup* g_resident_setup_for_query = nullptr;
+
 // Like above but the input string can be a pattern that matches multiple
 // targets. If the input does not parse as a pattern, prints and error and
 // returns false. If the pattern is valid, fills the vector (which might be
@@ -390,6 +394,7 @@ const CommandInfoMap& GetCommands() {
     INSERT_COMMAND(Outputs)
     INSERT_COMMAND(Path)
     INSERT_COMMAND(Refs)
+    INSERT_COMMAND(Server)
     INSERT_COMMAND(CleanStale)
 
 #undef INSERT_COMMAND
@@ -510,6 +515,33 @@ bool CommandSwitches::InitFrom(const base::CommandLine& cmdline) {
   return true;
 }
 
+Setup* GetSetupForQuery() {
+  if (g_resident_setup_for_query)
+    return g_resident_setup_for_query;
+  // Deliberately leaked to avoid expensive process teardown.
+  return new Setup;
+}
+
+bool LoadSetupForQuery(Setup* setup,
+                       const std::string& build_dir,
+                       int* exit_code,
+                       std::string_view stdin_contents) {
+  if (setup == g_resident_setup_for_query)
+    return true;
+
+  *exit_code = 1;
+  if (!setup->DoSetup(build_dir, false))
+    return false;
+  if (RunCommandOnQueryServer(&setup->build_settings(), stdin_contents,
+                              exit_code))
+    return false;
+  return setup->Run();
+}
+
+void SetResidentSetupForQuery(Setup* setup) {
+  g_resident_setup_for_query = setup;
+}
+
 bool PrepareForRegeneration(const BuildSettings* settings) {
   // Write a .d file for the build which references a nonexistent file.
   // This will make Ninja always mark the build as dirty.
@@ -98,6 +98,11 @@ extern const char kRefs_HelpShort[];
 extern const char kRefs_Help[];
 int RunRefs(const std::vector<std::string>& args);
 
+extern const char kServer[];
+extern const char kServer_HelpShort[];
+extern const char kServer_Help[];
+int RunServer(const std::vector<std::string>& args);
+
 extern const char kCleanStale[];
 extern const char kCleanStale_HelpShort[];
 extern const char kCleanStale_Help[];
@@ -208,11 +213,14 @@ class CommandSwitches {
   // the previous value.
   static CommandSwitches Set(CommandSwitches new_switches);
 
+  // Initialize this set from a given command line, for use with Set(). On
+  // success return true, on failure return false after printing an error
+  // message.
+  bool InitFrom(const base::CommandLine&);
+
  private:
   bool is_initialized() const { return initialized_; }
 
-  bool InitFrom(const base::CommandLine&);
-
   static CommandSwitches s_global_switches_;
 
   bool initialized_ = false;
@@ -250,6 +258,29 @@ class CommandSwitches {
 // On error, returns false.
 bool PrepareForRegeneration(const BuildSettings* settings);
 
+// Returns the Setup a command querying a build directory should load with
+// LoadSetupForQuery(). This is a new Setup, except inside "gn server" where
+// it's the one holding the server's build graph.
+Setup* GetSetupForQuery();
+
+// Loads the build graph of the given build directory into a Setup from
+// GetSetupForQuery(), unless it's already loaded.
+//
+// When "gn server" is running for the build directory, the current command is
+// run by the server instead and its output printed. The command should then
+// just return |*exit_code|, as it should on failure (with the error printed),
+// which is indicated by returning false. |stdin_contents| is what the command
+// already read from the standard input, if anything, which is passed on to the
+// server.
+bool LoadSetupForQuery(Setup* setup,
+                       const std::string& build_dir,
+                       int* exit_code,
+                       std::string_view stdin_contents = std::string_view());
+
+// Makes GetSetupForQuery() return the given Setup, which must have been run,
+// or a new one again when null. Used by "gn server".
+void SetResidentSetupForQuery(Setup* setup);
+
 // Given a setup that has already been run and some command-line input,
 // resolves that input as a target label and returns the corresponding target.
 // On failure, returns null and prints the error to the standard output.
@@ -0,0 +1,110 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/compressed_bit_set.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+CompressedBitSet::CompressedBitSet() = default;
+
+CompressedBitSet::~CompressedBitSet() = default;
+
+CompressedBitSet::CompressedBitSet(const CompressedBitSet&) = default;
+
+CompressedBitSet::CompressedBitSet(CompressedBitSet&&) noexcept = default;
+
+CompressedBitSet& CompressedBitSet::operator=(const CompressedBitSet&) =
+    default;
+
+CompressedBitSet& CompressedBitSet::operator=(CompressedBitSet&&) noexcept =
+    default;
+
+size_t CompressedBitSet::size() const {
+  size_t result = 0;
+  for (const Word& word : words_)
+    result += std::popcount(word.bits);
+  return result;
+}
+
+bool CompressedBitSet::contains(size_t value) const {
+  uint32_t index = static_cast<uint32_t>(value / 64);
+  auto found = std::lower_bound(
+      words_.begin(), words_.end(), index,
+      [](const Word& word, uint32_t index) { return word.index < index; });
+  return found != words_.end() && found->index == index &&
+         (found->bits & (uint64_t{1} << (value % 64)));
+}
+
+bool CompressedBitSet::insert(size_t value) {
+  DCHECK(value / 64 <= UINT32_MAX);
+  uint32_t index = static_cast<uint32_t>(value / 64);
+  uint64_t bit = uint64_t{1} << (value % 64);
+  auto found = words_.end();
+  if (words_.empty() || words_.back().index < index) {
+    words_.push_back({index, 0});
+    found = words_.end() - 1;
+  } else {
+    found = std::lower_bound(
+        words_.begin(), words_.end(), index,
+        [](const Word& word, uint32_t index) { return word.index < index; });
+    if (found->index != index)
+      found = words_.insert(found, {index, 0});
+  }
+  if (found->bits & bit)
+    return false;
+  found->bits |= bit;
+  return true;
+}
+
+void CompressedBitSet::insert(const CompressedBitSet& other) {
+  if (other.words_.empty())
+    return;
+  if (words_.empty()) {
+    words_ = other.words_;
+    return;
+  }
+
+  // Count the words first so that the result doesn't waste any capacity.
+  size_t count = 0;
+  auto a = words_.begin();
+  auto b = other.words_.begin();
+  while (a != words_.end() && b != other.words_.end()) {
+    count++;
+    uint32_t a_index = a->index;
+    uint32_t b_index = b->index;
+    if (a_index <= b_index)
+      ++a;
+    if (b_index <= a_index)
+      ++b;
+  }
+  count += (words_.end() - a) + (other.words_.end() - b);
+
+  std::vector<Word> merged;
+  merged.reserve(count);
+  a = words_.begin();
+  b = other.words_.begin();
+  while (a != words_.end() && b != other.words_.end()) {
+    if (a->index < b->index) {
+      merged.push_back(*a++);
+    } else if (b->index < a->index) {
+      merged.push_back(*b++);
+    } else {
+      merged.push_back({a->index, a->bits | b->bits});
+      ++a;
+      ++b;
+    }
+  }
+  merged.insert(merged.end(), a, words_.end());
+  merged.insert(merged.end(), b, other.words_.end());
+  words_ = std::move(merged);
+}
+
+bool CompressedBitSet::operator==(const CompressedBitSet& other) const {
+  return std::equal(words_.begin(), words_.end(), other.words_.begin(),
+                    other.words_.end(), [](const Word& a, const Word& b) {
+                      return a.index == b.index && a.bits == b.bits;
+                    });
+}
@@ -0,0 +1,71 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_COMPRESSED_BIT_SET_H_
+#define TOOLS_GN_COMPRESSED_BIT_SET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <bit>
+#include <vector>
+
+// A set of integers stored as the sorted list of its non-zero 64-bit words.
+// Sets of integers that are close to each other, such as the indices of the
+// targets found while walking a part of the dependency graph, only take a
+// few bits per integer, and the union of two sets is a linear merge.
+class CompressedBitSet {
+ public:
+  CompressedBitSet();
+  ~CompressedBitSet();
+
+  CompressedBitSet(const CompressedBitSet&);
+  CompressedBitSet(CompressedBitSet&&) noexcept;
+  CompressedBitSet& operator=(const CompressedBitSet&);
+  CompressedBitSet& operator=(CompressedBitSet&&) noexcept;
+
+  bool empty() const { return words_.empty(); }
+
+  // Number of integers in the set.
+  size_t size() const;
+
+  // Number of bytes used by the words of the set.
+  size_t memory_usage() const { return words_.capacity() * sizeof(Word); }
+
+  bool contains(size_t value) const;
+
+  // Adds |value| to the set. Returns true if it wasn't there. Adding values
+  // in increasing order is the fastest.
+  bool insert(size_t value);
+
+  // Adds all the integers of |other| to the set.
+  void insert(const CompressedBitSet& other);
+
+  // Calls |callback| with each integer of the set, in increasing order.
+  template <typename Callback>
+  void ForEach(Callback callback) const {
+    for (const Word& word : words_) {
+      for (uint64_t bits = word.bits; bits; bits &= bits - 1) {
+        callback(static_cast<size_t>(word.index) * 64 +
+                 std::countr_zero(bits));
+      }
+    }
+  }
+
+  bool operator==(const CompressedBitSet& other) const;
+  bool operator!=(const CompressedBitSet& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  struct Word {
+    // The word holds the integers from index * 64 to index * 64 + 63.
+    uint32_t index;
+    uint64_t bits;
+  };
+
+  std::vector<Word> words_;
+};
+
+#endif  // TOOLS_GN_COMPRESSED_BIT_SET_H_
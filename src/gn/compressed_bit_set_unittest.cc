@@ -0,0 +1,65 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/compressed_bit_set.h"
+
+#include <set>
+
+#include "util/test/test.h"
+
+namespace {
+
+std::vector<size_t> GetValues(const CompressedBitSet& set) {
+  std::vector<size_t> result;
+  set.ForEach([&result](size_t value) { result.push_back(value); });
+  return result;
+}
+
+}  // namespace
+
+TEST(CompressedBitSet, Insert) {
+  CompressedBitSet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_TRUE(set.insert(200));
+  EXPECT_TRUE(set.insert(3));
+  EXPECT_TRUE(set.insert(64));
+  EXPECT_TRUE(set.insert(5));
+  EXPECT_FALSE(set.insert(64));
+  EXPECT_FALSE(set.empty());
+  EXPECT_EQ(4u, set.size());
+
+  EXPECT_EQ((std::vector<size_t>{3, 5, 64, 200}), GetValues(set));
+  EXPECT_TRUE(set.contains(3));
+  EXPECT_TRUE(set.contains(200));
+  EXPECT_FALSE(set.contains(4));
+  EXPECT_FALSE(set.contains(128));
+  EXPECT_FALSE(set.contains(100000));
+}
+
+TEST(CompressedBitSet, Union) {
+  std::set<size_t> expected;
+  CompressedBitSet a;
+  CompressedBitSet b;
+  for (size_t i = 0; i < 1000; i += 7) {
+    a.insert(i);
+    expected.insert(i);
+  }
+  for (size_t i = 500; i < 3000; i += 11) {
+    b.insert(i);
+    expected.insert(i);
+  }
+
+  CompressedBitSet empty;
+  CompressedBitSet copy = a;
+  copy.insert(empty);
+  EXPECT_EQ(a, copy);
+  empty.insert(a);
+  EXPECT_EQ(a, empty);
+
+  a.insert(b);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(expected.size(), a.size());
+  EXPECT_EQ(std::vector<size_t>(expected.begin(), expected.end()),
+            GetValues(a));
+}
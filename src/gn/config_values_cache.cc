@@ -0,0 +1,89 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/config_values_cache.h"
+
+#include <functional>
+#include <set>
+#include <string>
+
+#include "gn/config.h"
+
+namespace {
+
+// Removes the values already seen earlier in the list.
+template <typename T>
+void RemoveDuplicates(std::vector<T>* values) {
+  std::set<T> seen;
+  std::erase_if(*values,
+                [&seen](const T& value) { return !seen.insert(value).second; });
+}
+
+using StringListGetter = std::vector<std::string>& (ConfigValues::*)();
+using DirListGetter = std::vector<SourceDir>& (ConfigValues::*)();
+
+const StringListGetter kStringLists[] = {
+    &ConfigValues::arflags,
+    &ConfigValues::asmflags,
+    &ConfigValues::cflags,
+    &ConfigValues::cflags_c,
+    &ConfigValues::cflags_cc,
+    &ConfigValues::cflags_objc,
+    &ConfigValues::cflags_objcc,
+    &ConfigValues::defines,
+    &ConfigValues::frameworks,
+    &ConfigValues::weak_frameworks,
+    &ConfigValues::ldflags,
+    &ConfigValues::rustflags,
+    &ConfigValues::rustenv,
+    &ConfigValues::swiftflags,
+};
+
+const DirListGetter kDirLists[] = {
+    &ConfigValues::framework_dirs,
+    &ConfigValues::include_dirs,
+    &ConfigValues::lib_dirs,
+};
+
+}  // namespace
+
+FlattenedConfigValues::FlattenedConfigValues(
+    const std::vector<const Config*>& configs) {
+  for (const Config* config : configs)
+    values_.AppendValues(config->resolved_values());
+
+  unique_values_.AppendValues(values_);
+  for (auto getter : kStringLists)
+    RemoveDuplicates(&(unique_values_.*getter)());
+  for (auto getter : kDirLists)
+    RemoveDuplicates(&(unique_values_.*getter)());
+}
+
+FlattenedConfigValues::~FlattenedConfigValues() = default;
+
+size_t ConfigValuesCache::ConfigListHash::operator()(
+    const std::vector<const Config*>& configs) const {
+  size_t hash = configs.size();
+  for (const Config* config : configs)
+    hash = hash * 31 + std::hash<const Config*>()(config);
+  return hash;
+}
+
+ConfigValuesCache::ConfigValuesCache() = default;
+
+ConfigValuesCache::~ConfigValuesCache() = default;
+
+const FlattenedConfigValues* ConfigValuesCache::Get(
+    const std::vector<const Config*>& configs) {
+  std::lock_guard<std::mutex> lock(lock_);
+  std::unique_ptr<FlattenedConfigValues>& flattened = flattened_[configs];
+  if (!flattened)
+    flattened = std::make_unique<FlattenedConfigValues>(configs);
+  return flattened.get();
+}
+
+size_t ConfigValuesCache::size() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return flattened_.size();
+}
@@ -0,0 +1,70 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_CONFIG_VALUES_CACHE_H_
+#define TOOLS_GN_CONFIG_VALUES_CACHE_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "gn/config_values.h"
+
+class Config;
+
+// The values of an ordered list of configs, appended once so that the targets
+// sharing the list don't walk the configs again for every value they write.
+class FlattenedConfigValues {
+ public:
+  explicit FlattenedConfigValues(const std::vector<const Config*>& configs);
+  ~FlattenedConfigValues();
+
+  // The resolved values of all the configs, in order.
+  const ConfigValues& values() const { return values_; }
+
+  // The same values with only the first occurrence of each string and
+  // directory kept, as written by kRecursiveWriterSkipDuplicates.
+  const ConfigValues& unique_values() const { return unique_values_; }
+
+ private:
+  ConfigValues values_;
+  ConfigValues unique_values_;
+
+  FlattenedConfigValues(const FlattenedConfigValues&) = delete;
+  FlattenedConfigValues& operator=(const FlattenedConfigValues&) = delete;
+};
+
+// Hash-conses the FlattenedConfigValues of the config lists of the targets of
+// a build. Thread-safe.
+class ConfigValuesCache {
+ public:
+  ConfigValuesCache();
+  ~ConfigValuesCache();
+
+  // Returns the flattened values of the given list of resolved configs. The
+  // result lives as long as the cache.
+  const FlattenedConfigValues* Get(const std::vector<const Config*>& configs);
+
+  // Number of distinct config lists flattened so far.
+  size_t size() const;
+
+ private:
+  struct ConfigListHash {
+    size_t operator()(const std::vector<const Config*>& configs) const;
+  };
+
+  mutable std::mutex lock_;
+  std::unordered_map<std::vector<const Config*>,
+                     std::unique_ptr<FlattenedConfigValues>,
+                     ConfigListHash>
+      flattened_;
+
+  ConfigValuesCache(const ConfigValuesCache&) = delete;
+  ConfigValuesCache& operator=(const ConfigValuesCache&) = delete;
+};
+
+#endif  // TOOLS_GN_CONFIG_VALUES_CACHE_H_
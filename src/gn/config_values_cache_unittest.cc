@@ -0,0 +1,44 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/config_values_cache.h"
+
+#include "gn/config.h"
+#include "gn/test_with_scope.h"
+#include "util/test/test.h"
+
+TEST(ConfigValuesCache, SharesFlattenedValues) {
+  TestWithScope setup;
+  Err err;
+
+  Config a(setup.settings(), Label(SourceDir("//foo/"), "a"));
+  a.own_values().cflags().push_back("-a");
+  a.own_values().cflags().push_back("-shared");
+  a.own_values().include_dirs().push_back(SourceDir("//shared/"));
+  ASSERT_TRUE(a.OnResolved(&err));
+
+  Config b(setup.settings(), Label(SourceDir("//foo/"), "b"));
+  b.own_values().cflags().push_back("-shared");
+  b.own_values().include_dirs().push_back(SourceDir("//b/"));
+  b.own_values().include_dirs().push_back(SourceDir("//shared/"));
+  ASSERT_TRUE(b.OnResolved(&err));
+
+  ConfigValuesCache cache;
+  const FlattenedConfigValues* ab = cache.Get({&a, &b});
+  EXPECT_EQ(ab, cache.Get({&a, &b}));
+  EXPECT_NE(ab, cache.Get({&b, &a}));
+  EXPECT_EQ(2u, cache.size());
+
+  // All the values are kept in order, and only the first occurrences are
+  // unique.
+  EXPECT_EQ((std::vector<std::string>{"-a", "-shared", "-shared"}),
+            ab->values().cflags());
+  EXPECT_EQ((std::vector<std::string>{"-a", "-shared"}),
+            ab->unique_values().cflags());
+  EXPECT_EQ((std::vector<SourceDir>{SourceDir("//shared/"), SourceDir("//b/"),
+                                    SourceDir("//shared/")}),
+            ab->values().include_dirs());
+  EXPECT_EQ((std::vector<SourceDir>{SourceDir("//shared/"), SourceDir("//b/")}),
+            ab->unique_values().include_dirs());
+}
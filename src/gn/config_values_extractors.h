@@ -8,11 +8,13 @@
 #include <stddef.h>
 
 #include <ostream>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "gn/config.h"
 #include "gn/config_values.h"
+#include "gn/config_values_cache.h"
 #include "gn/target.h"
 
 struct EscapeOptions;
@@ -81,6 +83,10 @@ enum RecursiveWriterConfig {
 // Writes a given config value that applies to a given target. This collects
 // all values from the target itself and all configs that apply, and writes
 // then in order.
+//
+// The values of the configs come from the flattened values the target shares
+// with the other targets having the same configs, so they aren't collected
+// again for each target.
 template <typename T, class Writer>
 inline void RecursiveTargetConfigToStream(
     RecursiveWriterConfig config,
@@ -88,21 +94,34 @@ inline void RecursiveTargetConfigToStream(
     const std::vector<T>& (ConfigValues::*getter)() const,
     const Writer& writer,
     std::ostream& out) {
-  std::set<T> seen;
-  for (ConfigValuesIterator iter(target); !iter.done(); iter.Next()) {
-    const std::vector<T>& values = ((iter.cur()).*getter)();
-    for (size_t i = 0; i < values.size(); i++) {
-      switch (config) {
-        case kRecursiveWriterKeepDuplicates:
-          writer(values[i], out);
-          break;
-
-        case kRecursiveWriterSkipDuplicates:
-          if (seen.find(values[i]) == seen.end()) {
-            seen.insert(values[i]);
-            writer(values[i], out);
-          }
+  const FlattenedConfigValues& flattened = target->flattened_config_values();
+  const std::vector<T>& own_values = (target->config_values().*getter)();
+  switch (config) {
+    case kRecursiveWriterKeepDuplicates:
+      for (const T& value : own_values)
+        writer(value, out);
+      for (const T& value : (flattened.values().*getter)())
+        writer(value, out);
+      break;
+
+    case kRecursiveWriterSkipDuplicates: {
+      const std::vector<T>& config_values =
+          (flattened.unique_values().*getter)();
+      if (own_values.empty()) {
+        for (const T& value : config_values)
+          writer(value, out);
+        break;
+      }
+      std::set<T> seen;
+      for (const T& value : own_values) {
+        if (seen.insert(value).second)
+          writer(value, out);
+      }
+      for (const T& value : config_values) {
+        if (seen.find(value) == seen.end())
+          writer(value, out);
       }
+      break;
     }
   }
 }
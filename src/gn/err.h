@@ -97,6 +97,7 @@ class Err {
   }
 
   void AppendSubErr(const Err& err);
+  const std::vector<Err>& sub_errs() const { return info_->sub_errs; }
 
   void PrintToStdout() const;
 
@@ -2,7 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "base/files/file_util.h"
+#include "base/files/file_path.h"
 #include "gn/err.h"
 #include "gn/filesystem_utils.h"
 #include "gn/functions.h"
@@ -64,15 +64,15 @@ Value RunReadFile(Scope* scope,
   // Ensure that everything is recomputed if the read file changes.
   g_scheduler->AddGenDependency(file_path);
 
-  // Read contents.
-  std::string file_contents;
-  if (!base::ReadFileToString(file_path, &file_contents)) {
+  // Read contents. Large files are mapped rather than copied.
+  InputFile file(source_file);
+  if (!file.Load(file_path)) {
     *err = Err(args[0], "Could not read file.",
                "I resolved this to \"" + FilePathToUTF8(file_path) + "\".");
     return Value();
   }
 
-  return ConvertInputToValue(scope->settings(), file_contents, function,
+  return ConvertInputToValue(scope->settings(), file.contents(), function,
                              args[1], err);
 }
 
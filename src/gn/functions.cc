@@ -1503,6 +1503,43 @@ const FunctionInfoMap& GetFunctions() {
   return function_info.map;
 }
 
+namespace {
+
+// Returns true if the result of the given built-in function only depends on
+// its arguments and on the build settings, and never on the toolchain. Imports
+// calling other functions can't be shared with other toolchains (see
+// ToolchainDependence).
+bool IsToolchainIndependentFunction(std::string_view name) {
+  static const char* const kFunctions[] = {
+      kAssert,
+      kDefined,
+      kExecScript,
+      kFilterExclude,
+      kFilterInclude,
+      kForEach,
+      kForwardVariablesFrom,
+      kGetEnv,
+      kImport,
+      kNotNeeded,
+      kPathExists,
+      kReadFile,
+      kRebasePath,
+      kSplitList,
+      kStringJoin,
+      kStringReplace,
+      kStringSplit,
+      kTemplate,
+      kWriteFile,
+  };
+  for (const char* function : kFunctions) {
+    if (name == function)
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
 Value RunFunction(Scope* scope,
                   const FunctionCallNode* function,
                   const ListNode* args_list,
@@ -1516,6 +1553,11 @@ Value RunFunction(Scope* scope,
     Value args = args_list->Execute(scope, err);
     if (err->has_error())
       return Value();
+    // Template invocations are rejected in imports, but the template's body
+    // looks names up in its closure, which tracking doesn't see, so never
+    // treat the result as toolchain-independent.
+    if (ToolchainDependence::IsTracking())
+      ToolchainDependence::Found();
     return templ->Invoke(scope, function, template_name, args.list_value(),
                          block, err);
   }
@@ -1529,6 +1571,10 @@ Value RunFunction(Scope* scope,
     return Value();
   }
 
+  if (ToolchainDependence::IsTracking() &&
+      !IsToolchainIndependentFunction(name.value()))
+    ToolchainDependence::Found();
+
   if (found_function->second.self_evaluating_args_runner) {
     // Self evaluating args functions are special weird built-ins like foreach.
     // Rather than force them all to check that they have a block or no block
@@ -0,0 +1,714 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/gen_snapshot.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/sha1.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/utf_string_conversions.h"
+#include "gn/build_settings.h"
+#include "gn/builder.h"
+#include "gn/filesystem_utils.h"
+#include "gn/input_file.h"
+#include "gn/input_file_manager.h"
+#include "gn/loader.h"
+#include "gn/ninja_build_writer.h"
+#include "gn/scheduler.h"
+#include "gn/settings.h"
+#include "gn/target.h"
+#include "last_commit_position.h"
+#include "util/atomic_write.h"
+#include "util/build_config.h"
+
+namespace {
+
+// Increment when changing the format below.
+constexpr uint32_t kGenSnapshotVersion = 1;
+
+constexpr char kMagic[4] = {'G', 'N', 'G', 'S'};
+
+// Item flags.
+constexpr uint8_t kItemIsRoot = 1 << 0;
+constexpr uint8_t kItemGenerated = 1 << 1;
+
+class Writer {
+ public:
+  explicit Writer(std::string* out) : out_(out) {}
+
+  void WriteU8(uint8_t value) { out_->push_back(static_cast<char>(value)); }
+
+  void WriteU32(uint32_t value) {
+    for (int i = 0; i < 4; i++)
+      out_->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+  }
+
+  void WriteString(std::string_view str) {
+    WriteU32(static_cast<uint32_t>(str.size()));
+    out_->append(str);
+  }
+
+ private:
+  std::string* out_;
+};
+
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  bool ReadU8(uint8_t* value) {
+    if (pos_ >= data_.size())
+      return false;
+    *value = static_cast<uint8_t>(data_[pos_++]);
+    return true;
+  }
+
+  bool ReadU32(uint32_t* value) {
+    if (data_.size() - pos_ < 4)
+      return false;
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+      *value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[pos_++]))
+                << (i * 8);
+    return true;
+  }
+
+  bool ReadString(std::string* str) {
+    uint32_t size;
+    if (!ReadU32(&size) || size > data_.size() - pos_)
+      return false;
+    str->assign(data_.substr(pos_, size));
+    pos_ += size;
+    return true;
+  }
+
+  bool ReadSourceFile(SourceFile* file) {
+    std::string value;
+    if (!ReadString(&value))
+      return false;
+    *file = value.empty() ? SourceFile() : SourceFile(std::move(value));
+    return true;
+  }
+
+  // Reads a count of things that each take at least |min_size| bytes,
+  // rejecting counts that can't possibly fit in the remaining data.
+  bool ReadCount(uint32_t* count, size_t min_size) {
+    return ReadU32(count) && *count <= (data_.size() - pos_) / min_size;
+  }
+
+  bool at_end() const { return pos_ == data_.size(); }
+
+ private:
+  std::string_view data_;
+  size_t pos_ = 0;
+};
+
+// Assigns indices to labels so that each label is only written once.
+class LabelTable {
+ public:
+  uint32_t Add(const Label& label) {
+    auto inserted = indices_.emplace(label, labels_.size());
+    if (inserted.second)
+      labels_.push_back(&inserted.first->first);
+    return inserted.first->second;
+  }
+
+  uint32_t Get(const Label& label) const { return indices_.at(label); }
+
+  void Write(Writer* writer) const {
+    writer->WriteU32(static_cast<uint32_t>(labels_.size()));
+    for (const Label* label : labels_) {
+      writer->WriteString(label->dir().value());
+      writer->WriteString(label->name());
+      writer->WriteString(label->toolchain_dir().value());
+      writer->WriteString(label->toolchain_name());
+    }
+  }
+
+ private:
+  std::map<Label, uint32_t> indices_;
+  std::vector<const Label*> labels_;
+};
+
+bool ReadLabelTable(Reader* reader, std::vector<Label>* labels) {
+  uint32_t count;
+  if (!reader->ReadCount(&count, 16))
+    return false;
+  labels->reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    std::string dir, name, toolchain_dir, toolchain_name;
+    if (!reader->ReadString(&dir) || !reader->ReadString(&name) ||
+        !reader->ReadString(&toolchain_dir) ||
+        !reader->ReadString(&toolchain_name) || dir.empty())
+      return false;
+    labels->emplace_back(SourceDir(dir), name,
+                         toolchain_dir.empty() ? SourceDir()
+                                               : SourceDir(toolchain_dir),
+                         toolchain_name);
+  }
+  return true;
+}
+
+bool ReadLabel(Reader* reader, const std::vector<Label>& labels, Label* out) {
+  uint32_t index;
+  if (!reader->ReadU32(&index) || index >= labels.size())
+    return false;
+  *out = labels[index];
+  return true;
+}
+
+// Returns a hash of everything build.ninja uses from the given target. See
+// NinjaBuildWriter.
+std::string GetTargetFingerprint(const Target* target) {
+  std::string data = base::IntToString(target->output_type());
+  data.push_back('\n');
+  if (target->output_type() == Target::CREATE_BUNDLE &&
+      target->bundle_data().is_application())
+    data.append("application\n");
+  data.append(target->pool().label.GetUserVisibleName(true));
+  data.push_back('\n');
+  for (const OutputFile& output : target->computed_outputs()) {
+    data.append(output.value());
+    data.push_back('\n');
+  }
+  if (target->has_dependency_output()) {
+    data.append("dependency_output=");
+    data.append(target->dependency_output().value());
+  }
+  return GenSnapshot::HashContents(data);
+}
+
+// Returns the item's snapshot record, or false if the record has no item.
+bool GetCurrentItem(const BuilderRecord* record,
+                    const Label& default_toolchain,
+                    const std::map<const Target*, const std::string*>& rules,
+                    GenSnapshot::Item* out) {
+  const Item* item = record->item();
+  if (!item)
+    return false;
+
+  out->type = record->type();
+  for (auto it = record->all_deps().begin(); it.valid(); ++it)
+    out->deps.push_back((*it)->label());
+  std::sort(out->deps.begin(), out->deps.end());
+
+  if (const Target* target = item->AsTarget()) {
+    out->is_root = target->ShouldGenerate();
+    auto found = rules.find(target);
+    if (found != rules.end()) {
+      out->fingerprint = GetTargetFingerprint(target);
+      out->rule = *found->second;
+    }
+  } else if (record->type() == BuilderRecord::ITEM_TOOLCHAIN) {
+    out->is_root = record->label() == default_toolchain;
+  }
+  out->generated = record->should_generate();
+  return true;
+}
+
+}  // namespace
+
+GenSnapshot::GenSnapshot() = default;
+
+GenSnapshot::~GenSnapshot() = default;
+
+// static
+base::FilePath GenSnapshot::GetPath(const BuildSettings* build_settings) {
+  return build_settings->GetFullPath(
+      SourceFile(build_settings->build_dir().value() + "gn_gen_snapshot"));
+}
+
+// static
+std::string GenSnapshot::GetInvocation(const BuildSettings* build_settings,
+                                       std::string_view dotfile_contents) {
+  base::CommandLine cmdline = GetSelfInvocationCommandLine(build_settings);
+  std::string result = LAST_COMMIT_POSITION;
+  result.push_back('\n');
+#if defined(OS_WIN)
+  result.append(base::UTF16ToUTF8(cmdline.GetCommandLineString()));
+#else
+  result.append(cmdline.GetCommandLineString());
+#endif
+  result.push_back('\n');
+  result.append(HashContents(dotfile_contents));
+  return result;
+}
+
+// static
+std::string GenSnapshot::HashContents(std::string_view contents) {
+  std::string hash(base::kSHA1Length, '\0');
+  base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(contents.data()),
+                      contents.size(),
+                      reinterpret_cast<unsigned char*>(hash.data()));
+  return hash;
+}
+
+void GenSnapshot::AddInput(const base::FilePath& path,
+                           const SourceFile& name,
+                           std::string hash) {
+  Input& input = inputs_[path];
+  input.name = name;
+  input.hash = std::move(hash);
+}
+
+void GenSnapshot::AddBuildFile(BuildFile build_file) {
+  build_files_.push_back(std::move(build_file));
+}
+
+void GenSnapshot::AddImport(const SourceFile& importer,
+                            const SourceFile& imported) {
+  imports_.emplace(importer, imported);
+}
+
+void GenSnapshot::AddItem(const Label& label, Item item) {
+  items_[label] = std::move(item);
+}
+
+bool GenSnapshot::PlanIncrementalLoad(const Loader* loader, Plan* plan) const {
+  // Find the inputs that changed. Anything that can't be read is treated as
+  // a change that needs a full generation, since a missing build file may or
+  // may not still be referenced.
+  std::vector<SourceFile> changed;
+  for (const auto& [path, input] : inputs_) {
+    std::string contents;
+    if (!base::ReadFileToString(path, &contents))
+      return false;
+    std::string hash = HashContents(contents);
+    if (hash == input.hash)
+      continue;
+    if (input.name.is_null())
+      return false;  // Not a build file or an import.
+    changed.push_back(input.name);
+    plan->changed_hashes[path] = std::move(hash);
+  }
+  if (changed.empty()) {
+    plan->up_to_date = true;
+    return true;
+  }
+
+  std::map<SourceFile, std::vector<size_t>> loaded_in;
+  for (size_t i = 0; i < build_files_.size(); i++)
+    loaded_in[build_files_[i].file].push_back(i);
+
+  std::map<SourceFile, std::vector<SourceFile>> importers;
+  for (const auto& [importer, imported] : imports_)
+    importers[imported].push_back(importer);
+
+  // Attribute each changed file to the build files that load or import it,
+  // directly or through other imports.
+  std::set<size_t> affected_files;
+  std::set<SourceFile> visited;
+  while (!changed.empty()) {
+    SourceFile file = std::move(changed.back());
+    changed.pop_back();
+    if (!visited.insert(file).second)
+      continue;
+
+    bool found = false;
+    auto found_loaded = loaded_in.find(file);
+    if (found_loaded != loaded_in.end()) {
+      affected_files.insert(found_loaded->second.begin(),
+                            found_loaded->second.end());
+      found = true;
+    }
+    auto found_importers = importers.find(file);
+    if (found_importers != importers.end()) {
+      changed.insert(changed.end(), found_importers->second.begin(),
+                     found_importers->second.end());
+      found = true;
+    }
+    if (!found)
+      return false;  // For example, the build config.
+  }
+
+  // Everything defined by those files is affected, and so is everything that
+  // depends on an affected item.
+  std::map<Label, size_t> defined_in;
+  for (size_t i = 0; i < build_files_.size(); i++) {
+    for (const Label& label : build_files_[i].items)
+      defined_in[label] = i;
+  }
+  std::map<Label, std::vector<Label>> dependents;
+  for (const auto& [label, item] : items_) {
+    for (const Label& dep : item.deps)
+      dependents[dep].push_back(label);
+  }
+
+  std::vector<Label> pending;
+  for (size_t i : affected_files) {
+    for (const Label& label : build_files_[i].items)
+      pending.push_back(label);
+  }
+  while (!pending.empty()) {
+    Label label = std::move(pending.back());
+    pending.pop_back();
+    if (!plan->affected.insert(label).second)
+      continue;
+
+    auto found_item = items_.find(label);
+    if (found_item == items_.end())
+      return false;
+    const Item& item = found_item->second;
+    if (item.type == BuilderRecord::ITEM_TOOLCHAIN ||
+        item.type == BuilderRecord::ITEM_POOL)
+      return false;  // These change how everything using them is written.
+    if (item.type == BuilderRecord::ITEM_TARGET && item.generated)
+      plan->affected_generated.insert(label);
+
+    auto found_file = defined_in.find(label);
+    if (found_file == defined_in.end())
+      return false;
+    affected_files.insert(found_file->second);
+
+    auto found_dependents = dependents.find(label);
+    if (found_dependents != dependents.end()) {
+      pending.insert(pending.end(), found_dependents->second.begin(),
+                     found_dependents->second.end());
+    }
+  }
+
+  // The first load must be in the default toolchain. Its toolchain definition
+  // is always loaded, so use that if nothing else qualifies.
+  plan->build_files.emplace_back(loader->BuildFileForLabel(default_toolchain_),
+                                 default_toolchain_);
+  bool have_default_file = false;
+  for (size_t i : affected_files) {
+    const BuildFile& build_file = build_files_[i];
+    if (build_file.toolchain == default_toolchain_ && !have_default_file) {
+      plan->build_files[0].first = build_file.file;
+      have_default_file = true;
+    } else {
+      plan->build_files.emplace_back(build_file.file, build_file.toolchain);
+    }
+  }
+  return true;
+}
+
+std::vector<NinjaWriter::TargetRulePair> GenSnapshot::GetToolchainRules(
+    const Label& toolchain) const {
+  std::vector<NinjaWriter::TargetRulePair> result;
+  for (const auto& [label, item] : items_) {
+    if (item.type == BuilderRecord::ITEM_TARGET && item.generated &&
+        label.GetToolchainLabel() == toolchain)
+      result.emplace_back(nullptr, item.rule);
+  }
+  return result;
+}
+
+std::vector<base::FilePath> GenSnapshot::GetInputPaths() const {
+  std::vector<base::FilePath> result;
+  result.reserve(inputs_.size());
+  for (const auto& pair : inputs_)
+    result.push_back(pair.first);
+  return result;
+}
+
+// static
+std::unique_ptr<GenSnapshot> GenSnapshot::Capture(
+    std::string invocation,
+    const Builder& builder,
+    const LoaderImpl& loader,
+    const NinjaWriter::PerToolchainRules& rules,
+    const std::vector<base::FilePath>& other_inputs,
+    const GenSnapshot* previous,
+    const Plan* plan) {
+  auto result = std::make_unique<GenSnapshot>();
+  result->invocation_ = std::move(invocation);
+  result->default_toolchain_ = loader.GetDefaultToolchain();
+
+  std::map<const Target*, const std::string*> written_rules;
+  for (const auto& pair : rules) {
+    for (const auto& target_rule : pair.second)
+      written_rules[target_rule.first] = &target_rule.second;
+  }
+
+  // Group the items of this run by the build file that defined them.
+  std::map<std::pair<SourceFile, Label>, BuildFile> loaded;
+  for (const auto& [file, toolchain] : loader.GetLoadedBuildFiles()) {
+    BuildFile& build_file = loaded[std::make_pair(file, toolchain)];
+    build_file.file = file;
+    build_file.toolchain = toolchain;
+  }
+  std::set<Label> written;
+  for (const BuilderRecord* record : builder.GetAllRecords()) {
+    Item item;
+    if (!GetCurrentItem(record, result->default_toolchain_, written_rules,
+                        &item))
+      continue;
+    if (!item.fingerprint.empty())
+      written.insert(record->label());
+
+    auto found = loaded.find(
+        std::make_pair(loader.BuildFileForLabel(record->label()),
+                       record->item()->settings()->toolchain_label()));
+    if (found == loaded.end())
+      return nullptr;  // Shouldn't happen: items come from loaded files.
+    found->second.items.push_back(record->label());
+    result->items_[record->label()] = std::move(item);
+  }
+
+  // Keep what the previous snapshot knows about files that weren't loaded.
+  if (previous) {
+    for (const BuildFile& build_file : previous->build_files_) {
+      if (loaded.count(std::make_pair(build_file.file, build_file.toolchain)))
+        continue;
+      for (const Label& label : build_file.items) {
+        auto found = previous->items_.find(label);
+        if (found != previous->items_.end())
+          result->items_.insert(*found);
+      }
+      result->build_files_.push_back(build_file);
+    }
+  }
+  for (auto& pair : loaded)
+    result->build_files_.push_back(std::move(pair.second));
+
+  if (previous) {
+    // Which targets are generated only depends on the roots and the
+    // dependencies, so it can be recomputed over the combined graph. Any
+    // change to the set of generated targets changes build.ninja.
+    std::set<Label> generated;
+    std::vector<Label> pending;
+    for (const auto& [label, item] : result->items_) {
+      if (item.is_root)
+        pending.push_back(label);
+    }
+    while (!pending.empty()) {
+      Label label = std::move(pending.back());
+      pending.pop_back();
+      if (!generated.insert(label).second)
+        continue;
+      auto found = result->items_.find(label);
+      if (found == result->items_.end())
+        return nullptr;  // Undefined dependency. A full run reports it.
+      pending.insert(pending.end(), found->second.deps.begin(),
+                     found->second.deps.end());
+    }
+
+    for (auto& [label, item] : result->items_) {
+      item.generated = generated.count(label) > 0;
+      auto found = previous->items_.find(label);
+      bool was_generated = found != previous->items_.end() &&
+                           found->second.generated &&
+                           found->second.type == item.type;
+      if (item.generated != was_generated)
+        return nullptr;
+      if (!item.generated || item.type != BuilderRecord::ITEM_TARGET)
+        continue;
+
+      if (written.count(label)) {
+        if (item.fingerprint != found->second.fingerprint)
+          return nullptr;  // build.ninja would change.
+      } else if (plan->affected_generated.count(label)) {
+        return nullptr;  // Should have been generated again.
+      } else {
+        item.fingerprint = found->second.fingerprint;
+        item.rule = found->second.rule;
+      }
+    }
+    for (const auto& [label, item] : previous->items_) {
+      if (item.generated && !result->items_.count(label))
+        return nullptr;
+    }
+
+    result->imports_ = previous->imports_;
+    result->inputs_ = previous->inputs_;
+    for (const auto& [path, hash] : plan->changed_hashes)
+      result->inputs_[path].hash = hash;
+  }
+
+  for (const auto& pair : loaded) {
+    const Settings* settings = loader.GetToolchainSettings(pair.first.second);
+    if (!settings)
+      continue;
+    for (const auto& [importer, imported] :
+         settings->import_manager().GetImportEdges())
+      result->imports_.emplace(importer, imported);
+  }
+
+  // Hash the contents that were actually used rather than rereading them, so
+  // that a file changing during the run is picked up by the next one.
+  for (const InputFile* file :
+       g_scheduler->input_file_manager()->GetLoadedPhysicalInputFiles()) {
+    result->AddInput(file->physical_name(), file->name(),
+                     HashContents(file->contents()));
+  }
+  for (const base::FilePath& path : other_inputs) {
+    std::string contents;
+    std::string hash;
+    if (base::ReadFileToString(path, &contents))
+      hash = HashContents(contents);
+    result->AddInput(path, SourceFile(), std::move(hash));
+  }
+
+  return result;
+}
+
+// static
+std::unique_ptr<GenSnapshot> GenSnapshot::Read(const base::FilePath& path) {
+  std::string data;
+  if (!base::ReadFileToString(path, &data))
+    return nullptr;
+  return Deserialize(data);
+}
+
+bool GenSnapshot::Write(const base::FilePath& path) const {
+  std::string data = Serialize();
+  return util::WriteFileAtomically(path, data.data(),
+                                   static_cast<int>(data.size())) ==
+         static_cast<int>(data.size());
+}
+
+std::string GenSnapshot::Serialize() const {
+  LabelTable labels;
+  labels.Add(default_toolchain_);
+  for (const BuildFile& build_file : build_files_) {
+    labels.Add(build_file.toolchain);
+    for (const Label& label : build_file.items)
+      labels.Add(label);
+  }
+  for (const auto& [label, item] : items_) {
+    labels.Add(label);
+    for (const Label& dep : item.deps)
+      labels.Add(dep);
+  }
+
+  std::string out;
+  Writer writer(&out);
+  out.append(kMagic, sizeof(kMagic));
+  writer.WriteU32(kGenSnapshotVersion);
+  writer.WriteString(invocation_);
+  writer.WriteString(build_ninja_hash_);
+
+  labels.Write(&writer);
+  writer.WriteU32(labels.Get(default_toolchain_));
+
+  writer.WriteU32(static_cast<uint32_t>(inputs_.size()));
+  for (const auto& [path, input] : inputs_) {
+    writer.WriteString(FilePathToUTF8(path));
+    writer.WriteString(input.name.value());
+    writer.WriteString(input.hash);
+  }
+
+  writer.WriteU32(static_cast<uint32_t>(build_files_.size()));
+  for (const BuildFile& build_file : build_files_) {
+    writer.WriteString(build_file.file.value());
+    writer.WriteU32(labels.Get(build_file.toolchain));
+    writer.WriteU32(static_cast<uint32_t>(build_file.items.size()));
+    for (const Label& label : build_file.items)
+      writer.WriteU32(labels.Get(label));
+  }
+
+  writer.WriteU32(static_cast<uint32_t>(imports_.size()));
+  for (const auto& [importer, imported] : imports_) {
+    writer.WriteString(importer.value());
+    writer.WriteString(imported.value());
+  }
+
+  writer.WriteU32(static_cast<uint32_t>(items_.size()));
+  for (const auto& [label, item] : items_) {
+    writer.WriteU32(labels.Get(label));
+    writer.WriteU8(static_cast<uint8_t>(item.type));
+    writer.WriteU8((item.is_root ? kItemIsRoot : 0) |
+                   (item.generated ? kItemGenerated : 0));
+    writer.WriteU32(static_cast<uint32_t>(item.deps.size()));
+    for (const Label& dep : item.deps)
+      writer.WriteU32(labels.Get(dep));
+    writer.WriteString(item.fingerprint);
+    writer.WriteString(item.rule);
+  }
+  return out;
+}
+
+// static
+std::unique_ptr<GenSnapshot> GenSnapshot::Deserialize(std::string_view data) {
+  if (data.size() < sizeof(kMagic) ||
+      data.substr(0, sizeof(kMagic)) !=
+          std::string_view(kMagic, sizeof(kMagic)))
+    return nullptr;
+  Reader reader(data.substr(sizeof(kMagic)));
+
+  uint32_t version;
+  if (!reader.ReadU32(&version) || version != kGenSnapshotVersion)
+    return nullptr;
+
+  auto result = std::make_unique<GenSnapshot>();
+  std::vector<Label> labels;
+  if (!reader.ReadString(&result->invocation_) ||
+      !reader.ReadString(&result->build_ninja_hash_) ||
+      !ReadLabelTable(&reader, &labels) ||
+      !ReadLabel(&reader, labels, &result->default_toolchain_))
+    return nullptr;
+
+  uint32_t count;
+  if (!reader.ReadCount(&count, 12))
+    return nullptr;
+  for (uint32_t i = 0; i < count; i++) {
+    std::string path;
+    Input input;
+    if (!reader.ReadString(&path) || !reader.ReadSourceFile(&input.name) ||
+        !reader.ReadString(&input.hash))
+      return nullptr;
+    result->inputs_[UTF8ToFilePath(path)] = std::move(input);
+  }
+
+  if (!reader.ReadCount(&count, 12))
+    return nullptr;
+  result->build_files_.resize(count);
+  for (BuildFile& build_file : result->build_files_) {
+    uint32_t item_count;
+    if (!reader.ReadSourceFile(&build_file.file) ||
+        !ReadLabel(&reader, labels, &build_file.toolchain) ||
+        !reader.ReadCount(&item_count, 4))
+      return nullptr;
+    build_file.items.resize(item_count);
+    for (Label& label : build_file.items) {
+      if (!ReadLabel(&reader, labels, &label))
+        return nullptr;
+    }
+  }
+
+  if (!reader.ReadCount(&count, 8))
+    return nullptr;
+  for (uint32_t i = 0; i < count; i++) {
+    SourceFile importer, imported;
+    if (!reader.ReadSourceFile(&importer) || !reader.ReadSourceFile(&imported))
+      return nullptr;
+    result->imports_.emplace(importer, imported);
+  }
+
+  if (!reader.ReadCount(&count, 18))
+    return nullptr;
+  for (uint32_t i = 0; i < count; i++) {
+    Label label;
+    Item item;
+    uint8_t type, flags;
+    uint32_t dep_count;
+    if (!ReadLabel(&reader, labels, &label) || !reader.ReadU8(&type) ||
+        type > BuilderRecord::ITEM_POOL || !reader.ReadU8(&flags) ||
+        !reader.ReadCount(&dep_count, 4))
+      return nullptr;
+    item.type = static_cast<BuilderRecord::ItemType>(type);
+    item.is_root = flags & kItemIsRoot;
+    item.generated = flags & kItemGenerated;
+    item.deps.resize(dep_count);
+    for (Label& dep : item.deps) {
+      if (!ReadLabel(&reader, labels, &dep))
+        return nullptr;
+    }
+    if (!reader.ReadString(&item.fingerprint) ||
+        !reader.ReadString(&item.rule))
+      return nullptr;
+    result->items_[label] = std::move(item);
+  }
+
+  if (!reader.at_end())
+    return nullptr;
+  return result;
+}
@@ -0,0 +1,196 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_GEN_SNAPSHOT_H_
+#define TOOLS_GN_GEN_SNAPSHOT_H_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "gn/builder_record.h"
+#include "gn/label.h"
+#include "gn/ninja_writer.h"
+#include "gn/source_file.h"
+
+class BuildSettings;
+class Builder;
+class Loader;
+class LoaderImpl;
+
+// Records what a "gn gen --incremental" run loaded and produced so that the
+// next run can re-execute only the build files whose inputs changed.
+//
+// The snapshot holds the content hash of every input file, the build files
+// loaded in each toolchain along with the items each one defined, which
+// files imported which, the dependencies of every item, and for generated
+// targets what went into the toolchain ninja files and build.ninja.
+//
+// A changed file only affects the build files that load or (transitively)
+// import it, and the items those define. Their dependents are affected too
+// since their resolved values may change. Changes that can't be attributed
+// to build files (the build config, the dotfile, args.gn, files used by
+// read_file or exec_script, ...) or that touch toolchains or pools make the
+// snapshot unusable, and callers do a full generation instead.
+class GenSnapshot {
+ public:
+  // A file that was read by the generation.
+  struct Input {
+    // Set for build files and imports. Null for other files.
+    SourceFile name;
+
+    // SHA-1 of the contents.
+    std::string hash;
+  };
+
+  // A build file loaded in one toolchain.
+  struct BuildFile {
+    SourceFile file;
+    Label toolchain;
+
+    // Items defined by running the file.
+    std::vector<Label> items;
+  };
+
+  struct Item {
+    BuilderRecord::ItemType type = BuilderRecord::ITEM_UNKNOWN;
+
+    // Set for items that are generated regardless of what depends on them:
+    // targets for which Target::ShouldGenerate() is true, and the default
+    // toolchain.
+    bool is_root = false;
+
+    bool generated = false;
+
+    // Everything the item depends on. See BuilderRecord::all_deps().
+    std::vector<Label> deps;
+
+    // For generated targets, a hash of what build.ninja uses from the target,
+    // and the rule added to the toolchain's ninja file.
+    std::string fingerprint;
+    std::string rule;
+  };
+
+  // What an incremental run needs to do, from PlanIncrementalLoad().
+  struct Plan {
+    // Set when no input changed. Nothing needs to be loaded.
+    bool up_to_date = false;
+
+    // Build files to load and the toolchain to load each in. The first one
+    // belongs to the default toolchain.
+    std::vector<std::pair<SourceFile, Label>> build_files;
+
+    // Items whose definition or resolved values may have changed.
+    std::set<Label> affected;
+
+    // Generated targets in |affected|. These must be generated again.
+    std::set<Label> affected_generated;
+
+    // Current hashes of the inputs that changed.
+    std::map<base::FilePath, std::string> changed_hashes;
+  };
+
+  GenSnapshot();
+  ~GenSnapshot();
+
+  // Returns where the snapshot is kept in the build directory.
+  static base::FilePath GetPath(const BuildSettings* build_settings);
+
+  // Returns a string identifying the version of GN, the normalized command
+  // line and the contents of the dotfile. A snapshot is only used by a run
+  // with the same invocation, since build.ninja depends on the command line
+  // (see GetSelfInvocationCommandLine()) and the dotfile isn't a build input.
+  static std::string GetInvocation(const BuildSettings* build_settings,
+                                   std::string_view dotfile_contents);
+
+  const std::string& invocation() const { return invocation_; }
+  const Label& default_toolchain() const { return default_toolchain_; }
+  const std::map<base::FilePath, Input>& inputs() const { return inputs_; }
+  const std::vector<BuildFile>& build_files() const { return build_files_; }
+  const std::map<Label, Item>& items() const { return items_; }
+
+  // SHA-1 of the build.ninja file written for this snapshot.
+  const std::string& build_ninja_hash() const { return build_ninja_hash_; }
+  void set_build_ninja_hash(std::string hash) {
+    build_ninja_hash_ = std::move(hash);
+  }
+
+  // Works out what needs to be loaded to bring the generated files up to date
+  // with the current inputs. Returns false if that can't be determined, in
+  // which case a full generation is needed.
+  bool PlanIncrementalLoad(const Loader* loader, Plan* plan) const;
+
+  // Returns the rules of all generated targets in the given toolchain, sorted
+  // by label like a full generation does. The target pointers are null.
+  std::vector<NinjaWriter::TargetRulePair> GetToolchainRules(
+      const Label& toolchain) const;
+
+  // Returns the paths of all inputs, sorted.
+  std::vector<base::FilePath> GetInputPaths() const;
+
+  // Collects the state of a finished generation. |rules| are the rules
+  // written by the run, and |other_inputs| are files read by the generation
+  // besides the ones loaded by the input file manager (see
+  // Scheduler::GetGenDependencies()).
+  //
+  // For an incremental run, |previous| and |plan| must be the snapshot and
+  // plan the run was started from, and the result combines both. In that case
+  // this returns null if the results can't be combined, for example because
+  // the set of generated targets changed, and a full generation is needed.
+  static std::unique_ptr<GenSnapshot> Capture(
+      std::string invocation,
+      const Builder& builder,
+      const LoaderImpl& loader,
+      const NinjaWriter::PerToolchainRules& rules,
+      const std::vector<base::FilePath>& other_inputs,
+      const GenSnapshot* previous,
+      const Plan* plan);
+
+  // Returns a hash of the given contents in the format used for inputs.
+  static std::string HashContents(std::string_view contents);
+
+  // Reads and writes the snapshot. Read returns null if the file is missing,
+  // malformed, or was written by another version of GN.
+  static std::unique_ptr<GenSnapshot> Read(const base::FilePath& path);
+  bool Write(const base::FilePath& path) const;
+
+  // Converts to and from the on-disk format. Exposed for testing.
+  std::string Serialize() const;
+  static std::unique_ptr<GenSnapshot> Deserialize(std::string_view data);
+
+  // For building snapshots in tests.
+  void set_invocation(std::string invocation) {
+    invocation_ = std::move(invocation);
+  }
+  void set_default_toolchain(const Label& label) { default_toolchain_ = label; }
+  void AddInput(const base::FilePath& path,
+                const SourceFile& name,
+                std::string hash);
+  void AddBuildFile(BuildFile build_file);
+  void AddImport(const SourceFile& importer, const SourceFile& imported);
+  void AddItem(const Label& label, Item item);
+
+ private:
+  std::string invocation_;
+  Label default_toolchain_;
+  std::string build_ninja_hash_;
+
+  std::map<base::FilePath, Input> inputs_;
+  std::vector<BuildFile> build_files_;
+
+  // (importing file, imported file) pairs.
+  std::set<std::pair<SourceFile, SourceFile>> imports_;
+
+  std::map<Label, Item> items_;
+
+  GenSnapshot(const GenSnapshot&) = delete;
+  GenSnapshot& operator=(const GenSnapshot&) = delete;
+};
+
+#endif  // TOOLS_GN_GEN_SNAPSHOT_H_
@@ -0,0 +1,180 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/gen_snapshot.h"
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "gn/build_settings.h"
+#include "gn/loader.h"
+#include "util/test/test.h"
+
+namespace {
+
+const char kDefaultToolchain[] = "//tc:default";
+
+Label MakeLabel(const std::string& dir, const std::string& name) {
+  return Label(SourceDir(dir), name, SourceDir("//tc/"), "default");
+}
+
+GenSnapshot::Item MakeItem(BuilderRecord::ItemType type,
+                           bool is_root,
+                           std::vector<Label> deps) {
+  GenSnapshot::Item item;
+  item.type = type;
+  item.is_root = is_root;
+  item.generated = true;
+  item.deps = std::move(deps);
+  if (type == BuilderRecord::ITEM_TARGET) {
+    item.fingerprint = "fingerprint";
+    item.rule = "subninja obj/foo.ninja\n";
+  }
+  return item;
+}
+
+// A build in a temporary directory:
+//   //:root depends on //a:a, which depends on //b:b.
+//   //b/BUILD.gn imports //b/b.gni.
+//   //tc/BUILD.gn defines the default toolchain.
+//   //build/config.gn is the build config.
+class GenSnapshotTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    build_settings_.SetRootPath(temp_dir_.GetPath());
+    loader_ = new LoaderImpl(&build_settings_);
+
+    const Label toolchain = Label(SourceDir("//tc/"), "default");
+    const Label root = MakeLabel("//", "root");
+    const Label a = MakeLabel("//a/", "a");
+    const Label b = MakeLabel("//b/", "b");
+
+    snapshot_.set_invocation("invocation");
+    snapshot_.set_default_toolchain(toolchain);
+    AddFile("//BUILD.gn", "group(\"root\") {}\n");
+    AddFile("//a/BUILD.gn", "group(\"a\") {}\n");
+    AddFile("//b/BUILD.gn", "import(\"b.gni\")\n");
+    AddFile("//b/b.gni", "b = 1\n");
+    AddFile("//tc/BUILD.gn", "toolchain(\"default\") {}\n");
+    AddFile("//build/config.gn", "set_default_toolchain(\"//tc:default\")\n");
+
+    snapshot_.AddBuildFile({SourceFile("//BUILD.gn"), toolchain, {root}});
+    snapshot_.AddBuildFile({SourceFile("//a/BUILD.gn"), toolchain, {a}});
+    snapshot_.AddBuildFile({SourceFile("//b/BUILD.gn"), toolchain, {b}});
+    snapshot_.AddBuildFile(
+        {SourceFile("//tc/BUILD.gn"), toolchain, {toolchain}});
+    snapshot_.AddImport(SourceFile("//b/BUILD.gn"), SourceFile("//b/b.gni"));
+
+    snapshot_.AddItem(root, MakeItem(BuilderRecord::ITEM_TARGET, true, {a}));
+    snapshot_.AddItem(a, MakeItem(BuilderRecord::ITEM_TARGET, true, {b}));
+    snapshot_.AddItem(b, MakeItem(BuilderRecord::ITEM_TARGET, true, {}));
+    snapshot_.AddItem(toolchain,
+                      MakeItem(BuilderRecord::ITEM_TOOLCHAIN, true, {}));
+  }
+
+  base::FilePath GetPath(const std::string& name) {
+    return build_settings_.GetFullPath(SourceFile(name));
+  }
+
+  void WriteContents(const std::string& name, const std::string& contents) {
+    base::FilePath path = GetPath(name);
+    ASSERT_TRUE(base::CreateDirectory(path.DirName()));
+    ASSERT_EQ(static_cast<int>(contents.size()),
+              base::WriteFile(path, contents.data(),
+                              static_cast<int>(contents.size())));
+  }
+
+  void AddFile(const std::string& name, const std::string& contents) {
+    WriteContents(name, contents);
+    snapshot_.AddInput(GetPath(name), SourceFile(name),
+                       GenSnapshot::HashContents(contents));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  BuildSettings build_settings_;
+  scoped_refptr<LoaderImpl> loader_;
+  GenSnapshot snapshot_;
+};
+
+}  // namespace
+
+TEST_F(GenSnapshotTest, RoundTrip) {
+  snapshot_.set_build_ninja_hash(GenSnapshot::HashContents("build.ninja"));
+  std::string data = snapshot_.Serialize();
+
+  std::unique_ptr<GenSnapshot> loaded = GenSnapshot::Deserialize(data);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(data, loaded->Serialize());
+  EXPECT_EQ("invocation", loaded->invocation());
+  EXPECT_EQ(kDefaultToolchain,
+            loaded->default_toolchain().GetUserVisibleName(false));
+  EXPECT_EQ(6u, loaded->inputs().size());
+  EXPECT_EQ(4u, loaded->build_files().size());
+  EXPECT_EQ(4u, loaded->items().size());
+
+  // Every truncation must be detected, as well as trailing garbage.
+  for (size_t i = 0; i < data.size(); i++)
+    EXPECT_FALSE(GenSnapshot::Deserialize(data.substr(0, i)));
+  EXPECT_FALSE(GenSnapshot::Deserialize(data + "x"));
+}
+
+TEST_F(GenSnapshotTest, UpToDate) {
+  GenSnapshot::Plan plan;
+  ASSERT_TRUE(snapshot_.PlanIncrementalLoad(loader_.get(), &plan));
+  EXPECT_TRUE(plan.up_to_date);
+  EXPECT_TRUE(plan.build_files.empty());
+}
+
+TEST_F(GenSnapshotTest, ChangedImport) {
+  WriteContents("//b/b.gni", "b = 2\n");
+
+  GenSnapshot::Plan plan;
+  ASSERT_TRUE(snapshot_.PlanIncrementalLoad(loader_.get(), &plan));
+  EXPECT_FALSE(plan.up_to_date);
+  EXPECT_EQ(1u, plan.changed_hashes.count(GetPath("//b/b.gni")));
+
+  // //b:b and everything depending on it is affected.
+  EXPECT_EQ(3u, plan.affected.size());
+  EXPECT_EQ(3u, plan.affected_generated.size());
+  EXPECT_EQ(1u, plan.affected.count(MakeLabel("//", "root")));
+
+  // The toolchain file isn't loaded, since a build file in the default
+  // toolchain is.
+  ASSERT_EQ(3u, plan.build_files.size());
+  for (const auto& [file, toolchain] : plan.build_files) {
+    EXPECT_NE("//tc/BUILD.gn", file.value());
+    EXPECT_EQ(kDefaultToolchain, toolchain.GetUserVisibleName(false));
+  }
+}
+
+TEST_F(GenSnapshotTest, ChangedBuildFile) {
+  WriteContents("//a/BUILD.gn", "group(\"a\") { deps = [] }\n");
+
+  GenSnapshot::Plan plan;
+  ASSERT_TRUE(snapshot_.PlanIncrementalLoad(loader_.get(), &plan));
+  EXPECT_EQ(2u, plan.affected.size());
+  EXPECT_EQ(0u, plan.affected.count(MakeLabel("//b/", "b")));
+  EXPECT_EQ(2u, plan.build_files.size());
+}
+
+TEST_F(GenSnapshotTest, NeedsFullGen) {
+  GenSnapshot::Plan plan;
+
+  // The build config isn't attributable to any build file.
+  WriteContents("//build/config.gn", "# Changed.\n");
+  EXPECT_FALSE(snapshot_.PlanIncrementalLoad(loader_.get(), &plan));
+  WriteContents("//build/config.gn",
+                "set_default_toolchain(\"//tc:default\")\n");
+
+  // Toolchains affect everything using them.
+  plan = GenSnapshot::Plan();
+  WriteContents("//tc/BUILD.gn", "toolchain(\"default\") { }\n");
+  EXPECT_FALSE(snapshot_.PlanIncrementalLoad(loader_.get(), &plan));
+  WriteContents("//tc/BUILD.gn", "toolchain(\"default\") {}\n");
+
+  // A deleted input may or may not still be referenced.
+  plan = GenSnapshot::Plan();
+  ASSERT_TRUE(base::DeleteFile(GetPath("//b/b.gni"), false));
+  EXPECT_FALSE(snapshot_.PlanIncrementalLoad(loader_.get(), &plan));
+}
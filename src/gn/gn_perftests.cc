@@ -0,0 +1,467 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures "gn gen" on a synthetic build, phase by phase.
+//
+// Usage: gn_perftests [--targets=N] [--fan-out=N] [--template-depth=N]
+//                     [--list-appends=N] [--statements=N] [--configs=N]
+//                     [--toolchains=N] [--runs=N] [--source-dir=<dir>]
+//                     [--threads=N]
+//        gn_perftests --tokenize=<dir> [--runs=N]
+//        gn_perftests --generated-inputs=N [--runs=N]
+//        gn_perftests --string-atoms=N [--threads=N] [--runs=N]
+//        gn_perftests --hard-deps=N [--runs=N]
+//
+// The build is written to a temporary directory, or to --source-dir which is
+// then kept. The time of each phase is summed over all threads from the
+// traces GN records, and the median over the runs is printed. The peak
+// resident memory of the process is printed as of the end of the first run,
+// since "gn gen" leaks its build graph on purpose.
+//
+// Traces measure wall time, so phases only add up when the worker threads
+// don't compete for cores. Hence a single worker thread is used unless
+// --threads says otherwise.
+//
+// With --tokenize, every .gn and .gni file under the given directory, such as
+// a real checkout, is tokenized instead, and the throughput is printed.
+//
+// With --generated-inputs, the scheduler is given N generated files and N
+// inputs in the build directory that no dependency generates, half of which
+// are written by write_file, and the lookups "gn gen" makes for them to check
+// for invalid generated inputs are timed.
+//
+// With --string-atoms, each of --threads threads (4 by default) interns the
+// same N new strings in every run, as workers do with labels and paths.
+//
+// With --hard-deps, the hard deps of every target of a graph of N targets are
+// computed. The graph is made of chains of 1000 groups, every fifth one also
+// depending on an action, so that the hard deps of the groups grow along the
+// chains.
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/command_line.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "gn/commands.h"
+#include "gn/err.h"
+#include "gn/filesystem_utils.h"
+#include "gn/input_file.h"
+#include "gn/resolved_target_data.h"
+#include "gn/scheduler.h"
+#include "gn/settings.h"
+#include "gn/standard_out.h"
+#include "gn/string_atom.h"
+#include "gn/switches.h"
+#include "gn/synthetic_build.h"
+#include "gn/target.h"
+#include "gn/tokenizer.h"
+#include "gn/trace.h"
+#include "util/build_config.h"
+#include "util/msg_loop.h"
+#include "util/ticks.h"
+
+#if defined(OS_POSIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Phase {
+  const char* name;
+
+  // Traces whose durations are added, and subtracted.
+  TraceItem::Type type;
+  bool has_nested = false;
+  TraceItem::Type nested = TraceItem::TRACE_SETUP;
+};
+
+// Tokenizing happens while parsing, so it is taken out of the parse time.
+// Template invocations are part of the execution time and nest, so time spent
+// in a template invoked by another counts once per level.
+const Phase kPhases[] = {
+    {"load", TraceItem::TRACE_FILE_LOAD},
+    {"tokenize", TraceItem::TRACE_FILE_TOKENIZE},
+    {"parse", TraceItem::TRACE_FILE_PARSE, true,
+     TraceItem::TRACE_FILE_TOKENIZE},
+    {"execute", TraceItem::TRACE_FILE_EXECUTE},
+    {"template", TraceItem::TRACE_FILE_EXECUTE_TEMPLATE},
+    {"resolve", TraceItem::TRACE_ON_RESOLVED},
+    {"write", TraceItem::TRACE_FILE_WRITE_NINJA},
+};
+constexpr size_t kPhaseCount = std::size(kPhases);
+
+// Sums of the durations of the traces of each type so far.
+struct TraceTotals {
+  std::vector<double> ms;
+
+  static TraceTotals Get() {
+    TraceTotals totals;
+    for (const Phase& phase : kPhases) {
+      double ms = GetTotalTraceDuration(phase.type).InMillisecondsF();
+      if (phase.has_nested)
+        ms -= GetTotalTraceDuration(phase.nested).InMillisecondsF();
+      totals.ms.push_back(ms);
+    }
+    return totals;
+  }
+};
+
+bool GetIntSwitch(const base::CommandLine& cmdline,
+                  const char* name,
+                  int* value) {
+  if (!cmdline.HasSwitch(name))
+    return true;
+  std::string str = cmdline.GetSwitchValueString(name);
+  if (!base::StringToInt(str, value)) {
+    Err(Location(), std::string("Invalid --") + name + ".",
+        "\"" + str + "\" is not a number.")
+        .PrintToStdout();
+    return false;
+  }
+  return true;
+}
+
+double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  if (values.size() % 2)
+    return values[middle];
+  return (values[middle - 1] + values[middle]) / 2;
+}
+
+void PrintResult(const std::string& name, double ms) {
+  OutputString(base::StringPrintf("RESULT gn_gen.%s: %.1f ms\n", name.c_str(),
+                                  ms));
+}
+
+// Returns the peak resident memory of the process so far in MB, or 0 if it
+// isn't known.
+double GetPeakRssMb() {
+#if defined(OS_POSIX)
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(OS_MACOSX)
+  return usage.ru_maxrss / (1024.0 * 1024.0);  // In bytes.
+#else
+  return usage.ru_maxrss / 1024.0;  // In kilobytes.
+#endif
+#else
+  return 0;
+#endif
+}
+
+// Tokenizes the build files under |dir| |runs| times.
+int RunTokenizerBenchmark(const base::FilePath& dir, int runs) {
+  std::vector<std::unique_ptr<InputFile>> files;
+  size_t bytes = 0;
+  base::FileEnumerator enumerator(dir, true, base::FileEnumerator::FILES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    base::FilePath::StringType extension = path.FinalExtension();
+    if (extension != FILE_PATH_LITERAL(".gn") &&
+        extension != FILE_PATH_LITERAL(".gni"))
+      continue;
+    auto file = std::make_unique<InputFile>(SourceFile("//BUILD.gn"));
+    if (!file->Load(path))
+      continue;
+    bytes += file->contents().size();
+    files.push_back(std::move(file));
+  }
+  if (files.empty()) {
+    Err(Location(), "No build files found under --tokenize.").PrintToStdout();
+    return 1;
+  }
+  OutputString(base::StringPrintf("Tokenizing %zu build files, %.1f MB\n",
+                                  files.size(), bytes / 1e6));
+
+  std::vector<double> ms;
+  for (int run = 0; run < runs; run++) {
+    size_t tokens = 0;
+    ElapsedTimer timer;
+    for (const auto& file : files) {
+      Err err;
+      tokens += Tokenizer::Tokenize(file.get(), &err).size();
+    }
+    ms.push_back(timer.Elapsed().InMillisecondsF());
+    OutputString(base::StringPrintf("Run %d: %.1f ms, %zu tokens\n", run + 1,
+                                    ms.back(), tokens));
+  }
+  double median = Median(ms);
+  OutputString(base::StringPrintf("RESULT tokenize.wall: %.1f ms\n", median));
+  OutputString(base::StringPrintf("RESULT tokenize.throughput: %.1f MB/s\n",
+                                  bytes / 1e3 / median));
+  return 0;
+}
+
+// Times the scheduler lookups checking |count| generated inputs, |runs| times.
+int RunGeneratedInputsBenchmark(int count, int runs) {
+  std::vector<SourceFile> files;
+  std::vector<SourceFile> inputs;
+  for (int i = 0; i < count; i++) {
+    files.push_back(SourceFile(base::StringPrintf(
+        "//out/Default/gen/dir%d/subdir/generated_file%d.h", i % 100, i)));
+    inputs.push_back(SourceFile(base::StringPrintf(
+        "//out/Default/gen/dir%d/subdir/generated_file%d.in", i % 100,
+        (i * 7919) % count)));
+  }
+
+  std::vector<double> ms;
+  for (int run = 0; run < runs; run++) {
+    MsgLoop msg_loop;
+    Scheduler scheduler;
+    for (int i = 0; i < count; i++)
+      scheduler.AddGeneratedFile(files[i]);
+
+    ElapsedTimer timer;
+    // Every input in the build directory is first looked up among the
+    // generated files, and the ones no dependency generates are recorded.
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+      found += scheduler.IsFileGeneratedByTarget(files[i]);
+      found += scheduler.IsFileGeneratedByTarget(inputs[i]);
+      scheduler.AddUnknownGeneratedInput(nullptr, inputs[i]);
+      if (i % 2)
+        scheduler.AddWrittenFile(inputs[i]);
+    }
+    size_t unknown = scheduler.GetUnknownGeneratedInputs().size();
+    ms.push_back(timer.Elapsed().InMillisecondsF());
+    OutputString(base::StringPrintf("Run %d: %.1f ms, %d found, %zu unknown\n",
+                                    run + 1, ms.back(), found, unknown));
+  }
+  OutputString(base::StringPrintf("RESULT generated_inputs.wall: %.1f ms\n",
+                                  Median(ms)));
+  return 0;
+}
+
+// Times |threads| threads interning the same |count| new strings, |runs|
+// times.
+int RunStringAtomBenchmark(int count, int threads, int runs) {
+  std::vector<double> ms;
+  for (int run = 0; run < runs; run++) {
+    std::vector<std::string> strings;
+    for (int i = 0; i < count; i++) {
+      strings.push_back(base::StringPrintf(
+          "//out/Default/obj/dir%d/subdir/run%d_object%d.o", i % 100, run, i));
+    }
+
+    // Each thread looks the strings up in its own order, as they would be
+    // when loading different files.
+    std::vector<std::vector<const std::string*>> orders(threads);
+    for (int t = 0; t < threads; t++) {
+      for (const std::string& str : strings)
+        orders[t].push_back(&str);
+      std::shuffle(orders[t].begin(), orders[t].end(), std::mt19937(t));
+    }
+
+    StringAtom::Stats before = StringAtom::GetStats();
+    ElapsedTimer timer;
+    std::vector<std::thread> workers;
+    for (const std::vector<const std::string*>& order : orders) {
+      workers.emplace_back([&order]() {
+        for (const std::string* str : order)
+          StringAtom atom(*str);
+      });
+    }
+    for (std::thread& worker : workers)
+      worker.join();
+    ms.push_back(timer.Elapsed().InMillisecondsF());
+
+    StringAtom::Stats after = StringAtom::GetStats();
+    OutputString(base::StringPrintf(
+        "Run %d: %.1f ms, %zu atoms, %zu bytes, %zu contended\n", run + 1,
+        ms.back(), after.count - before.count, after.bytes - before.bytes,
+        after.lock_contention - before.lock_contention));
+  }
+  OutputString(
+      base::StringPrintf("RESULT string_atoms.wall: %.1f ms\n", Median(ms)));
+  return 0;
+}
+
+// Times computing the hard deps of all the targets of a graph of |count|
+// targets, |runs| times.
+int RunHardDepsBenchmark(int count, int runs) {
+  constexpr int kChainLength = 1000;
+  BuildSettings build_settings;
+  Settings settings(&build_settings, std::string());
+  std::vector<std::unique_ptr<Target>> targets;
+  for (int i = 0; i < count; i++) {
+    std::string name = base::StringPrintf("t%d", i);
+    targets.push_back(std::make_unique<Target>(
+        &settings, Label(SourceDir(base::StringPrintf("//dir%d/", i / 100)),
+                         name)));
+  }
+
+  // Target i depends on target i + 1 in the same chain. Every fifth target
+  // of a chain also depends on the action that follows it.
+  std::vector<const Target*> groups;
+  for (int i = 0; i < count; i++) {
+    Target* target = targets[i].get();
+    if (i % 6 == 5) {
+      target->set_output_type(Target::ACTION);
+      continue;
+    }
+    target->set_output_type(Target::GROUP);
+    groups.push_back(target);
+    int next = i % 6 == 4 ? i + 2 : i + 1;
+    if (next < count && next / kChainLength == i / kChainLength)
+      target->private_deps().push_back(LabelTargetPair(targets[next].get()));
+    if (i % 6 == 4 && i + 1 < count)
+      target->private_deps().push_back(LabelTargetPair(targets[i + 1].get()));
+  }
+
+  std::vector<double> ms;
+  for (int run = 0; run < runs; run++) {
+    ElapsedTimer timer;
+    ResolvedTargetData resolved;
+    size_t hard_deps = 0;
+    for (const Target* target : groups)
+      hard_deps += resolved.GetHardDeps(target).size();
+    ms.push_back(timer.Elapsed().InMillisecondsF());
+    OutputString(base::StringPrintf("Run %d: %.1f ms, %zu hard deps\n",
+                                    run + 1, ms.back(), hard_deps));
+  }
+  OutputString(
+      base::StringPrintf("RESULT hard_deps.wall: %.1f ms\n", Median(ms)));
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  base::CommandLine::Init(argc, argv);
+  base::CommandLine* cmdline = base::CommandLine::ForCurrentProcess();
+
+  SyntheticBuildParams params;
+  int runs = 3;
+  if (!GetIntSwitch(*cmdline, "targets", &params.targets) ||
+      !GetIntSwitch(*cmdline, "fan-out", &params.fan_out) ||
+      !GetIntSwitch(*cmdline, "template-depth", &params.template_depth) ||
+      !GetIntSwitch(*cmdline, "list-appends", &params.list_appends) ||
+      !GetIntSwitch(*cmdline, "statements", &params.statements) ||
+      !GetIntSwitch(*cmdline, "configs", &params.configs) ||
+      !GetIntSwitch(*cmdline, "toolchains", &params.toolchains) ||
+      !GetIntSwitch(*cmdline, "runs", &runs))
+    return 1;
+  if (runs < 1) {
+    Err(Location(), "Invalid --runs.").PrintToStdout();
+    return 1;
+  }
+
+  if (cmdline->HasSwitch("tokenize"))
+    return RunTokenizerBenchmark(cmdline->GetSwitchValuePath("tokenize"), runs);
+  if (cmdline->HasSwitch("generated-inputs")) {
+    int count = 0;
+    if (!GetIntSwitch(*cmdline, "generated-inputs", &count))
+      return 1;
+    return RunGeneratedInputsBenchmark(count, runs);
+  }
+  if (cmdline->HasSwitch("string-atoms")) {
+    int count = 0;
+    int threads = 4;
+    if (!GetIntSwitch(*cmdline, "string-atoms", &count) ||
+        !GetIntSwitch(*cmdline, "threads", &threads))
+      return 1;
+    return RunStringAtomBenchmark(count, threads, runs);
+  }
+  if (cmdline->HasSwitch("hard-deps")) {
+    int count = 0;
+    if (!GetIntSwitch(*cmdline, "hard-deps", &count))
+      return 1;
+    return RunHardDepsBenchmark(count, runs);
+  }
+
+  base::ScopedTempDir temp_dir;
+  base::FilePath root;
+  if (cmdline->HasSwitch("source-dir")) {
+    root =
+        base::MakeAbsoluteFilePath(cmdline->GetSwitchValuePath("source-dir"));
+    if (root.empty()) {
+      Err(Location(), "The --source-dir must exist.").PrintToStdout();
+      return 1;
+    }
+  } else {
+    if (!temp_dir.CreateUniqueTempDir()) {
+      Err(Location(), "Couldn't create a temporary directory.").PrintToStdout();
+      return 1;
+    }
+    root = temp_dir.GetPath();
+  }
+
+  Err err;
+  if (!WriteSyntheticBuild(root, params, &err)) {
+    err.PrintToStdout();
+    return 1;
+  }
+  OutputString(base::StringPrintf(
+      "Synthetic build: %d targets, fan-out %d, template depth %d, "
+      "%d list appends, %d statements, %d configs, %d toolchain(s)\n",
+      params.targets, params.fan_out, params.template_depth,
+      params.list_appends, params.statements, params.configs,
+      params.toolchains));
+
+  // Run "gn -q gen out" in the build, as if invoked from its root.
+  base::FilePath current_dir;
+  base::GetCurrentDirectory(&current_dir);
+  base::SetCurrentDirectory(root);
+  cmdline->AppendSwitch(switches::kQuiet);
+  if (!cmdline->HasSwitch(switches::kThreads))
+    cmdline->AppendSwitch(switches::kThreads, "1");
+  if (!commands::CommandSwitches::Init(*cmdline))
+    return 1;
+  EnableTracing();
+
+  std::vector<double> wall_ms;
+  std::vector<std::vector<double>> phase_ms(kPhaseCount);
+  double peak_rss_mb = 0;
+  base::FilePath out_dir = root.AppendASCII("out");
+  for (int run = 0; run < runs; run++) {
+    base::DeleteFile(out_dir, true);
+
+    TraceTotals before = TraceTotals::Get();
+    ElapsedTimer timer;
+    int result;
+    {
+      MsgLoop msg_loop;
+      result = commands::RunGen({"out"});
+    }
+    wall_ms.push_back(timer.Elapsed().InMillisecondsF());
+    if (result != 0) {
+      base::SetCurrentDirectory(current_dir);
+      return result;
+    }
+    if (run == 0)
+      peak_rss_mb = GetPeakRssMb();
+
+    TraceTotals after = TraceTotals::Get();
+    std::string line = base::StringPrintf("Run %d: %.1f ms (", run + 1,
+                                          wall_ms.back());
+    for (size_t i = 0; i < kPhaseCount; i++) {
+      phase_ms[i].push_back(after.ms[i] - before.ms[i]);
+      line += base::StringPrintf("%s%s %.1f", i ? ", " : "", kPhases[i].name,
+                                 phase_ms[i].back());
+    }
+    OutputString(line + ")\n");
+  }
+  base::SetCurrentDirectory(current_dir);
+
+  PrintResult("wall", Median(wall_ms));
+  for (size_t i = 0; i < kPhaseCount; i++)
+    PrintResult(kPhases[i].name, Median(phase_ms[i]));
+  if (peak_rss_mb > 0) {
+    OutputString(
+        base::StringPrintf("RESULT gn_gen.peak_rss: %.1f MB\n", peak_rss_mb));
+  }
+  return 0;
+}
@@ -426,6 +426,10 @@ class HashTableBase {
 
   NodeIteratorPair ValidNodesRange() const { return {NodeBegin(), NodeEnd()}; }
 
+  // Return the number of buckets in the table, including null and tombstone
+  // ones.
+  size_t NodeBucketCount() const { return size_; }
+
   // Clear the nodes table completely.
   void NodeClear() {
     if (buckets_ != buckets0_)
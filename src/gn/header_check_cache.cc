@@ -0,0 +1,329 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/header_check_cache.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "gn/c_include_iterator.h"
+#include "gn/input_file.h"
+#include "gn/source_file.h"
+#include "last_commit_position.h"
+#include "util/atomic_write.h"
+
+namespace {
+
+// Increment when changing the format below. Caches written by any other
+// version of GN are also rejected since the include scanner may differ.
+constexpr uint32_t kHeaderCheckCacheVersion = 2;
+
+constexpr char kMagic[4] = {'G', 'N', 'I', 'C'};
+
+class Writer {
+ public:
+  explicit Writer(std::string* out) : out_(out) {}
+
+  void WriteU8(uint8_t value) { out_->push_back(static_cast<char>(value)); }
+
+  void WriteU32(uint32_t value) {
+    for (int i = 0; i < 4; i++)
+      out_->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+  }
+
+  void WriteU64(uint64_t value) {
+    WriteU32(static_cast<uint32_t>(value));
+    WriteU32(static_cast<uint32_t>(value >> 32));
+  }
+
+  template <typename String>
+  void WriteString(const String& str) {
+    size_t size = str.size() * sizeof(typename String::value_type);
+    WriteU32(static_cast<uint32_t>(size));
+    out_->append(reinterpret_cast<const char*>(str.data()), size);
+  }
+
+ private:
+  std::string* out_;
+};
+
+// All reads are bounds checked and return false on truncated data.
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  bool done() const { return pos_ == data_.size(); }
+
+  bool ReadU8(uint8_t* value) {
+    if (pos_ == data_.size())
+      return false;
+    *value = static_cast<uint8_t>(data_[pos_++]);
+    return true;
+  }
+
+  bool ReadU32(uint32_t* value) {
+    if (data_.size() - pos_ < 4)
+      return false;
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+      *value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[pos_++]))
+                << (i * 8);
+    return true;
+  }
+
+  bool ReadU64(uint64_t* value) {
+    uint32_t low, high;
+    if (!ReadU32(&low) || !ReadU32(&high))
+      return false;
+    *value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+  }
+
+  template <typename String>
+  bool ReadString(String* str) {
+    using Char = typename String::value_type;
+    uint32_t size;
+    if (!ReadU32(&size) || size > data_.size() - pos_ || size % sizeof(Char))
+      return false;
+    str->resize(size / sizeof(Char));
+    memcpy(str->data(), data_.data() + pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+ private:
+  std::string_view data_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+HeaderCheckCache::HeaderCheckCache() = default;
+
+HeaderCheckCache::~HeaderCheckCache() = default;
+
+std::shared_ptr<const HeaderCheckCache::Includes> HeaderCheckCache::GetIncludes(
+    const base::FilePath& path) {
+  bool persistent;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto found = entries_.find(path.value());
+    if (found != entries_.end() && found->second.up_to_date) {
+      hits_++;
+      return found->second.includes;
+    }
+    persistent = persistent_;
+  }
+
+  // Files are stat'ed before being read, so a file modified in the meantime
+  // gets a stale time and is read again by the next run.
+  base::File::Info info;
+  if (persistent) {
+    if (!base::GetFileInfo(path, &info) || info.is_directory)
+      return nullptr;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    auto found = entries_.find(path.value());
+    if (found != entries_.end() && found->second.size == info.size &&
+        found->second.last_modified == info.last_modified) {
+      found->second.up_to_date = true;
+      hits_++;
+      return found->second.includes;
+    }
+  }
+
+  std::string contents;
+  if (!base::ReadFileToString(path, &contents))
+    return nullptr;
+
+  // The source file name doesn't matter for scanning.
+  InputFile input_file((SourceFile()));
+  input_file.SetContents(std::move(contents));
+  auto includes = std::make_shared<const Includes>(ScanFile(input_file));
+
+  std::lock_guard<std::mutex> lock(lock_);
+  misses_++;
+  Entry& entry = entries_[path.value()];
+  if (entry.up_to_date) {
+    // Another thread scanned the same file concurrently.
+    return entry.includes;
+  }
+  entry.size = info.size;
+  entry.last_modified = info.last_modified;
+  entry.includes = std::move(includes);
+  entry.up_to_date = true;
+  return entry.includes;
+}
+
+// static
+HeaderCheckCache::Includes HeaderCheckCache::ScanFile(const InputFile& file) {
+  Includes result;
+  CIncludeIterator iter(&file);
+  IncludeStringWithLocation include;
+  while (iter.GetNextIncludeString(&include)) {
+    Include& cur = result.emplace_back();
+    cur.contents = std::string(include.contents);
+    cur.line = include.location.begin().line_number();
+    cur.column = include.location.begin().column_number();
+    cur.system_style = include.system_style_include;
+  }
+  return result;
+}
+
+bool HeaderCheckCache::HasPassed(const std::string& key) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto found = passed_.find(key);
+  if (found == passed_.end())
+    return false;
+  found->second = true;
+  skipped_checks_++;
+  return true;
+}
+
+void HeaderCheckCache::AddPassed(const std::string& key) {
+  std::lock_guard<std::mutex> lock(lock_);
+  passed_[key] = true;
+}
+
+bool HeaderCheckCache::Load(const base::FilePath& path) {
+  std::string data;
+  bool result = base::ReadFileToString(path, &data);
+
+  std::lock_guard<std::mutex> lock(lock_);
+  persistent_ = true;
+  entries_.clear();
+  passed_.clear();
+  if (result)
+    result = Deserialize(data);
+  if (!result) {
+    entries_.clear();
+    passed_.clear();
+  }
+  return result;
+}
+
+bool HeaderCheckCache::persistent() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return persistent_;
+}
+
+bool HeaderCheckCache::Save(const base::FilePath& path) const {
+  std::string data;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    data = Serialize();
+  }
+  return util::WriteFileAtomically(path, data.data(),
+                                   static_cast<int>(data.size())) ==
+         static_cast<int>(data.size());
+}
+
+int64_t HeaderCheckCache::hits() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return hits_;
+}
+
+int64_t HeaderCheckCache::misses() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return misses_;
+}
+
+int64_t HeaderCheckCache::skipped_checks() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return skipped_checks_;
+}
+
+std::string HeaderCheckCache::Serialize() const {
+  std::string out(kMagic, sizeof(kMagic));
+  Writer writer(&out);
+  writer.WriteU32(kHeaderCheckCacheVersion);
+  writer.WriteString(std::string_view(LAST_COMMIT_POSITION));
+
+  uint32_t entry_count = 0;
+  for (const auto& [file, entry] : entries_)
+    entry_count += entry.up_to_date;
+  writer.WriteU32(entry_count);
+  for (const auto& [file, entry] : entries_) {
+    if (!entry.up_to_date)
+      continue;
+    writer.WriteString(file);
+    writer.WriteU64(static_cast<uint64_t>(entry.size));
+    writer.WriteU64(entry.last_modified);
+    writer.WriteU32(static_cast<uint32_t>(entry.includes->size()));
+    for (const Include& include : *entry.includes) {
+      writer.WriteString(include.contents);
+      writer.WriteU32(static_cast<uint32_t>(include.line));
+      writer.WriteU32(static_cast<uint32_t>(include.column));
+      writer.WriteU8(include.system_style);
+    }
+  }
+
+  uint32_t passed_count = 0;
+  for (const auto& [key, used] : passed_)
+    passed_count += used;
+  writer.WriteU32(passed_count);
+  for (const auto& [key, used] : passed_) {
+    if (used)
+      writer.WriteString(key);
+  }
+  return out;
+}
+
+bool HeaderCheckCache::Deserialize(std::string_view data) {
+  if (data.size() < sizeof(kMagic) ||
+      memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)
+    return false;
+
+  Reader reader(data.substr(sizeof(kMagic)));
+  uint32_t version;
+  std::string commit_position;
+  if (!reader.ReadU32(&version) || version != kHeaderCheckCacheVersion ||
+      !reader.ReadString(&commit_position) ||
+      commit_position != LAST_COMMIT_POSITION)
+    return false;
+
+  uint32_t entry_count;
+  if (!reader.ReadU32(&entry_count))
+    return false;
+  for (uint32_t i = 0; i < entry_count; i++) {
+    base::FilePath::StringType file;
+    Entry entry;
+    uint64_t size;
+    uint32_t include_count;
+    if (!reader.ReadString(&file) || !reader.ReadU64(&size) ||
+        !reader.ReadU64(&entry.last_modified) ||
+        !reader.ReadU32(&include_count))
+      return false;
+    entry.size = static_cast<int64_t>(size);
+
+    Includes includes;
+    for (uint32_t j = 0; j < include_count; j++) {
+      Include& include = includes.emplace_back();
+      uint32_t line, column;
+      uint8_t system_style;
+      if (!reader.ReadString(&include.contents) || !reader.ReadU32(&line) ||
+          !reader.ReadU32(&column) || !reader.ReadU8(&system_style))
+        return false;
+      include.line = static_cast<int>(line);
+      include.column = static_cast<int>(column);
+      include.system_style = system_style != 0;
+    }
+    entry.includes = std::make_shared<const Includes>(std::move(includes));
+    entries_[std::move(file)] = std::move(entry);
+  }
+
+  uint32_t passed_count;
+  if (!reader.ReadU32(&passed_count))
+    return false;
+  for (uint32_t i = 0; i < passed_count; i++) {
+    std::string key;
+    if (!reader.ReadString(&key))
+      return false;
+    passed_[std::move(key)] = false;
+  }
+  return reader.done();
+}
@@ -0,0 +1,128 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_HEADER_CHECK_CACHE_H_
+#define TOOLS_GN_HEADER_CHECK_CACHE_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "util/ticks.h"
+
+class InputFile;
+
+// Remembers the #includes found in C-like source files by the header checker,
+// so that each file is read and scanned only once per run no matter how many
+// targets list it.
+//
+// The cache can also be saved to disk and loaded by a later run. Entries
+// record the size and modification time of the file when it was read, and a
+// file whose size and time are unchanged isn't read again.
+//
+// A persistent cache also remembers which checks passed. The header checker
+// identifies a check by a key covering everything its result depends on, so a
+// later run finding the same key can skip the check. Failed checks aren't
+// remembered, so their errors are always reported in full.
+//
+// Loaded entries and passed checks that aren't looked up during the run are
+// not saved again.
+//
+// Any problem reading the saved cache just results in an empty cache.
+//
+// This class is threadsafe.
+class HeaderCheckCache {
+ public:
+  // An include found in a file. The include string starts at the given
+  // one-based line and column.
+  struct Include {
+    std::string contents;
+    int line = 0;
+    int column = 0;
+    bool system_style = false;
+
+    bool operator==(const Include& other) const {
+      return contents == other.contents && line == other.line &&
+             column == other.column && system_style == other.system_style;
+    }
+  };
+  using Includes = std::vector<Include>;
+
+  HeaderCheckCache();
+  ~HeaderCheckCache();
+
+  // Returns the includes of the file at the given path, reading and scanning
+  // it if needed. Returns null if the file can't be read.
+  std::shared_ptr<const Includes> GetIncludes(const base::FilePath& path);
+
+  // Scans the contents of the given file.
+  static Includes ScanFile(const InputFile& file);
+
+  // Returns true if a check with the given key passed, during this run or,
+  // for a persistent cache, an earlier one.
+  bool HasPassed(const std::string& key);
+
+  // Records that the check with the given key passed.
+  void AddPassed(const std::string& key);
+
+  // Replaces the contents of the cache with the entries saved in the given
+  // file. Returns false (leaving the cache empty) if the file doesn't exist
+  // or isn't valid. Either way, the cache becomes persistent: the size and
+  // modification time of the files read afterwards are recorded, which is
+  // only useful to later runs.
+  bool Load(const base::FilePath& path);
+
+  // Returns true once Load() has been called.
+  bool persistent() const;
+
+  // Saves the entries of the files looked up since the cache was created or
+  // loaded. Returns false on failure.
+  bool Save(const base::FilePath& path) const;
+
+  // Number of lookups that did and didn't need to scan a file.
+  int64_t hits() const;
+  int64_t misses() const;
+
+  // Number of HasPassed() calls that returned true.
+  int64_t skipped_checks() const;
+
+ private:
+  struct Entry {
+    int64_t size = 0;
+    Ticks last_modified = 0;
+
+    std::shared_ptr<const Includes> includes;
+
+    // True once the entry is known to match the file during this run.
+    bool up_to_date = false;
+  };
+
+  std::string Serialize() const;
+  bool Deserialize(std::string_view data);
+
+  mutable std::mutex lock_;
+
+  // Indexed by FilePath::value().
+  std::unordered_map<base::FilePath::StringType, Entry> entries_;
+
+  // Keys of the passed checks, with whether they were used during this run.
+  std::unordered_map<std::string, bool> passed_;
+
+  bool persistent_ = false;
+
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+  int64_t skipped_checks_ = 0;
+
+  HeaderCheckCache(const HeaderCheckCache&) = delete;
+  HeaderCheckCache& operator=(const HeaderCheckCache&) = delete;
+};
+
+#endif  // TOOLS_GN_HEADER_CHECK_CACHE_H_
@@ -0,0 +1,120 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "gn/header_check_cache.h"
+#include "gn/input_file.h"
+#include "gn/source_file.h"
+#include "util/test/test.h"
+
+namespace {
+
+const char kContents[] =
+    "// Copyright\n"
+    "#include \"foo/bar.h\"\n"
+    "#include <vector>\n"
+    "#include \"baz.h\"  // nogncheck\n"
+    "  #import \"objc.h\"\n";
+
+bool WriteContents(const base::FilePath& path, const std::string& contents) {
+  return base::WriteFile(path, contents.data(),
+                         static_cast<int>(contents.size())) ==
+         static_cast<int>(contents.size());
+}
+
+}  // namespace
+
+TEST(HeaderCheckCache, ScanFile) {
+  InputFile file(SourceFile("//foo.cc"));
+  file.SetContents(kContents);
+  HeaderCheckCache::Includes includes = HeaderCheckCache::ScanFile(file);
+  ASSERT_EQ(3u, includes.size());
+
+  EXPECT_EQ("foo/bar.h", includes[0].contents);
+  EXPECT_EQ(2, includes[0].line);
+  EXPECT_EQ(11, includes[0].column);
+  EXPECT_FALSE(includes[0].system_style);
+
+  EXPECT_EQ("vector", includes[1].contents);
+  EXPECT_EQ(3, includes[1].line);
+  EXPECT_TRUE(includes[1].system_style);
+
+  EXPECT_EQ("objc.h", includes[2].contents);
+  EXPECT_EQ(5, includes[2].line);
+  EXPECT_EQ(12, includes[2].column);
+}
+
+TEST(HeaderCheckCache, ScansOncePerRun) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath path = temp_dir.GetPath().AppendASCII("foo.cc");
+  ASSERT_TRUE(WriteContents(path, kContents));
+
+  HeaderCheckCache cache;
+  auto includes = cache.GetIncludes(path);
+  ASSERT_TRUE(includes);
+  EXPECT_EQ(3u, includes->size());
+
+  // The file isn't looked at again during the same run.
+  ASSERT_TRUE(WriteContents(path, "#include \"other.h\"\n"));
+  EXPECT_EQ(includes, cache.GetIncludes(path));
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+
+  EXPECT_FALSE(cache.GetIncludes(temp_dir.GetPath().AppendASCII("none.cc")));
+}
+
+TEST(HeaderCheckCache, SaveAndLoad) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  base::FilePath cache_path = temp_dir.GetPath().AppendASCII("cache");
+  base::FilePath path = temp_dir.GetPath().AppendASCII("foo.cc");
+  ASSERT_TRUE(WriteContents(path, kContents));
+
+  HeaderCheckCache::Includes expected;
+  {
+    HeaderCheckCache cache;
+    EXPECT_FALSE(cache.Load(cache_path));
+    auto includes = cache.GetIncludes(path);
+    ASSERT_TRUE(includes);
+    expected = *includes;
+    EXPECT_EQ(1, cache.misses());
+    EXPECT_TRUE(cache.Save(cache_path));
+  }
+
+  {
+    // The unchanged file is served from the cache.
+    HeaderCheckCache cache;
+    EXPECT_TRUE(cache.Load(cache_path));
+    auto includes = cache.GetIncludes(path);
+    ASSERT_TRUE(includes);
+    EXPECT_EQ(expected, *includes);
+    EXPECT_EQ(1, cache.hits());
+    EXPECT_EQ(0, cache.misses());
+    EXPECT_TRUE(cache.Save(cache_path));
+  }
+
+  // A changed file is scanned again.
+  ASSERT_TRUE(WriteContents(path, "#include \"other.h\"\n"));
+  {
+    HeaderCheckCache cache;
+    EXPECT_TRUE(cache.Load(cache_path));
+    auto includes = cache.GetIncludes(path);
+    ASSERT_TRUE(includes);
+    ASSERT_EQ(1u, includes->size());
+    EXPECT_EQ("other.h", (*includes)[0].contents);
+    EXPECT_EQ(0, cache.hits());
+    EXPECT_EQ(1, cache.misses());
+  }
+
+  // Invalid caches are ignored.
+  ASSERT_TRUE(WriteContents(cache_path, "GNIC garbage"));
+  HeaderCheckCache cache;
+  EXPECT_FALSE(cache.Load(cache_path));
+  ASSERT_TRUE(cache.GetIncludes(path));
+  EXPECT_EQ(1, cache.misses());
+}
@@ -8,12 +8,13 @@
 
 #include "base/containers/queue.h"
 #include "base/files/file_util.h"
+#include "base/sha1.h"
 #include "base/strings/string_util.h"
 #include "gn/build_settings.h"
 #include "gn/builder.h"
-#include "gn/c_include_iterator.h"
 #include "gn/config.h"
 #include "gn/config_values_extractors.h"
+#include "gn/deps_iterator.h"
 #include "gn/err.h"
 #include "gn/filesystem_utils.h"
 #include "gn/scheduler.h"
@@ -114,6 +115,18 @@ bool FriendMatches(const Target* annotation_on,
                                      is_marked_friend->label());
 }
 
+// Appends the full label, including the toolchain, to the data of a hash.
+void AppendLabelForHash(const Label& label, std::string* data) {
+  *data += label.dir().value();
+  data->push_back(':');
+  *data += label.name();
+  data->push_back('(');
+  *data += label.toolchain_dir().value();
+  data->push_back(':');
+  *data += label.toolchain_name();
+  data->push_back(')');
+}
+
 }  // namespace
 
 HeaderChecker::HeaderChecker(const BuildSettings* build_settings,
@@ -141,6 +154,17 @@ bool HeaderChecker::Run(const std::vector<const Target*>& to_check,
     if (check->IsBinary())
       AddTargetToFileMap(check, &files_to_check);
   }
+  if (cache_.persistent())
+    ComputeTargetFingerprints(to_check);
+
+  // Index the checked targets up front so that checks can read the index
+  // without locking.
+  for (auto* check : to_check) {
+    if (check->IsBinary())
+      IndexReachability(check);
+  }
+  reachability_complete_ = true;
+
   RunCheckOverFiles(files_to_check, force_check);
 
   if (errors_.empty())
@@ -298,7 +322,7 @@ SourceFile HeaderChecker::SourceFileForInclude(
 
 bool HeaderChecker::CheckFile(const Target* from_target,
                               const SourceFile& file,
-                              std::vector<Err>* errors) const {
+                              std::vector<Err>* errors) {
   ScopedTrace trace(TraceItem::TRACE_CHECK_HEADER, file.value());
 
   // Sometimes you have generated source files included as sources in another
@@ -309,8 +333,9 @@ bool HeaderChecker::CheckFile(const Target* from_target,
     return true;
 
   base::FilePath path = build_settings_->GetFullPath(file);
-  std::string contents;
-  if (!base::ReadFileToString(path, &contents)) {
+  std::shared_ptr<const HeaderCheckCache::Includes> includes =
+      cache_.GetIncludes(path);
+  if (!includes) {
     // A missing (not yet) generated file is an acceptable problem
     // considering this code does not understand conditional includes.
     if (IsFileInOuputDir(file))
@@ -325,8 +350,6 @@ bool HeaderChecker::CheckFile(const Target* from_target,
   }
 
   InputFile input_file(file);
-  input_file.SetContents(contents);
-
   std::vector<SourceDir> include_dirs;
   for (ConfigValuesIterator iter(from_target); !iter.done(); iter.Next()) {
     const std::vector<SourceDir>& target_include_dirs =
@@ -335,27 +358,180 @@ bool HeaderChecker::CheckFile(const Target* from_target,
                         target_include_dirs.end());
   }
 
-  size_t error_count_before = errors->size();
-  CIncludeIterator iter(&input_file);
+  // A persistent cache remembers the checks that passed in earlier runs.
+  std::string check_key;
+  if (cache_.persistent()) {
+    check_key = GetCheckKey(from_target, input_file, *includes, include_dirs);
+    if (cache_.HasPassed(check_key))
+      return true;
+  }
 
+  // The includes may come from the cache, in which case the file wasn't read.
+  // The errors show the include lines, so only find out whether the check
+  // passes at first, and read the file to report the errors if it doesn't.
+  if (CheckIncludes(from_target, input_file, *includes, include_dirs,
+                    nullptr)) {
+    if (!check_key.empty())
+      cache_.AddPassed(check_key);
+    return true;
+  }
+
+  std::string contents;
+  if (!base::ReadFileToString(path, &contents)) {
+    errors->emplace_back(from_target->defined_from(), "Source file not read.",
+                         "The target:\n  " +
+                             from_target->label().GetUserVisibleName(false) +
+                             "\nhas a source file:\n  " + file.value() +
+                             "\nwhich could not be read.");
+    return false;
+  }
+  input_file.SetContents(contents);
+  CheckIncludes(from_target, input_file, *includes, include_dirs, errors);
+  return false;
+}
+
+bool HeaderChecker::CheckIncludes(const Target* from_target,
+                                  const InputFile& source_file,
+                                  const HeaderCheckCache::Includes& includes,
+                                  const std::vector<SourceDir>& include_dirs,
+                                  std::vector<Err>* errors) const {
+  bool result = true;
   IncludeStringWithLocation include;
+  for (const HeaderCheckCache::Include& cur : includes) {
+    if (cur.system_style && !check_system_)
+      continue;
 
-  std::set<std::pair<const Target*, const Target*>> no_dependency_cache;
+    include.contents = cur.contents;
+    include.location = LocationRange(
+        Location(&source_file, cur.line, cur.column),
+        Location(&source_file, cur.line,
+                 cur.column + static_cast<int>(cur.contents.size())));
+    include.system_style_include = cur.system_style;
 
-  while (iter.GetNextIncludeString(&include)) {
-    if (include.system_style_include && !check_system_)
+    Err err;
+    SourceFile included_file =
+        SourceFileForInclude(include, include_dirs, source_file, &err);
+    if (!included_file.is_null() &&
+        !CheckInclude(from_target, source_file, included_file,
+                      include.location, errors)) {
+      result = false;
+      if (!errors)
+        break;
+    }
+  }
+  return result;
+}
+
+std::string HeaderChecker::GetCheckKey(
+    const Target* from_target,
+    const InputFile& source_file,
+    const HeaderCheckCache::Includes& includes,
+    const std::vector<SourceDir>& include_dirs) {
+  std::string data = source_file.name().value();
+  data.push_back('\0');
+  data += target_fingerprints_.at(from_target);
+  data.push_back(check_system_ ? 's' : '-');
+  for (const SourceDir& dir : include_dirs) {
+    data += dir.value();
+    data.push_back('\0');
+  }
+
+  IncludeStringWithLocation include;
+  for (const HeaderCheckCache::Include& cur : includes) {
+    if (cur.system_style && !check_system_)
       continue;
 
+    include.contents = cur.contents;
+    include.system_style_include = cur.system_style;
     Err err;
     SourceFile included_file =
-        SourceFileForInclude(include, include_dirs, input_file, &err);
-    if (!included_file.is_null()) {
-      CheckInclude(from_target, input_file, included_file, include.location,
-                   &no_dependency_cache, errors);
+        SourceFileForInclude(include, include_dirs, source_file, &err);
+    data.push_back('\n');
+    data += included_file.value();
+    if (!included_file.is_null())
+      data += GetFileDigest(included_file);
+  }
+  return base::SHA1HashString(data);
+}
+
+std::string HeaderChecker::GetFileDigest(const SourceFile& file) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto found = file_digests_.find(file);
+    if (found != file_digests_.end())
+      return found->second;
+  }
+
+  // Record the same facts about the targets listing the file that
+  // CheckInclude() looks at, except for whether they are dependencies of the
+  // including target, which its fingerprint covers. Shared headers can be
+  // listed by many targets, so this is only done once per file.
+  std::string data;
+  FileMap::const_iterator found = file_map_.find(file);
+  if (found != file_map_.end()) {
+    for (const TargetInfo& info : found->second) {
+      const Target* target = info.target;
+      AppendLabelForHash(target->label(), &data);
+      data.push_back(info.is_public ? 'p' : '-');
+      for (const LabelPattern& pattern : target->friends()) {
+        data.push_back('f');
+        data += pattern.Describe();
+      }
+      for (const Label& label : target->allow_circular_includes_from()) {
+        data.push_back('c');
+        AppendLabelForHash(label, &data);
+      }
+      data.push_back('\0');
     }
   }
+  std::string digest = base::SHA1HashString(data);
+
+  std::lock_guard<std::mutex> lock(lock_);
+  file_digests_.emplace(file, digest);
+  return digest;
+}
+
+void HeaderChecker::ComputeTargetFingerprints(
+    const std::vector<const Target*>& targets) {
+  // Walk the dependencies without recursion, so that long chains don't
+  // overflow the stack. The bool tells whether the target's dependencies were
+  // already pushed.
+  std::vector<std::pair<const Target*, bool>> stack;
+  for (const Target* target : targets)
+    stack.emplace_back(target, false);
+
+  while (!stack.empty()) {
+    auto [target, deps_pushed] = stack.back();
+    if (target_fingerprints_.count(target)) {
+      stack.pop_back();
+      continue;
+    }
+    if (!deps_pushed) {
+      stack.back().second = true;
+      for (const auto& dep : target->public_deps()) {
+        if (!target_fingerprints_.count(dep.ptr))
+          stack.emplace_back(dep.ptr, false);
+      }
+      for (const auto& dep : target->private_deps()) {
+        if (!target_fingerprints_.count(dep.ptr))
+          stack.emplace_back(dep.ptr, false);
+      }
+      continue;
+    }
+    stack.pop_back();
 
-  return errors->size() == error_count_before;
+    std::string data;
+    AppendLabelForHash(target->label(), &data);
+    for (const auto& dep : target->public_deps()) {
+      data.push_back('p');
+      data += target_fingerprints_[dep.ptr];
+    }
+    for (const auto& dep : target->private_deps()) {
+      data.push_back('v');
+      data += target_fingerprints_[dep.ptr];
+    }
+    target_fingerprints_[target] = base::SHA1HashString(data);
+  }
 }
 
 // If the file exists:
@@ -364,13 +540,11 @@ bool HeaderChecker::CheckFile(const Target* from_target,
 //  - The dependency path to the included target must follow only public_deps.
 //  - If there are multiple targets with the header in it, only one need be
 //    valid for the check to pass.
-void HeaderChecker::CheckInclude(
-    const Target* from_target,
-    const InputFile& source_file,
-    const SourceFile& include_file,
-    const LocationRange& range,
-    std::set<std::pair<const Target*, const Target*>>* no_dependency_cache,
-    std::vector<Err>* errors) const {
+bool HeaderChecker::CheckInclude(const Target* from_target,
+                                 const InputFile& source_file,
+                                 const SourceFile& include_file,
+                                 const LocationRange& range,
+                                 std::vector<Err>* errors) const {
   // Assume if the file isn't declared in our sources that we don't need to
   // check it. It would be nice if we could give an error if this happens, but
   // our include finder is too primitive and returns all includes, even if
@@ -378,10 +552,9 @@ void HeaderChecker::CheckInclude(
   // not unusual for the buildfiles to not specify that header at all.
   FileMap::const_iterator found = file_map_.find(include_file);
   if (found == file_map_.end())
-    return;
+    return true;
 
   const TargetVector& targets = found->second;
-  Chain chain;  // Prevent reallocating in the loop.
 
   // If the file is unknown in the current toolchain (rather than being private
   // or in a target not visible to the current target), ignore it. This is a
@@ -408,7 +581,7 @@ void HeaderChecker::CheckInclude(
     }
   }
   if (!present_in_current_toolchain)
-    return;
+    return true;
 
   // For all targets containing this file, we require that at least one be
   // a direct or public dependency of the current target, and either (1) the
@@ -416,9 +589,12 @@ void HeaderChecker::CheckInclude(
   // allowlisting the includor.
   //
   // If there is more than one target containing this header, we may encounter
-  // some error cases before finding a good one. This error stores the previous
-  // one encountered, which we may or may not throw away.
-  Err last_error;
+  // some error cases before finding a good one. These store the target of the
+  // previous one encountered, which we may or may not throw away. The error
+  // itself is only made if it's reported, since that needs the contents of
+  // the file and, for a non-public chain, a search for the chain.
+  const Target* last_error_target = nullptr;
+  bool last_error_is_private = false;
 
   bool found_dependency = false;
   for (const auto& target : targets) {
@@ -426,24 +602,10 @@ void HeaderChecker::CheckInclude(
     // target.
     const Target* to_target = target.target;
     if (to_target == from_target)
-      return;
+      return true;
 
     bool is_permitted_chain = false;
-
-    bool cached_no_dependency =
-        no_dependency_cache->find(std::make_pair(to_target, from_target)) !=
-        no_dependency_cache->end();
-
-    bool add_to_cache = !cached_no_dependency;
-
-    if (!cached_no_dependency &&
-        IsDependencyOf(to_target, from_target, &chain, &is_permitted_chain)) {
-      add_to_cache = false;
-
-      DCHECK(chain.size() >= 2);
-      DCHECK(chain[0].target == to_target);
-      DCHECK(chain[chain.size() - 1].target == from_target);
-
+    if (IsDependencyOf(to_target, from_target, nullptr, &is_permitted_chain)) {
       found_dependency = true;
 
       bool effectively_public =
@@ -451,48 +613,50 @@ void HeaderChecker::CheckInclude(
 
       if (effectively_public && is_permitted_chain) {
         // This one is OK, we're done.
-        last_error = Err();
+        last_error_target = nullptr;
         break;
       }
 
       // Diagnose the error.
-      if (!effectively_public) {
-        // Danger: must call CreatePersistentRange to put in Err.
-        last_error = Err(CreatePersistentRange(source_file, range),
-                         "Including a private header.",
-                         "This file is private to the target " +
-                             target.target->label().GetUserVisibleName(false));
-      } else if (!is_permitted_chain) {
-        last_error = Err(CreatePersistentRange(source_file, range),
-                         "Can't include this header from here.",
-                         GetDependencyChainPublicError(chain));
-      } else {
-        NOTREACHED();
-      }
+      DCHECK(!effectively_public || !is_permitted_chain);
+      last_error_target = to_target;
+      last_error_is_private = !effectively_public;
     } else if (to_target->allow_circular_includes_from().find(
                    from_target->label()) !=
                to_target->allow_circular_includes_from().end()) {
       // Not a dependency, but this include is allowlisted from the destination.
       found_dependency = true;
-      last_error = Err();
+      last_error_target = nullptr;
       break;
     }
-
-    if (add_to_cache) {
-      no_dependency_cache->emplace(to_target, from_target);
-    }
   }
 
-  if (!found_dependency || last_error.has_error()) {
+  if (!found_dependency || last_error_target) {
+    if (!errors)
+      return false;
+
     if (!found_dependency) {
-      DCHECK(!last_error.has_error());
       Err err = MakeUnreachableError(source_file, range, from_target, targets);
       errors->push_back(std::move(err));
+    } else if (last_error_is_private) {
+      // Danger: must call CreatePersistentRange to put in Err.
+      errors->emplace_back(
+          CreatePersistentRange(source_file, range),
+          "Including a private header.",
+          "This file is private to the target " +
+              last_error_target->label().GetUserVisibleName(false));
     } else {
-      // Found at least one dependency chain above, but it had an error.
-      errors->push_back(std::move(last_error));
+      Chain chain;
+      IsDependencyOf(last_error_target, from_target, false, &chain);
+      DCHECK(chain.size() >= 2);
+      DCHECK(chain[0].target == last_error_target);
+      DCHECK(chain[chain.size() - 1].target == from_target);
+      // Danger: must call CreatePersistentRange to put in Err.
+      errors->emplace_back(CreatePersistentRange(source_file, range),
+                           "Can't include this header from here.",
+                           GetDependencyChainPublicError(chain));
     }
-    return;
+    return false;
   }
 
   // One thing we didn't check for is targets that expose their dependents
@@ -512,6 +676,7 @@ void HeaderChecker::CheckInclude(
   //  - Save the includes found in each file and actually compute the graph of
   //    includes to detect when A implicitly includes C's header. This will not
   //    have the annoying false positive problem, but is complex to write.
+  return true;
 }
 
 bool HeaderChecker::IsDependencyOf(const Target* search_for,
@@ -524,20 +689,16 @@ bool HeaderChecker::IsDependencyOf(const Target* search_for,
     return false;
   }
 
-  // Find the shortest public dependency chain.
-  if (IsDependencyOf(search_for, search_from, true, chain)) {
-    *is_permitted = true;
-    return true;
-  }
+  if (!IsIndexedDependencyOf(search_for, search_from, is_permitted))
+    return false;
 
-  // If not, try to find any dependency chain at all.
-  if (IsDependencyOf(search_for, search_from, false, chain)) {
-    *is_permitted = false;
-    return true;
+  // Find the shortest permitted dependency chain if there is one, or else the
+  // shortest dependency chain at all.
+  if (chain) {
+    bool found = IsDependencyOf(search_for, search_from, *is_permitted, chain);
+    DCHECK(found);
   }
-
-  *is_permitted = false;
-  return false;
+  return true;
 }
 
 bool HeaderChecker::IsDependencyOf(const Target* search_for,
@@ -602,6 +763,104 @@ bool HeaderChecker::IsDependencyOf(const Target* search_for,
   return false;
 }
 
+bool HeaderChecker::IsIndexedDependencyOf(const Target* search_for,
+                                          const Target* search_from,
+                                          bool* is_permitted) const {
+  if (!reachability_complete_) {
+    // Only happens when CheckInclude() is called directly, as in tests.
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!reachability_.count(search_from))
+      IndexReachability(search_from);
+    return IsReachable(search_for, reachability_.find(search_from)->second,
+                       is_permitted);
+  }
+
+  auto found = reachability_.find(search_from);
+  DCHECK(found != reachability_.end());
+  return IsReachable(search_for, found->second, is_permitted);
+}
+
+bool HeaderChecker::IsReachable(const Target* search_for,
+                                const Reachability& reachability,
+                                bool* is_permitted) const {
+  *is_permitted = false;
+  size_t index = reachability_targets_.IndexOf(search_for);
+  if (index == UniqueVector<const Target*>::kIndexNone ||
+      !reachability.all_deps->contains(index))
+    return false;
+  *is_permitted = reachability.permitted_deps->contains(index);
+  return true;
+}
+
+void HeaderChecker::IndexReachability(const Target* target) const {
+  // Returns the shared set equal to |set| if there's one, since the sets of a
+  // target are often the same, as when all its dependencies are public.
+  auto share = [](CompressedBitSet&& set,
+                  std::initializer_list<const std::shared_ptr<
+                      const CompressedBitSet>*> candidates) {
+    for (const auto* candidate : candidates) {
+      if (*candidate && **candidate == set)
+        return *candidate;
+    }
+    return std::make_shared<const CompressedBitSet>(std::move(set));
+  };
+
+  // Index the dependencies first without recursion, so that long chains don't
+  // overflow the stack. The bool tells whether the target's dependencies were
+  // already pushed.
+  std::vector<std::pair<const Target*, bool>> stack;
+  stack.emplace_back(target, false);
+  while (!stack.empty()) {
+    auto [cur, deps_pushed] = stack.back();
+    if (reachability_.count(cur)) {
+      stack.pop_back();
+      continue;
+    }
+    if (!deps_pushed) {
+      stack.back().second = true;
+      for (const auto& pair : cur->GetDeps(Target::DEPS_LINKED)) {
+        if (!reachability_.count(pair.ptr))
+          stack.emplace_back(pair.ptr, false);
+      }
+      continue;
+    }
+    stack.pop_back();
+
+    CompressedBitSet public_deps;
+    CompressedBitSet all_deps;
+    CompressedBitSet permitted_deps;
+    for (const auto& pair : cur->public_deps()) {
+      // Dependency cycles are reported before the check, but don't loop
+      // forever if there is one.
+      auto found = reachability_.find(pair.ptr);
+      if (found == reachability_.end())
+        continue;
+      public_deps.insert(reachability_targets_.IndexOf(pair.ptr));
+      public_deps.insert(*found->second.public_deps);
+    }
+    for (const auto& pair : cur->GetDeps(Target::DEPS_LINKED)) {
+      auto found = reachability_.find(pair.ptr);
+      if (found == reachability_.end())
+        continue;
+      size_t index = reachability_targets_.IndexOf(pair.ptr);
+      all_deps.insert(index);
+      all_deps.insert(*found->second.all_deps);
+      permitted_deps.insert(index);
+      permitted_deps.insert(*found->second.public_deps);
+    }
+
+    Reachability reachability;
+    reachability.all_deps = share(std::move(all_deps), {});
+    reachability.public_deps =
+        share(std::move(public_deps), {&reachability.all_deps});
+    reachability.permitted_deps =
+        share(std::move(permitted_deps),
+              {&reachability.all_deps, &reachability.public_deps});
+    reachability_targets_.push_back(cur);
+    reachability_.emplace(cur, std::move(reachability));
+  }
+}
+
 Err HeaderChecker::MakeUnreachableError(const InputFile& source_file,
                                         const LocationRange& range,
                                         const Target* from_target,
@@ -8,21 +8,26 @@
 #include <condition_variable>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
-#include <set>
+#include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "base/atomic_ref_count.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "gn/c_include_iterator.h"
+#include "gn/compressed_bit_set.h"
 #include "gn/err.h"
+#include "gn/header_check_cache.h"
 #include "gn/source_dir.h"
+#include "gn/source_file.h"
+#include "gn/unique_vector.h"
 
 class BuildSettings;
 class InputFile;
-class SourceFile;
 class Target;
 
 namespace base {
@@ -68,6 +73,12 @@ class HeaderChecker : public base::RefCountedThreadSafe<HeaderChecker> {
            bool force_check,
            std::vector<Err>* errors);
 
+  // The includes found in the checked files. Each file is only scanned once
+  // even if it's listed by more than one target. The cache can be loaded
+  // before Run() and saved after it to skip scanning unchanged files, and
+  // checking files whose results can't have changed.
+  HeaderCheckCache* cache() { return &cache_; }
+
  private:
   friend class base::RefCountedThreadSafe<HeaderChecker>;
   FRIEND_TEST_ALL_PREFIXES(HeaderCheckerTest, IsDependencyOf);
@@ -122,28 +133,55 @@ class HeaderChecker : public base::RefCountedThreadSafe<HeaderChecker> {
   // error messages.
   bool CheckFile(const Target* from_target,
                  const SourceFile& file,
-                 std::vector<Err>* err) const;
+                 std::vector<Err>* err);
+
+  // Checks the given includes of a file of from_target. Returns true if they
+  // are all allowed. The errors need the contents of source_file, so it may
+  // be left empty when errors is null, in which case the check stops at the
+  // first disallowed include.
+  bool CheckIncludes(const Target* from_target,
+                     const InputFile& source_file,
+                     const HeaderCheckCache::Includes& includes,
+                     const std::vector<SourceDir>& include_dirs,
+                     std::vector<Err>* errors) const;
+
+  // Returns the key identifying the check of the given includes of a file of
+  // from_target in the cache. It covers the file name, the includes, the
+  // targets they resolve to and the fingerprint of from_target, but not the
+  // locations of the includes since those only matter for errors.
+  std::string GetCheckKey(const Target* from_target,
+                          const InputFile& source_file,
+                          const HeaderCheckCache::Includes& includes,
+                          const std::vector<SourceDir>& include_dirs);
+
+  // Returns a hash of the targets listing the given file, as seen by
+  // CheckInclude(). Computed once per file.
+  std::string GetFileDigest(const SourceFile& file);
+
+  // Fills target_fingerprints_ for the given targets and their dependencies.
+  // The fingerprint of a target is a hash of its label and the fingerprints
+  // of its public and private dependencies, so it changes whenever the part
+  // of the dependency graph that IsDependencyOf() can walk from it changes.
+  void ComputeTargetFingerprints(const std::vector<const Target*>& targets);
 
   // Checks that the given file in the given target can include the
-  // given include file. If disallowed, adds the error or errors to
-  // the errors array.  The range indicates the location of the
-  // include in the file for error reporting.
-  // |no_depeency_cache| is used to cache or check whether there is no
-  // dependency from |from_target| to target having |include_file|.
-  void CheckInclude(
-      const Target* from_target,
-      const InputFile& source_file,
-      const SourceFile& include_file,
-      const LocationRange& range,
-      std::set<std::pair<const Target*, const Target*>>* no_dependency_cache,
-      std::vector<Err>* errors) const;
+  // given include file. If disallowed, returns false and adds the error or
+  // errors to the errors array, unless it is null.  The range indicates the
+  // location of the include in the file for error reporting.
+  bool CheckInclude(const Target* from_target,
+                    const InputFile& source_file,
+                    const SourceFile& include_file,
+                    const LocationRange& range,
+                    std::vector<Err>* errors) const;
 
   // Returns true if the given search_for target is a dependency of
-  // search_from.
+  // search_from. This is answered by the reachability index, so the
+  // dependencies of the targets must not change after the first call.
   //
-  // If found, the vector given in "chain" will be filled with the reverse
+  // If found and "chain" is not null, it will be filled with the reverse
   // dependency chain from the dest target (chain[0] = search_for) to the src
-  // target (chain[chain.size() - 1] = search_from).
+  // target (chain[chain.size() - 1] = search_from). Finding the chain means
+  // searching the graph, so it should only be requested to report errors.
   //
   // Chains with permitted dependencies will be considered first. If a
   // permitted match is found, *is_permitted will be set to true. A chain with
@@ -165,6 +203,35 @@ class HeaderChecker : public base::RefCountedThreadSafe<HeaderChecker> {
                       bool require_permitted,
                       Chain* chain) const;
 
+  // Looks up search_for in the reachability index of search_from. Returns
+  // true if it's a dependency, and sets *is_permitted to whether a permitted
+  // chain leads to it.
+  bool IsIndexedDependencyOf(const Target* search_for,
+                             const Target* search_from,
+                             bool* is_permitted) const;
+
+  // The sets of targets reachable from a target, see reachability_.
+  struct Reachability {
+    // The targets reachable through public dependencies only.
+    std::shared_ptr<const CompressedBitSet> public_deps;
+
+    // The targets reachable through any dependencies.
+    std::shared_ptr<const CompressedBitSet> all_deps;
+
+    // The targets reachable through permitted chains: the direct dependencies
+    // and the targets reachable from them through public dependencies.
+    std::shared_ptr<const CompressedBitSet> permitted_deps;
+  };
+
+  // Implements IsIndexedDependencyOf() given the sets of search_from.
+  bool IsReachable(const Target* search_for,
+                   const Reachability& reachability,
+                   bool* is_permitted) const;
+
+  // Adds the given target and its dependencies to the reachability index.
+  // Must be called with lock_ held, or before checks start.
+  void IndexReachability(const Target* target) const;
+
   // Makes a very descriptive error message for when an include is disallowed
   // from a given from_target, with a missing dependency to one of the given
   // targets.
@@ -187,6 +254,24 @@ class HeaderChecker : public base::RefCountedThreadSafe<HeaderChecker> {
   // Maps source files to targets it appears in (usually just one target).
   FileMap file_map_;
 
+  // Includes of the checked files, shared by all the targets listing them.
+  HeaderCheckCache cache_;
+
+  // Only filled when the cache is persistent, before any check starts.
+  std::unordered_map<const Target*, std::string> target_fingerprints_;
+
+  // The sets of targets reachable from each target, filled by
+  // IndexReachability(). The integers in the sets are indices in
+  // reachability_targets_, where the dependencies of a target come before it.
+  //
+  // Run() indexes every checked target before any check starts and sets
+  // reachability_complete_, after which these are only read. Until then,
+  // as when CheckInclude() is called directly, they are filled on demand
+  // with lock_ held.
+  mutable UniqueVector<const Target*> reachability_targets_;
+  mutable std::unordered_map<const Target*, Reachability> reachability_;
+  bool reachability_complete_ = false;
+
   // Number of tasks posted by RunCheckOverFiles() that haven't completed their
   // execution.
   base::AtomicRefCount task_count_;
@@ -195,10 +280,13 @@ class HeaderChecker : public base::RefCountedThreadSafe<HeaderChecker> {
   //
   // These are mutable during runtime and require locking.
 
-  std::mutex lock_;
+  mutable std::mutex lock_;
 
   std::vector<Err> errors_;
 
+  // Digests returned by GetFileDigest().
+  std::unordered_map<SourceFile, std::string> file_digests_;
+
   // Signaled when |task_count_| becomes zero.
   std::condition_variable task_count_cv_;
 
@@ -5,6 +5,8 @@
 #include <ostream>
 #include <vector>
 
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "gn/config.h"
 #include "gn/header_checker.h"
 #include "gn/scheduler.h"
@@ -127,11 +129,18 @@ TEST_F(HeaderCheckerTest, IsDependencyOf) {
   EXPECT_TRUE(chain.empty());
   EXPECT_FALSE(is_permitted);
 
+  // The chain is optional.
+  is_permitted = false;
+  EXPECT_TRUE(checker->IsDependencyOf(&c_, &a_, nullptr, &is_permitted));
+  EXPECT_TRUE(is_permitted);
+
   // Remove the B -> C public dependency, leaving P's private dep on C the only
-  // path from A to C. This should now be found.
+  // path from A to C. This should now be found. The checker indexes the graph
+  // on the first query, so a new one is needed.
   chain.clear();
   EXPECT_EQ(&c_, b_.public_deps()[0].ptr);  // Validate it's the right one.
   b_.public_deps().erase(b_.public_deps().begin());
+  checker = CreateChecker();
   EXPECT_TRUE(checker->IsDependencyOf(&c_, &a_, &chain, &is_permitted));
   EXPECT_EQ(3u, chain.size());
   EXPECT_EQ(HeaderChecker::ChainLink(&c_, false), chain[0]);
@@ -197,46 +206,35 @@ TEST_F(HeaderCheckerTest, CheckInclude) {
 
   auto checker = CreateChecker();
 
-  std::set<std::pair<const Target*, const Target*>> no_dependency_cache;
   // A file in target A can't include a header from D because A has no
   // dependency on D.
   std::vector<Err> errors;
-  checker->CheckInclude(&a_, input_file, d_header, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&a_, input_file, d_header, range, &errors);
   EXPECT_GT(errors.size(), 0);
 
   // A can include the public header in B.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&a_, input_file, b_public, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&a_, input_file, b_public, range, &errors);
   EXPECT_EQ(errors.size(), 0);
 
   // Check A depending on the public and private headers in C.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&a_, input_file, c_public, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&a_, input_file, c_public, range, &errors);
   EXPECT_EQ(errors.size(), 0);
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&a_, input_file, c_private, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&a_, input_file, c_private, range, &errors);
   EXPECT_GT(errors.size(), 0);
 
   // A can depend on a random file unknown to the build.
   errors.clear();
-  no_dependency_cache.clear();
   checker->CheckInclude(&a_, input_file, SourceFile("//random.h"), range,
-                        &no_dependency_cache, &errors);
+                        &errors);
   EXPECT_EQ(errors.size(), 0);
 
   // A can depend on a file present only in another toolchain even with no
   // dependency path.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&a_, input_file, otc_header, range,
-                        &no_dependency_cache, &errors);
+  checker->CheckInclude(&a_, input_file, otc_header, range, &errors);
   EXPECT_EQ(errors.size(), 0);
 }
 
@@ -298,9 +296,7 @@ TEST_F(HeaderCheckerTest, CheckIncludeAllowCircular) {
 
   // A depends on B. So B normally can't include headers from A.
   std::vector<Err> errors;
-  std::set<std::pair<const Target*, const Target*>> no_dependency_cache;
-  checker->CheckInclude(&b_, input_file, a_public, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&b_, input_file, a_public, range, &errors);
   EXPECT_GT(errors.size(), 0);
 
   // Add an allow_circular_includes_from on A that lists B.
@@ -308,9 +304,7 @@ TEST_F(HeaderCheckerTest, CheckIncludeAllowCircular) {
 
   // Now the include from B to A should be allowed.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&b_, input_file, a_public, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&b_, input_file, a_public, range, &errors);
   EXPECT_EQ(errors.size(), 0);
 }
 
@@ -345,20 +339,15 @@ TEST_F(HeaderCheckerTest, CheckIncludeSwiftModule) {
   LocationRange range;  // Dummy value.
 
   std::vector<Err> errors;
-  std::set<std::pair<const Target*, const Target*>> no_dependency_cache;
 
   // Check that unrelated target D cannot include header generated by S.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&d_, input_file, generated_header, range,
-                        &no_dependency_cache, &errors);
+  checker->CheckInclude(&d_, input_file, generated_header, range, &errors);
   EXPECT_GT(errors.size(), 0);
 
   // Check that unrelated target D cannot include S's bridge header.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&d_, input_file, bridge_header, range,
-                        &no_dependency_cache, &errors);
+  checker->CheckInclude(&d_, input_file, bridge_header, range, &errors);
   EXPECT_GT(errors.size(), 0);
 }
 
@@ -461,15 +450,59 @@ TEST_F(HeaderCheckerTest, Friend) {
 
   // B should not be allowed to include C's private header.
   std::vector<Err> errors;
-  std::set<std::pair<const Target*, const Target*>> no_dependency_cache;
-  checker->CheckInclude(&b_, input_file, c_private, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&b_, input_file, c_private, range, &errors);
   EXPECT_GT(errors.size(), 0);
 
   // A should be able to because of the friend declaration.
   errors.clear();
-  no_dependency_cache.clear();
-  checker->CheckInclude(&a_, input_file, c_private, range, &no_dependency_cache,
-                        &errors);
+  checker->CheckInclude(&a_, input_file, c_private, range, &errors);
   EXPECT_EQ(errors.size(), 0);
 }
+
+TEST_F(HeaderCheckerTest, Incremental) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  setup_.build_settings()->SetRootPath(temp_dir.GetPath());
+  base::FilePath cache_path = temp_dir.GetPath().AppendASCII("cache");
+
+  // A's source includes a header of C, which it reaches publicly through B.
+  ASSERT_TRUE(base::CreateDirectory(temp_dir.GetPath().AppendASCII("a")));
+  std::string contents = "#include \"c/c.h\"\n";
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(temp_dir.GetPath().AppendASCII("a/a.cc"),
+                            contents.data(),
+                            static_cast<int>(contents.size())));
+  a_.sources().push_back(SourceFile("//a/a.cc"));
+  a_.config_values().include_dirs().push_back(SourceDir("//"));
+  c_.sources().push_back(SourceFile("//c/c.h"));
+
+  std::vector<const Target*> to_check = {&a_};
+  std::vector<Err> errors;
+  {
+    auto checker = CreateChecker();
+    checker->cache()->Load(cache_path);
+    EXPECT_TRUE(checker->Run(to_check, true, &errors));
+    EXPECT_EQ(0, checker->cache()->skipped_checks());
+    ASSERT_TRUE(checker->cache()->Save(cache_path));
+  }
+
+  // Nothing changed, so the check is skipped.
+  {
+    auto checker = CreateChecker();
+    checker->cache()->Load(cache_path);
+    EXPECT_TRUE(checker->Run(to_check, true, &errors));
+    EXPECT_EQ(1, checker->cache()->skipped_checks());
+    ASSERT_TRUE(checker->cache()->Save(cache_path));
+  }
+
+  // Making C a private dependency of B must make the include an error.
+  b_.public_deps().clear();
+  b_.private_deps().push_back(LabelTargetPair(&c_));
+  {
+    auto checker = CreateChecker();
+    checker->cache()->Load(cache_path);
+    EXPECT_FALSE(checker->Run(to_check, true, &errors));
+    EXPECT_EQ(0, checker->cache()->skipped_checks());
+    EXPECT_EQ(1u, errors.size());
+  }
+}
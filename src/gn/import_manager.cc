@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "gn/err.h"
+#include "gn/input_file.h"
 #include "gn/parse_tree.h"
 #include "gn/scheduler.h"
 #include "gn/scope_per_file_provider.h"
@@ -15,10 +16,16 @@
 
 namespace {
 
-// Returns a newly-allocated scope on success, null on failure.
+// Returns a newly-allocated scope on success, null on failure. When
+// |track_dependence| is set, |*toolchain_dependent| and |*variables| are set to
+// what the result depends on (see ToolchainDependence). Otherwise it's assumed
+// to depend on the toolchain.
 std::unique_ptr<Scope> UncachedImport(const Settings* settings,
                                       const SourceFile& file,
                                       const ParseNode* node_for_err,
+                                      bool track_dependence,
+                                      bool* toolchain_dependent,
+                                      ToolchainDependence::Variables* variables,
                                       Err* err) {
   ScopedTrace load_trace(TraceItem::TRACE_IMPORT_LOAD, file.value());
   load_trace.SetToolchain(settings->toolchain_label());
@@ -38,7 +45,12 @@ std::unique_ptr<Scope> UncachedImport(const Settings* settings,
   ScopePerFileProvider per_file_provider(scope.get(), false);
 
   scope->SetProcessingImport();
-  node->Execute(scope.get(), err);
+  {
+    ToolchainDependence dependence(track_dependence ? scope.get() : nullptr);
+    node->Execute(scope.get(), err);
+    *toolchain_dependent = !track_dependence || dependence.found();
+    *variables = dependence.TakeVariables();
+  }
   if (err->has_error()) {
     // If there was an error, append the caller location so the error message
     // displays a why the file was imported (esp. useful for failed asserts).
@@ -50,8 +62,63 @@ std::unique_ptr<Scope> UncachedImport(const Settings* settings,
   return scope;
 }
 
+// Returns a copy of the shared scope of an import for the given toolchain.
+std::unique_ptr<Scope> CopySharedImport(const Scope* shared_scope,
+                                        const Settings* settings,
+                                        const SourceFile& file) {
+  ScopedTrace copy_trace(TraceItem::TRACE_IMPORT_LOAD, file.value());
+  copy_trace.SetToolchain(settings->toolchain_label());
+
+  std::unique_ptr<Scope> scope =
+      std::make_unique<Scope>(settings->base_config());
+  scope->set_source_dir(file.GetDir());
+  shared_scope->CopyToNewContaining(scope.get());
+  return scope;
+}
+
 }  // namespace
 
+SharedImports::SharedImports() = default;
+
+SharedImports::~SharedImports() = default;
+
+const SharedImports::Variant* SharedImports::Lookup(const SourceFile& file,
+                                                    const Scope* base_config) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto found = variants_.find(file);
+  if (found == variants_.end())
+    return nullptr;
+
+  for (const auto& variant : found->second) {
+    bool valid = true;
+    for (const auto& [name, expected] : variant->variables) {
+      const Value* value = base_config->GetValue(name);
+      if (expected.type() == Value::NONE ? value != nullptr
+                                         : !value || *value != expected) {
+        valid = false;
+        break;
+      }
+    }
+    if (valid)
+      return variant.get();
+  }
+  return nullptr;
+}
+
+void SharedImports::Publish(const SourceFile& file,
+                            const Scope* scope,
+                            ToolchainDependence::Variables variables) {
+  std::lock_guard<std::mutex> lock(lock_);
+  std::vector<std::unique_ptr<Variant>>& variants = variants_[file];
+  // Toolchains rarely differ in more than a few ways, so this only happens
+  // when an import reads something like a per-toolchain list of flags.
+  constexpr size_t kMaxVariants = 8;
+  if (variants.size() < kMaxVariants) {
+    variants.push_back(
+        std::make_unique<Variant>(Variant{scope, std::move(variables)}));
+  }
+}
+
 struct ImportManager::ImportInfo {
   ImportInfo() = default;
   ~ImportInfo() = default;
@@ -66,6 +133,11 @@ struct ImportManager::ImportInfo {
   // null but this will be set to error. In this case the thread should not
   // attempt to load the file, even if the scope is null.
   Err load_result;
+
+  // What the scope depends on, so that the imports importing it depend on it
+  // too (see ToolchainDependence).
+  bool toolchain_dependent = true;
+  ToolchainDependence::Variables variables;
 };
 
 ImportManager::ImportManager() = default;
@@ -93,6 +165,10 @@ bool ImportManager::DoImport(const SourceFile& file,
     // Promote the ImportInfo to outside of the imports lock.
     import_info = info_ptr.get();
 
+    const InputFile* importer = node_for_err->GetRange().begin().file();
+    if (importer)
+      import_edges_.emplace(importer->name(), file);
+
     if (imports_in_progress_.find(key) != imports_in_progress_.end()) {
       *err = Err(Location(), file.value() + " is part of an import loop.");
       return false;
@@ -109,10 +185,8 @@ bool ImportManager::DoImport(const SourceFile& file,
 
     if (!import_info->scope) {
       // Only load if the import hasn't already failed.
-      if (!import_info->load_result.has_error()) {
-        import_info->scope = UncachedImport(
-            scope->settings(), file, node_for_err, &import_info->load_result);
-      }
+      if (!import_info->load_result.has_error())
+        LoadImport(import_info, file, node_for_err, scope->settings());
       if (import_info->load_result.has_error()) {
         *err = import_info->load_result;
         return false;
@@ -138,6 +212,8 @@ bool ImportManager::DoImport(const SourceFile& file,
 
     // Promote the now-read-only scope to outside the load lock.
     import_scope = import_info->scope.get();
+    ToolchainDependence::OnImport(import_info->toolchain_dependent,
+                                  import_info->variables);
   }
 
   Scope::MergeOptions options;
@@ -153,6 +229,38 @@ bool ImportManager::DoImport(const SourceFile& file,
                                            "import", err);
 }
 
+void ImportManager::LoadImport(ImportInfo* import_info,
+                               const SourceFile& file,
+                               const ParseNode* node_for_err,
+                               const Settings* settings) {
+  SharedImports* shared_imports = g_scheduler->shared_imports();
+  if (shared_imports) {
+    if (const SharedImports::Variant* variant =
+            shared_imports->Lookup(file, settings->base_config())) {
+      import_info->scope = CopySharedImport(variant->scope, settings, file);
+      import_info->toolchain_dependent = false;
+      import_info->variables = variant->variables;
+      AddTraceCounter("imports.shared_reused", 1);
+      return;
+    }
+  }
+
+  import_info->scope = UncachedImport(
+      settings, file, node_for_err, shared_imports != nullptr,
+      &import_info->toolchain_dependent, &import_info->variables,
+      &import_info->load_result);
+  if (!shared_imports || !import_info->scope)
+    return;
+
+  if (import_info->toolchain_dependent) {
+    AddTraceCounter("imports.toolchain_dependent", 1);
+  } else {
+    AddTraceCounter("imports.shared_executed", 1);
+    shared_imports->Publish(file, import_info->scope.get(),
+                            import_info->variables);
+  }
+}
+
 std::vector<SourceFile> ImportManager::GetImportedFiles() const {
   std::vector<SourceFile> imported_files;
   imported_files.resize(imports_.size());
@@ -160,3 +268,9 @@ std::vector<SourceFile> ImportManager::GetImportedFiles() const {
                  [](const ImportMap::value_type& val) { return val.first; });
   return imported_files;
 }
+
+std::vector<std::pair<SourceFile, SourceFile>> ImportManager::GetImportEdges()
+    const {
+  return std::vector<std::pair<SourceFile, SourceFile>>(import_edges_.begin(),
+                                                        import_edges_.end());
+}
@@ -8,14 +8,57 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "gn/scope.h"
+#include "gn/source_file.h"
+
 class Err;
 class ParseNode;
-class Scope;
-class SourceFile;
+class Settings;
+
+// The results of the imports shared by the toolchains (see the
+// --share-imports switch).
+//
+// A toolchain importing a file tracks what its execution depends on (see
+// ToolchainDependence) and publishes the resulting scope, unless it depends on
+// the toolchain in a way that can't be checked. The other toolchains then copy
+// a published scope instead of executing the file again, provided that the
+// variables it read from the build config have the same values for them.
+// Toolchains don't wait for another one executing the same file, which would
+// risk deadlocks between toolchains importing each other's files.
+class SharedImports {
+ public:
+  // An executed import, and the variables its result depends on.
+  struct Variant {
+    const Scope* scope;
+    ToolchainDependence::Variables variables;
+  };
+
+  SharedImports();
+  ~SharedImports();
+
+  // Returns a published result of the given import that is valid for a
+  // toolchain with the given build config, or null.
+  const Variant* Lookup(const SourceFile& file, const Scope* base_config);
+
+  // Publishes the result of the given import, whose scope is owned by the
+  // ImportManager of the toolchain that executed it.
+  void Publish(const SourceFile& file,
+               const Scope* scope,
+               ToolchainDependence::Variables variables);
+
+ private:
+  std::mutex lock_;
+  std::map<SourceFile, std::vector<std::unique_ptr<Variant>>> variants_;
+
+  SharedImports(const SharedImports&) = delete;
+  SharedImports& operator=(const SharedImports&) = delete;
+};
 
 // Provides a cache of the results of importing scopes so the results can
 // be re-used rather than running the imported files multiple times.
@@ -33,11 +76,22 @@ class ImportManager {
 
   std::vector<SourceFile> GetImportedFiles() const;
 
+  // Returns a (importing file, imported file) pair for every import done
+  // through this manager, including ones satisfied from the cache.
+  std::vector<std::pair<SourceFile, SourceFile>> GetImportEdges() const;
+
  private:
   struct ImportInfo;
 
-  // Protects access to imports_ and imports_in_progress_. Do not hold when
-  // actually executing imports.
+  // Sets the scope of the given import, or its load_result on failure, by
+  // executing the file or copying the scope shared by another toolchain.
+  void LoadImport(ImportInfo* import_info,
+                  const SourceFile& file,
+                  const ParseNode* node_for_err,
+                  const Settings* settings);
+
+  // Protects access to imports_, imports_in_progress_ and import_edges_. Do
+  // not hold when actually executing imports.
   std::mutex imports_lock_;
 
   // Owning pointers to the scopes.
@@ -46,6 +100,8 @@ class ImportManager {
 
   std::unordered_set<std::string> imports_in_progress_;
 
+  std::set<std::pair<SourceFile, SourceFile>> import_edges_;
+
   ImportManager(const ImportManager&) = delete;
   ImportManager& operator=(const ImportManager&) = delete;
 };
@@ -0,0 +1,192 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/import_manager.h"
+
+#include <map>
+#include <string>
+
+#include "gn/build_settings.h"
+#include "gn/input_file.h"
+#include "gn/scope.h"
+#include "gn/settings.h"
+#include "gn/test_with_scheduler.h"
+#include "gn/test_with_scope.h"
+#include "util/test/test.h"
+
+namespace {
+
+BuildSettings CreateBuildSettingsForTest() {
+  BuildSettings build_settings;
+  build_settings.SetBuildDir(SourceDir("//out/Debug/"));
+  return build_settings;
+}
+
+class ImportManagerTest : public TestWithScheduler {
+ public:
+  ImportManagerTest()
+      : build_settings_(CreateBuildSettingsForTest()),
+        settings_a_(&build_settings_, "a/"),
+        settings_b_(&build_settings_, "b/"),
+        settings_c_(&build_settings_, "c/") {
+    build_settings_.set_print_callback(
+        [this](const std::string& str) { print_output_ += str; });
+    settings_a_.set_toolchain_label(Label(SourceDir("//tc/"), "a"));
+    settings_b_.set_toolchain_label(Label(SourceDir("//tc/"), "b"));
+    settings_c_.set_toolchain_label(Label(SourceDir("//tc/"), "c"));
+    settings_a_.base_config()->SetValue("is_a", Value(nullptr, true), nullptr);
+    settings_b_.base_config()->SetValue("is_a", Value(nullptr, false),
+                                        nullptr);
+    settings_c_.base_config()->SetValue("is_a", Value(nullptr, true), nullptr);
+
+    scheduler().input_file_manager()->set_load_file_callback(
+        [this](const SourceFile& name, InputFile* file) {
+          auto found = files_.find(name.value());
+          if (found == files_.end())
+            return false;
+          file->SetContents(found->second);
+          return true;
+        });
+    scheduler().set_share_imports(true);
+  }
+
+  ~ImportManagerTest() override {
+    scheduler().input_file_manager()->set_load_file_callback(nullptr);
+  }
+
+ protected:
+  void AddFile(const std::string& name, const std::string& contents) {
+    files_[name] = contents;
+  }
+
+  // Executes the given program in a scope of the given toolchain and returns
+  // the printed output.
+  std::string Execute(const Settings& settings, const std::string& program) {
+    print_output_.clear();
+    TestParseInput input(program);
+    EXPECT_FALSE(input.has_error()) << program;
+    Scope scope(settings.base_config());
+    scope.set_source_dir(SourceDir("//"));
+    Err err;
+    input.parsed()->Execute(&scope, &err);
+    EXPECT_FALSE(err.has_error()) << err.message();
+    return print_output_;
+  }
+
+  // Returns the value of the given variable in the shared result of the given
+  // import for the given toolchain, or "not shared".
+  std::string GetShared(const Settings& settings,
+                        const std::string& name,
+                        const std::string& variable) {
+    const SharedImports::Variant* variant =
+        scheduler().shared_imports()->Lookup(SourceFile(name),
+                                             settings.base_config());
+    if (!variant)
+      return "not shared";
+    const Value* value = variant->scope->GetValue(variable);
+    return value ? value->ToString(false) : "undefined";
+  }
+
+  BuildSettings build_settings_;
+  Settings settings_a_;
+  Settings settings_b_;
+  Settings settings_c_;
+
+ private:
+  std::map<std::string, std::string> files_;
+  std::string print_output_;
+};
+
+}  // namespace
+
+TEST_F(ImportManagerTest, SharesImports) {
+  AddFile("//independent.gni",
+          "i = 1\n"
+          "b = [ i ]\n");
+  AddFile("//variable.gni", "v = is_a\n");
+  AddFile("//undefined.gni",
+          "if (defined(is_b)) {\n"
+          "  u = is_b\n"
+          "}\n");
+  AddFile("//builtin.gni", "t = current_toolchain\n");
+  AddFile("//function.gni", "f = get_path_info(\"x.cc\", \"gen_dir\")\n");
+  AddFile("//nested_variable.gni", "import(\"//variable.gni\")\n");
+  AddFile("//nested_builtin.gni", "import(\"//builtin.gni\")\n");
+
+  const char* imports[] = {"//independent.gni",    "//variable.gni",
+                           "//undefined.gni",      "//builtin.gni",
+                           "//function.gni",       "//nested_variable.gni",
+                           "//nested_builtin.gni"};
+  for (const char* import : imports) {
+    std::string program = std::string("import(\"") + import + "\")\n";
+    Execute(settings_a_, program);
+    Execute(settings_b_, program);
+  }
+
+  EXPECT_EQ("[1]", GetShared(settings_c_, "//independent.gni", "b"));
+  EXPECT_EQ("true", GetShared(settings_c_, "//variable.gni", "v"));
+  EXPECT_EQ("false", GetShared(settings_b_, "//variable.gni", "v"));
+  EXPECT_EQ("undefined", GetShared(settings_c_, "//undefined.gni", "u"));
+  EXPECT_EQ("not shared", GetShared(settings_c_, "//builtin.gni", "t"));
+  EXPECT_EQ("not shared", GetShared(settings_c_, "//function.gni", "f"));
+  EXPECT_EQ("true", GetShared(settings_c_, "//nested_variable.gni", "v"));
+  EXPECT_EQ("not shared", GetShared(settings_c_, "//nested_builtin.gni", "t"));
+
+  // A toolchain defining a variable that an import only checked is undefined
+  // doesn't reuse its result.
+  settings_c_.base_config()->SetValue("is_b", Value(nullptr, true), nullptr);
+  EXPECT_EQ("not shared", GetShared(settings_c_, "//undefined.gni", "u"));
+
+  EXPECT_EQ("[1] true true //tc:c\n",
+            Execute(settings_c_,
+                    "import(\"//independent.gni\")\n"
+                    "import(\"//nested_variable.gni\")\n"
+                    "import(\"//undefined.gni\")\n"
+                    "import(\"//builtin.gni\")\n"
+                    "print(b, v, u, t)\n"));
+}
+
+TEST_F(ImportManagerTest, SharedTemplatesSeeTheirToolchain) {
+  AddFile("//template.gni",
+          "template(\"t\") {\n"
+          "  not_needed([ \"invoker\" ])\n"
+          "  print(target_name, is_a)\n"
+          "}\n");
+
+  const char program[] =
+      "import(\"//template.gni\")\n"
+      "t(\"x\") {\n"
+      "}\n";
+  EXPECT_EQ("x true\n", Execute(settings_a_, program));
+  EXPECT_NE("not shared", GetShared(settings_b_, "//template.gni", "t"));
+  EXPECT_EQ("x false\n", Execute(settings_b_, program));
+}
+
+TEST_F(ImportManagerTest, ImportsInvokingTemplatesAreNotShared) {
+  // Templates defined by the build config, rather than by an import, are
+  // different objects in each toolchain.
+  TestParseInput definition(
+      "template(\"t\") {\n"
+      "  not_needed([ \"invoker\" ])\n"
+      "}\n");
+  ASSERT_FALSE(definition.has_error());
+  AddFile("//invoke.gni",
+          "t(\"x\") {\n"
+          "}\n");
+
+  TestParseInput program("import(\"//invoke.gni\")\n");
+  ASSERT_FALSE(program.has_error());
+  for (Settings* settings : {&settings_a_, &settings_b_}) {
+    Err err;
+    definition.parsed()->Execute(settings->base_config(), &err);
+    ASSERT_FALSE(err.has_error()) << err.message();
+
+    Scope scope(settings->base_config());
+    scope.set_source_dir(SourceDir("//"));
+    program.parsed()->Execute(&scope, &err);
+    ASSERT_TRUE(err.has_error());
+    EXPECT_EQ("Not valid from an import.", err.message());
+    EXPECT_EQ("not shared", GetShared(*settings, "//invoke.gni", "t"));
+  }
+}
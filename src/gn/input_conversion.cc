@@ -33,7 +33,7 @@ enum ValueOrScope {
 
 // Sets the origin of the value and any nested values with the given node.
 Value ParseValueOrScope(const Settings* settings,
-                        const std::string& input,
+                        std::string_view input,
                         ValueOrScope what,
                         const ParseNode* origin,
                         Err* err) {
@@ -90,7 +90,7 @@ Value ParseValueOrScope(const Settings* settings,
   return result;
 }
 
-Value ParseList(const std::string& input, const ParseNode* origin, Err* err) {
+Value ParseList(std::string_view input, const ParseNode* origin, Err* err) {
   Value ret(origin, Value::LIST);
   std::vector<std::string> as_lines = base::SplitString(
       input, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
@@ -173,7 +173,7 @@ Value ParseJSONValue(const Settings* settings,
 
 // Parses the JSON string and converts it to GN value.
 Value ParseJSON(const Settings* settings,
-                const std::string& input,
+                std::string_view input,
                 const ParseNode* origin,
                 Err* err) {
   InputFile* input_file;
@@ -201,7 +201,7 @@ Value ParseJSON(const Settings* settings,
 // "trim" prefix. This original value is also kept for the purposes of throwing
 // errors.
 Value DoConvertInputToValue(const Settings* settings,
-                            const std::string& input,
+                            std::string_view input,
                             const ParseNode* origin,
                             const Value& original_input_conversion,
                             const std::string& input_conversion,
@@ -211,8 +211,8 @@ Value DoConvertInputToValue(const Settings* settings,
 
   const char kTrimPrefix[] = "trim ";
   if (input_conversion.starts_with(kTrimPrefix)) {
-    std::string trimmed;
-    base::TrimWhitespaceASCII(input, base::TRIM_ALL, &trimmed);
+    std::string_view trimmed =
+        base::TrimWhitespaceASCII(input, base::TRIM_ALL);
 
     // Remove "trim" prefix from the input conversion and re-run.
     return DoConvertInputToValue(
@@ -223,7 +223,7 @@ Value DoConvertInputToValue(const Settings* settings,
   if (input_conversion == "value")
     return ParseValueOrScope(settings, input, PARSE_VALUE, origin, err);
   if (input_conversion == "string")
-    return Value(origin, input);
+    return Value(origin, std::string(input));
   if (input_conversion == "list lines")
     return ParseList(input, origin, err);
   if (input_conversion == "scope")
@@ -344,7 +344,7 @@ const char kInputOutputConversion_Help[] =
 )";
 
 Value ConvertInputToValue(const Settings* settings,
-                          const std::string& input,
+                          std::string_view input,
                           const ParseNode* origin,
                           const Value& input_conversion_value,
                           Err* err) {
@@ -5,7 +5,7 @@
 #ifndef TOOLS_GN_INPUT_CONVERSION_H_
 #define TOOLS_GN_INPUT_CONVERSION_H_
 
-#include <string>
+#include <string_view>
 
 class Err;
 class ParseNode;
@@ -22,7 +22,7 @@ extern const char kInputOutputConversion_Help[];
 // If the conversion string is invalid, the error will be set and an empty
 // value will be returned.
 Value ConvertInputToValue(const Settings* settings,
-                          const std::string& input,
+                          std::string_view input,
                           const ParseNode* origin,
                           const Value& input_conversion_value,
                           Err* err);
@@ -4,23 +4,97 @@
 
 #include "gn/input_file.h"
 
-#include "base/files/file_util.h"
+#include <limits.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "base/files/file.h"
+#include "util/build_config.h"
+
+#if defined(OS_POSIX)
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+bool g_mapping_enabled = true;
+
+// Reads the rest of the file, whose size is expected to be |size_hint|.
+bool ReadFile(base::File* file, int64_t size_hint, std::string* contents) {
+  // Files like those in /proc may be bigger than they say, so read until
+  // the end of the file is reached.
+  size_t size = 0;
+  contents->resize(static_cast<size_t>(std::max<int64_t>(size_hint, 0)) + 1);
+  for (;;) {
+    if (size == contents->size())
+      contents->resize(size * 2);
+    int read = file->ReadAtCurrentPos(
+        &(*contents)[size], static_cast<int>(std::min<size_t>(
+                                contents->size() - size, INT_MAX)));
+    if (read < 0)
+      return false;
+    if (read == 0)
+      break;
+    size += read;
+  }
+  contents->resize(size);
+  return true;
+}
+
+}  // namespace
 
 InputFile::InputFile(const SourceFile& name)
     : name_(name), dir_(name_.GetDir()) {}
 
-InputFile::~InputFile() = default;
+InputFile::~InputFile() {
+#if defined(OS_POSIX)
+  if (mapped_data_)
+    munmap(mapped_data_, mapped_size_);
+#endif
+}
 
-void InputFile::SetContents(const std::string& c) {
+void InputFile::SetContents(std::string_view c) {
+  DCHECK(!mapped_data_);
   contents_loaded_ = true;
-  contents_ = c;
+  owned_contents_ = c;
+  contents_ = owned_contents_;
 }
 
 bool InputFile::Load(const base::FilePath& system_path) {
-  if (base::ReadFileToString(system_path, &contents_)) {
-    contents_loaded_ = true;
-    physical_name_ = system_path;
-    return true;
+  DCHECK(!mapped_data_);
+  if (system_path.ReferencesParent())
+    return false;
+  base::File file(system_path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid())
+    return false;
+  int64_t length = file.GetLength();
+
+#if defined(OS_POSIX)
+  if (g_mapping_enabled && length >= static_cast<int64_t>(kMinMappedSize)) {
+    void* mapped = mmap(nullptr, static_cast<size_t>(length), PROT_READ,
+                        MAP_PRIVATE, file.GetPlatformFile(), 0);
+    if (mapped != MAP_FAILED) {
+      mapped_data_ = mapped;
+      mapped_size_ = static_cast<size_t>(length);
+      contents_loaded_ = true;
+      contents_ = std::string_view(static_cast<const char*>(mapped_data_),
+                                   mapped_size_);
+      physical_name_ = system_path;
+      return true;
+    }
   }
-  return false;
+#endif
+
+  if (!ReadFile(&file, length, &owned_contents_))
+    return false;
+  contents_loaded_ = true;
+  contents_ = owned_contents_;
+  physical_name_ = system_path;
+  return true;
+}
+
+// static
+void InputFile::DisableMapping() {
+  g_mapping_enabled = false;
 }
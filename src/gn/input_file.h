@@ -5,7 +5,10 @@
 #ifndef TOOLS_GN_INPUT_FILE_H_
 #define TOOLS_GN_INPUT_FILE_H_
 
+#include <stddef.h>
+
 #include <string>
+#include <string_view>
 
 #include "base/files/file_path.h"
 #include "base/logging.h"
@@ -36,18 +39,31 @@ class InputFile {
   const std::string& friendly_name() const { return friendly_name_; }
   void set_friendly_name(const std::string& f) { friendly_name_ = f; }
 
-  const std::string& contents() const {
+  // The contents stay at the same address for the lifetime of the InputFile,
+  // so tokens and values can point into them.
+  std::string_view contents() const {
     DCHECK(contents_loaded_);
     return contents_;
   }
 
   // For testing and in cases where this input doesn't actually refer to
   // "a file".
-  void SetContents(const std::string& c);
-
-  // Loads the given file synchronously, returning true on success. This
+  void SetContents(std::string_view c);
+
+  // Loads the given file synchronously, returning true on success.
+  //
+  // On POSIX, files of at least kMinMappedSize bytes are mapped in memory
+  // instead of being copied, which mostly matters for large generated .gni
+  // files and read_file() inputs. Like any mapping, this assumes the file is
+  // not truncated while GN runs.
   bool Load(const base::FilePath& system_path);
 
+  static constexpr size_t kMinMappedSize = 64 * 1024;
+
+  // Makes Load() always read files. For long-running processes, during which
+  // files can be truncated. Must be called before any file is loaded.
+  static void DisableMapping();
+
  private:
   SourceFile name_;
   SourceDir dir_;
@@ -56,7 +72,14 @@ class InputFile {
   std::string friendly_name_;
 
   bool contents_loaded_ = false;
-  std::string contents_;
+  std::string_view contents_;
+
+  // Where contents_ points, unless the file is mapped.
+  std::string owned_contents_;
+
+  // The mapping of the file, if any.
+  void* mapped_data_ = nullptr;
+  size_t mapped_size_ = 0;
 
   InputFile(const InputFile&) = delete;
   InputFile& operator=(const InputFile&) = delete;
@@ -4,11 +4,15 @@
 
 #include "gn/input_file_manager.h"
 
+#include <stdint.h>
+
 #include <memory>
 #include <utility>
 
 #include "base/stl_util.h"
 #include "gn/filesystem_utils.h"
+#include "gn/parse_cache.h"
+#include "gn/parse_node_arena.h"
 #include "gn/parser.h"
 #include "gn/scheduler.h"
 #include "gn/scope_per_file_provider.h"
@@ -18,17 +22,6 @@
 
 namespace {
 
-// The opposite of std::lock_guard.
-struct ScopedUnlock {
-  ScopedUnlock(std::unique_lock<std::mutex>& lock) : lock_(lock) {
-    lock_.unlock();
-  }
-  ~ScopedUnlock() { lock_.lock(); }
-
- private:
-  std::unique_lock<std::mutex>& lock_;
-};
-
 void InvokeFileLoadCallback(const InputFileManager::FileLoadCallback& cb,
                             const ParseNode* node) {
   cb(node);
@@ -38,8 +31,9 @@ bool DoLoadFile(const LocationRange& origin,
                 const BuildSettings* build_settings,
                 const SourceFile& name,
                 InputFileManager::SyncLoadFileCallback load_file_callback,
+                const ParseCache* parse_cache,
                 InputFile* file,
-                std::vector<Token>* tokens,
+                ParseNodeArena* arena,
                 std::unique_ptr<ParseNode>* root,
                 Err* err) {
   // Do all of this stuff outside the lock. We should not give out file
@@ -82,16 +76,38 @@ bool DoLoadFile(const LocationRange& origin,
   load_trace.Done();
 
   ScopedTrace exec_trace(TraceItem::TRACE_FILE_PARSE, name.value());
+  ParseNodeArena::Scope arena_scope(arena);
+
+  // A cached tree points directly into the file contents, so no tokens need
+  // to be kept around for it.
+  std::string cache_key;
+  if (parse_cache) {
+    cache_key = ParseCache::GetKey(*file);
+    *root = parse_cache->Lookup(cache_key, file);
+    AddTraceCounter(*root ? "parse_cache.hits" : "parse_cache.misses", 1);
+    if (*root) {
+      exec_trace.Done();
+      return true;
+    }
+  }
 
-  // Tokenize.
-  *tokens = Tokenizer::Tokenize(file, err);
+  // Tokenize. The nodes copy the tokens they need, so the tokens are freed
+  // once parsed.
+  ScopedTrace tokenize_trace(TraceItem::TRACE_FILE_TOKENIZE, name.value());
+  std::vector<Token> tokens = Tokenizer::Tokenize(file, err);
+  tokenize_trace.Done();
   if (err->has_error())
     return false;
 
   // Parse.
-  *root = Parser::Parse(*tokens, err);
-  if (err->has_error())
+  *root = Parser::Parse(tokens, err);
+  if (err->has_error()) {
+    root->reset();
     return false;
+  }
+
+  if (parse_cache)
+    parse_cache->Store(cache_key, file, root->get());
 
   exec_trace.Done();
   return true;
@@ -102,7 +118,11 @@ bool DoLoadFile(const LocationRange& origin,
 InputFileManager::InputFileData::InputFileData(const SourceFile& file_name)
     : file(file_name), loaded(false), sync_invocation(false) {}
 
-InputFileManager::InputFileData::~InputFileData() = default;
+InputFileManager::InputFileData::~InputFileData() {
+  // The nodes are released with the arena.
+  ParseNodeArena::Scope arena_scope(arena.get());
+  parsed_root.reset();
+}
 
 InputFileManager::InputFileManager() = default;
 
@@ -110,6 +130,36 @@ InputFileManager::~InputFileManager() {
   // Should be single-threaded by now.
 }
 
+InputFileManager::Shard& InputFileManager::GetShard(
+    const SourceFile& name) const {
+  // The hash of a SourceFile is the address of its string, whose low bits
+  // hardly vary, so use the high bits of a multiplicative hash of it.
+  static_assert(kShardCount == 16);
+  uint64_t hash = std::hash<SourceFile>()(name) * 0x9E3779B97F4A7C15ull;
+  return shards_[hash >> 60];
+}
+
+// static
+std::unique_lock<std::mutex> InputFileManager::LockShard(Shard& shard) {
+  std::unique_lock<std::mutex> lock(shard.lock, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    shard.lock_contention.fetch_add(1, std::memory_order_relaxed);
+    lock.lock();
+  }
+  return lock;
+}
+
+int64_t InputFileManager::TakeLockContention() {
+  int64_t total = 0;
+  for (Shard& shard : shards_)
+    total += shard.lock_contention.exchange(0, std::memory_order_relaxed);
+  return total;
+}
+
+void InputFileManager::set_parse_cache(std::unique_ptr<ParseCache> cache) {
+  parse_cache_ = std::move(cache);
+}
+
 bool InputFileManager::AsyncLoadFile(const LocationRange& origin,
                                      const BuildSettings* build_settings,
                                      const SourceFile& file_name,
@@ -120,10 +170,11 @@ bool InputFileManager::AsyncLoadFile(const LocationRange& origin,
   // after we leave the lock.
   std::function<void()> schedule_this;
   {
-    std::lock_guard<std::mutex> lock(lock_);
+    Shard& shard = GetShard(file_name);
+    std::unique_lock<std::mutex> lock = LockShard(shard);
 
-    InputFileMap::const_iterator found = input_files_.find(file_name);
-    if (found == input_files_.end()) {
+    InputFileMap::const_iterator found = shard.input_files.find(file_name);
+    if (found == shard.input_files.end()) {
       // New file, schedule load.
       std::unique_ptr<InputFileData> data =
           std::make_unique<InputFileData>(file_name);
@@ -132,7 +183,7 @@ bool InputFileManager::AsyncLoadFile(const LocationRange& origin,
                        file = &data->file]() {
         BackgroundLoadFile(origin, build_settings, file_name, file);
       };
-      input_files_[file_name] = std::move(data);
+      shard.input_files[file_name] = std::move(data);
 
     } else {
       InputFileData* data = found->second.get();
@@ -152,7 +203,7 @@ bool InputFileManager::AsyncLoadFile(const LocationRange& origin,
         return false;
       }
 
-      if (data->loaded) {
+      if (data->loaded.load(std::memory_order_relaxed)) {
         // Can just directly issue the callback on the background thread.
         schedule_this = [callback, root = data->parsed_root.get()]() {
           InvokeFileLoadCallback(callback, root);
@@ -173,24 +224,26 @@ const ParseNode* InputFileManager::SyncLoadFile(
     const BuildSettings* build_settings,
     const SourceFile& file_name,
     Err* err) {
-  std::unique_lock<std::mutex> lock(lock_);
+  Shard& shard = GetShard(file_name);
+  std::unique_lock<std::mutex> lock = LockShard(shard);
 
   InputFileData* data = nullptr;
-  InputFileMap::iterator found = input_files_.find(file_name);
-  if (found == input_files_.end()) {
+  InputFileMap::iterator found = shard.input_files.find(file_name);
+  if (found == shard.input_files.end()) {
     // Haven't seen this file yet, start loading right now.
     std::unique_ptr<InputFileData> new_data =
         std::make_unique<InputFileData>(file_name);
     data = new_data.get();
     data->sync_invocation = true;
-    input_files_[file_name] = std::move(new_data);
+    shard.input_files[file_name] = std::move(new_data);
 
-    ScopedUnlock unlock(lock);
+    lock.unlock();
     if (!LoadFile(origin, build_settings, file_name, &data->file, err))
       return nullptr;
   } else {
     // This file has either been loaded or is pending loading.
     data = found->second.get();
+    lock.unlock();
 
     if (!data->sync_invocation) {
       // Don't allow mixing of sync and async loads. If an async load is
@@ -220,18 +273,10 @@ const ParseNode* InputFileManager::SyncLoadFile(
       return nullptr;
     }
 
-    if (!data->loaded) {
+    if (!data->loaded.load(std::memory_order_acquire)) {
       // Wait for the already-pending sync load to complete.
-      if (!data->completion_event) {
-        data->completion_event = std::make_unique<AutoResetEvent>();
-      }
-      {
-        ScopedUnlock unlock(lock);
-        data->completion_event->Wait();
-      }
-      // If there were multiple waiters on the same event, we now need to wake
-      // up the next one.
-      data->completion_event->Signal();
+      AddTraceCounter("input_files.load_waits", 1);
+      data->loaded.wait(false, std::memory_order_acquire);
     }
   }
 
@@ -260,17 +305,50 @@ void InputFileManager::AddDynamicInput(
 }
 
 int InputFileManager::GetInputFileCount() const {
-  std::lock_guard<std::mutex> lock(lock_);
-  return static_cast<int>(input_files_.size());
+  size_t count = 0;
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    count += shard.input_files.size();
+  }
+  return static_cast<int>(count);
 }
 
 void InputFileManager::AddAllPhysicalInputFileNamesToVectorSetSorter(
     VectorSetSorter<base::FilePath>* sorter) const {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (const auto& file : shard.input_files) {
+      if (!file.second->file.physical_name().empty())
+        sorter->Add(file.second->file.physical_name());
+    }
+  }
+}
+
+std::vector<const InputFile*> InputFileManager::GetLoadedPhysicalInputFiles()
+    const {
+  std::vector<const InputFile*> result;
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (const auto& file : shard.input_files) {
+      if (file.second->loaded.load(std::memory_order_relaxed) &&
+          !file.second->file.physical_name().empty())
+        result.push_back(&file.second->file);
+    }
+  }
+  return result;
+}
+
+void InputFileManager::InvalidateFiles(const std::vector<SourceFile>& files) {
   std::lock_guard<std::mutex> lock(lock_);
 
-  for (const auto& file : input_files_) {
-    if (!file.second->file.physical_name().empty())
-      sorter->Add(file.second->file.physical_name());
+  for (const SourceFile& name : files) {
+    Shard& shard = GetShard(name);
+    std::lock_guard<std::mutex> shard_lock(shard.lock);
+    auto found = shard.input_files.find(name);
+    if (found == shard.input_files.end())
+      continue;
+    invalidated_inputs_.push_back(std::move(found->second));
+    shard.input_files.erase(found);
   }
 }
 
@@ -288,48 +366,45 @@ bool InputFileManager::LoadFile(const LocationRange& origin,
                                 const SourceFile& name,
                                 InputFile* file,
                                 Err* err) {
-  std::vector<Token> tokens;
+  // The arena must outlive the nodes allocated from it.
+  auto arena = std::make_unique<ParseNodeArena>();
   std::unique_ptr<ParseNode> root;
-  bool success = DoLoadFile(origin, build_settings, name, load_file_callback_,
-                            file, &tokens, &root, err);
-  // Can't return early. We have to ensure that the completion event is
-  // signaled in all cases because another thread could be blocked on this one.
+  bool success =
+      DoLoadFile(origin, build_settings, name, load_file_callback_,
+                 parse_cache_.get(), file, arena.get(), &root, err);
+  if (success) {
+    AddTraceCounter("parse_arena.allocations", arena->allocation_count());
+    AddTraceCounter("parse_arena.bytes", arena->allocated_bytes());
+  }
+  // Can't return early. We have to ensure that the file is marked loaded in
+  // all cases because another thread could be blocked on this one.
 
   // Save this pointer for running the callbacks below, which happens after the
   // scoped ptr ownership is taken away inside the lock.
   ParseNode* unowned_root = root.get();
 
+  InputFileData* data = nullptr;
   std::vector<FileLoadCallback> callbacks;
   {
-    std::lock_guard<std::mutex> lock(lock_);
-    DCHECK(input_files_.find(name) != input_files_.end());
+    Shard& shard = GetShard(name);
+    std::unique_lock<std::mutex> lock = LockShard(shard);
+    DCHECK(shard.input_files.find(name) != shard.input_files.end());
 
-    InputFileData* data = input_files_[name].get();
-    data->loaded = true;
+    data = shard.input_files[name].get();
     if (success) {
-      data->tokens = std::move(tokens);
+      data->arena = std::move(arena);
       data->parsed_root = std::move(root);
     } else {
       data->parse_error = *err;
     }
-
-    // Unblock waiters on this event.
-    //
-    // It's somewhat bad to signal this inside the lock. When it's used, it's
-    // lazily created inside the lock. So we need to do the check and signal
-    // inside the lock to avoid race conditions on the lazy creation of the
-    // lock.
-    //
-    // We could avoid this by creating the lock every time, but the lock is
-    // very seldom used and will generally be NULL, so my current theory is that
-    // several signals of a completion event inside a lock is better than
-    // creating about 1000 extra locks (one for each file).
-    if (data->completion_event)
-      data->completion_event->Signal();
-
     callbacks = std::move(data->scheduled_callbacks);
+    data->loaded.store(true, std::memory_order_release);
   }
 
+  // Unblock the threads waiting for this load in SyncLoadFile(). The data
+  // outlives the run, even if the file is invalidated.
+  data->loaded.notify_all();
+
   // Run pending invocations. Theoretically we could schedule each of these
   // separately to get some parallelism. But normally there will only be one
   // item in the list, so that's extra overhead and complexity for no gain.
@@ -5,7 +5,10 @@
 #ifndef TOOLS_GN_INPUT_FILE_MANAGER_H_
 #define TOOLS_GN_INPUT_FILE_MANAGER_H_
 
+#include <array>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <unordered_map>
@@ -18,12 +21,13 @@
 #include "gn/parse_tree.h"
 #include "gn/settings.h"
 #include "gn/vector_utils.h"
-#include "util/auto_reset_event.h"
 
 class BuildSettings;
 class Err;
 class LocationRange;
+class ParseCache;
 class ParseNode;
+class ParseNodeArena;
 class Token;
 
 // Manages loading and parsing files from disk. This doesn't actually have
@@ -91,6 +95,10 @@ class InputFileManager : public base::RefCountedThreadSafe<InputFileManager> {
   // Does not count dynamic input.
   int GetInputFileCount() const;
 
+  // Returns the number of times a thread had to wait for another one to
+  // access the files since the last call, and resets it.
+  int64_t TakeLockContention();
+
   // Add all physical input files to a VectorSetSorter instance.
   // This allows fast merging and sorting with other file paths sets.
   //
@@ -102,10 +110,25 @@ class InputFileManager : public base::RefCountedThreadSafe<InputFileManager> {
   void AddAllPhysicalInputFileNamesToVectorSetSorter(
       VectorSetSorter<base::FilePath>* sorter) const;
 
+  // Returns the physical input files whose contents have been loaded. The
+  // files are owned by this class and live as long as it does.
+  std::vector<const InputFile*> GetLoadedPhysicalInputFiles() const;
+
+  // Forgets the given files so that they are loaded from disk again the next
+  // time they are needed. The existing InputFile objects are kept alive since
+  // items may still point into them. Must not be called while files are being
+  // loaded.
+  void InvalidateFiles(const std::vector<SourceFile>& files);
+
   void set_load_file_callback(SyncLoadFileCallback load_file_callback) {
     load_file_callback_ = load_file_callback;
   }
 
+  // Sets the persistent cache consulted before tokenizing and parsing loaded
+  // files, and updated afterwards. Null (the default) disables caching. Must
+  // be called before any files are loaded.
+  void set_parse_cache(std::unique_ptr<ParseCache> cache);
+
  private:
   friend class base::RefCountedThreadSafe<InputFileManager>;
 
@@ -116,7 +139,10 @@ class InputFileManager : public base::RefCountedThreadSafe<InputFileManager> {
     // Don't touch this outside the lock until it's marked loaded.
     InputFile file;
 
-    bool loaded;
+    // Set, within the lock, once the file is loaded or failed to load. The
+    // members below are read-only from then on. Threads synchronously waiting
+    // for the load wait for this to change.
+    std::atomic<bool> loaded;
 
     bool sync_invocation;
 
@@ -124,13 +150,12 @@ class InputFileManager : public base::RefCountedThreadSafe<InputFileManager> {
     // loading.
     std::vector<FileLoadCallback> scheduled_callbacks;
 
-    // Event to signal when the load is complete (or fails). This is lazily
-    // created only when a thread is synchronously waiting for this load (which
-    // only happens for imports).
-    std::unique_ptr<AutoResetEvent> completion_event;
-
+    // Only used by dynamic inputs. Loaded files don't keep their tokens.
     std::vector<Token> tokens;
 
+    // Holds the nodes of |parsed_root|, so it must be declared before it.
+    std::unique_ptr<ParseNodeArena> arena;
+
     // Null before the file is loaded or if loading failed.
     std::unique_ptr<ParseNode> parsed_root;
     Err parse_error;
@@ -150,12 +175,31 @@ class InputFileManager : public base::RefCountedThreadSafe<InputFileManager> {
                 InputFile* file,
                 Err* err);
 
-  mutable std::mutex lock_;
-
   // Maps repo-relative filenames to the corresponding owned pointer.
   using InputFileMap =
       std::unordered_map<SourceFile, std::unique_ptr<InputFileData>>;
-  InputFileMap input_files_;
+
+  // The files are spread over several maps with their own locks, by hash of
+  // their name, so that threads loading different files rarely wait for each
+  // other.
+  struct Shard {
+    std::mutex lock;
+    InputFileMap input_files;
+
+    // Counted without |lock| held so that contention costs nothing more.
+    std::atomic<int64_t> lock_contention{0};
+  };
+  static constexpr size_t kShardCount = 16;
+
+  Shard& GetShard(const SourceFile& name) const;
+
+  // Locks the given shard, counting the times it was held by another thread.
+  static std::unique_lock<std::mutex> LockShard(Shard& shard);
+
+  mutable std::array<Shard, kShardCount> shards_;
+
+  // Protects dynamic_inputs_ and invalidated_inputs_.
+  mutable std::mutex lock_;
 
   // Tracks all dynamic inputs. The data are holders for memory management
   // purposes and should not be read or modified by this class. The values
@@ -165,9 +209,14 @@ class InputFileManager : public base::RefCountedThreadSafe<InputFileManager> {
   // See AddDynamicInput().
   std::vector<std::unique_ptr<InputFileData>> dynamic_inputs_;
 
+  // Files removed by InvalidateFiles(), only kept alive.
+  std::vector<std::unique_ptr<InputFileData>> invalidated_inputs_;
+
   // Used by unit tests to mock out SyncLoadFile().
   SyncLoadFileCallback load_file_callback_;
 
+  std::unique_ptr<ParseCache> parse_cache_;
+
   InputFileManager(const InputFileManager&) = delete;
   InputFileManager& operator=(const InputFileManager&) = delete;
 };
@@ -0,0 +1,73 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/input_file_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gn/build_settings.h"
+#include "gn/err.h"
+#include "gn/location.h"
+#include "gn/test_with_scheduler.h"
+#include "util/test/test.h"
+
+using InputFileManagerTest = TestWithScheduler;
+
+TEST_F(InputFileManagerTest, ConcurrentSyncLoads) {
+  std::atomic<int> load_count = 0;
+  InputFileManager* manager = scheduler().input_file_manager();
+  manager->set_load_file_callback(
+      [&load_count](const SourceFile& name, InputFile* file) {
+        load_count++;
+        // Give the other threads time to wait for this load.
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        file->SetContents("a = \"" + name.value() + "\"\n");
+        return true;
+      });
+
+  // Threads loading the same file all get the same result, loaded once.
+  BuildSettings build_settings;
+  constexpr int kThreadCount = 8;
+  std::vector<const ParseNode*> roots(kThreadCount);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; i++) {
+    threads.emplace_back([&, i]() {
+      Err err;
+      roots[i] = manager->SyncLoadFile(LocationRange(), &build_settings,
+                                       SourceFile("//same.gni"), &err);
+      EXPECT_FALSE(err.has_error());
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  EXPECT_EQ(1, load_count);
+  ASSERT_TRUE(roots[0]);
+  for (const ParseNode* root : roots)
+    EXPECT_EQ(roots[0], root);
+
+  // Files in different shards are all found again.
+  std::vector<const ParseNode*> other_roots;
+  for (int i = 0; i < 100; i++) {
+    Err err;
+    other_roots.push_back(manager->SyncLoadFile(
+        LocationRange(), &build_settings,
+        SourceFile("//dir/file" + std::to_string(i) + ".gni"), &err));
+    EXPECT_TRUE(other_roots.back());
+  }
+  for (int i = 0; i < 100; i++) {
+    Err err;
+    EXPECT_EQ(other_roots[i],
+              manager->SyncLoadFile(
+                  LocationRange(), &build_settings,
+                  SourceFile("//dir/file" + std::to_string(i) + ".gni"), &err));
+  }
+  EXPECT_EQ(101, load_count);
+  EXPECT_EQ(101, manager->GetInputFileCount());
+
+  manager->set_load_file_callback(nullptr);
+}
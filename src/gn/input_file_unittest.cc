@@ -0,0 +1,45 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/input_file.h"
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "util/test/test.h"
+
+TEST(InputFile, Load) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  // A small file is read, a large one may be mapped. Both load the same way.
+  const std::string small = "a = 1\n";
+  std::string large;
+  while (large.size() < InputFile::kMinMappedSize * 2)
+    large += "list += [ \"" + std::to_string(large.size()) + "\" ]\n";
+
+  for (const std::string& data : {small, large, std::string()}) {
+    base::FilePath path = temp_dir.GetPath().AppendASCII("BUILD.gn");
+    ASSERT_EQ(static_cast<int>(data.size()),
+              base::WriteFile(path, data.data(), data.size()));
+
+    InputFile file(SourceFile("//BUILD.gn"));
+    ASSERT_TRUE(file.Load(path));
+    EXPECT_EQ(data, file.contents());
+    EXPECT_EQ(path, file.physical_name());
+  }
+
+  InputFile missing(SourceFile("//missing.gn"));
+  EXPECT_FALSE(missing.Load(temp_dir.GetPath().AppendASCII("missing.gn")));
+}
+
+TEST(InputFile, SetContents) {
+  InputFile file(SourceFile("//BUILD.gn"));
+  std::string data = "a = 1\n";
+  file.SetContents(data);
+  data[0] = 'b';
+  EXPECT_EQ("a = 1\n", file.contents());
+}
@@ -47,6 +47,18 @@ struct LoaderImpl::LoadID {
   Label toolchain_name;
 };
 
+// A load requested before the default toolchain was known.
+struct LoaderImpl::DeferredLoad {
+  DeferredLoad(const SourceFile& f,
+               const LocationRange& o,
+               const Label& tc_name)
+      : file(f), origin(o), toolchain_name(tc_name) {}
+
+  SourceFile file;
+  LocationRange origin;
+  Label toolchain_name;
+};
+
 // Our tracking information for a toolchain.
 struct LoaderImpl::ToolchainRecord {
   // The default toolchain label can be empty for the first time the default
@@ -99,6 +111,13 @@ LoaderImpl::~LoaderImpl() = default;
 void LoaderImpl::Load(const SourceFile& file,
                       const LocationRange& origin,
                       const Label& in_toolchain_name) {
+  if (!in_toolchain_name.is_null() && default_toolchain_label_.is_null()) {
+    // Toolchain records can't be set up before the default build config has
+    // run, since it names the default toolchain. Hold the load until then.
+    deferred_loads_.emplace_back(file, origin, in_toolchain_name);
+    return;
+  }
+
   const Label& toolchain_name = in_toolchain_name.is_null()
                                     ? default_toolchain_label_
                                     : in_toolchain_name;
@@ -202,6 +221,15 @@ SourceFile LoaderImpl::BuildFileForLabel(const Label& label) const {
                     ".gn");
 }
 
+std::vector<std::pair<SourceFile, Label>> LoaderImpl::GetLoadedBuildFiles()
+    const {
+  std::vector<std::pair<SourceFile, Label>> result;
+  result.reserve(invocations_.size());
+  for (const auto& load : invocations_)
+    result.emplace_back(load.file, load.toolchain_name);
+  return result;
+}
+
 void LoaderImpl::ScheduleLoadFile(const Settings* settings,
                                   const LocationRange& origin,
                                   const SourceFile& file) {
@@ -424,6 +452,13 @@ void LoaderImpl::DidLoadBuildConfig(const Label& label) {
     ScheduleLoadFile(&record->settings, waiting.origin, waiting.file);
   record->waiting_on_me.clear();
 
+  // Now that the default toolchain is known, issue any loads that were
+  // waiting for it.
+  std::vector<DeferredLoad> deferred;
+  deferred.swap(deferred_loads_);
+  for (const auto& load : deferred)
+    Load(load.file, load.origin, load.toolchain_name);
+
   DecrementPendingLoads();
 }
 
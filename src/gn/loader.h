@@ -9,6 +9,8 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include "base/memory/ref_counted.h"
 #include "gn/label.h"
@@ -116,9 +118,14 @@ class LoaderImpl : public Loader {
     return default_toolchain_label_;
   }
 
+  // Returns every build file that has been loaded or scheduled for loading,
+  // along with the toolchain it was loaded in.
+  std::vector<std::pair<SourceFile, Label>> GetLoadedBuildFiles() const;
+
  private:
   struct LoadID;
   struct ToolchainRecord;
+  struct DeferredLoad;
 
   ~LoaderImpl() override;
 
@@ -174,6 +181,10 @@ class LoaderImpl : public Loader {
   using LoadIDSet = std::set<LoadID>;
   LoadIDSet invocations_;
 
+  // Loads requested in an explicit toolchain before the default build config
+  // has run. They are issued once the default toolchain is known.
+  std::vector<DeferredLoad> deferred_loads_;
+
   const BuildSettings* build_settings_;
   Label default_toolchain_label_;
 
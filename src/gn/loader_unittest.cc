@@ -390,3 +390,40 @@ TEST_F(LoaderTest, NonDefaultBuildFileName) {
 
   EXPECT_FALSE(scheduler().is_failed());
 }
+
+// Loads in an explicit toolchain issued before the default build config has
+// run are held until the default toolchain is known.
+TEST_F(LoaderTest, DeferredToolchainLoads) {
+  SourceFile build_config("//build/config/BUILDCONFIG.gn");
+  build_settings_.set_build_config_file(build_config);
+
+  scoped_refptr<LoaderImpl> loader(new LoaderImpl(&build_settings_));
+  mock_ifm_.AddCannedResponse(build_config,
+                              "set_default_toolchain(\"//tc:tc\")");
+  loader->set_async_load_file(mock_ifm_.GetAsyncCallback());
+
+  Label default_tc(SourceDir("//tc/"), "tc");
+  SourceFile root_build("//BUILD.gn");
+  SourceFile second_file("//foo/BUILD.gn");
+  loader->Load(root_build, LocationRange(), Label());
+  loader->Load(second_file, LocationRange(), default_tc);
+  EXPECT_TRUE(mock_ifm_.HasOnePending(build_config));
+
+  // Running the build config should schedule both files in the default
+  // toolchain.
+  mock_ifm_.IssueAllPending();
+  MsgLoop::Current()->RunUntilIdleForTesting();
+  EXPECT_TRUE(mock_ifm_.HasTwoPending(root_build, second_file));
+
+  std::vector<std::pair<SourceFile, Label>> loaded =
+      loader->GetLoadedBuildFiles();
+  ASSERT_EQ(2u, loaded.size());
+  EXPECT_EQ(root_build, loaded[0].first);
+  EXPECT_EQ(default_tc, loaded[0].second);
+  EXPECT_EQ(second_file, loaded[1].first);
+  EXPECT_EQ(default_tc, loaded[1].second);
+
+  mock_ifm_.IssueAllPending();
+  MsgLoop::Current()->RunUntilIdleForTesting();
+  EXPECT_FALSE(scheduler().is_failed());
+}
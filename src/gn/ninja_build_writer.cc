@@ -49,6 +49,20 @@ struct Counts {
   const Target* last_seen;
 };
 
+// Writes one build input file to the "build.ninja.d" depfile.
+void WriteBuildInput(const base::FilePath& build_path,
+                     const base::FilePath& input_file,
+                     std::ostream& dep_out) {
+  EscapeOptions depfile_escape;
+  depfile_escape.mode = ESCAPE_DEPFILE;
+  const base::FilePath file =
+      MakeAbsoluteFilePathRelativeIfPossible(build_path, input_file);
+  dep_out << " ";
+  EscapeStringToStream(dep_out,
+                       FilePathToUTF8(file.NormalizePathSeparatorsTo('/')),
+                       depfile_escape);
+}
+
 }  // namespace
 
 base::CommandLine GetSelfInvocationCommandLine(
@@ -262,6 +276,14 @@ bool NinjaBuildWriter::RunAndWriteFile(const BuildSettings* build_settings,
   if (!gen.Run(err))
     return false;
 
+  return WriteFiles(build_settings, file.str(), depfile.str(), err);
+}
+
+// static
+bool NinjaBuildWriter::WriteFiles(const BuildSettings* build_settings,
+                                  const std::string& ninja_contents,
+                                  const std::string& dep_contents,
+                                  Err* err) {
   // Unconditionally write the build.ninja. Ninja's build-out-of-date
   // checking will re-run GN when any build input is newer than build.ninja, so
   // any time the build is updated, build.ninja's timestamp needs to updated
@@ -269,7 +291,6 @@ bool NinjaBuildWriter::RunAndWriteFile(const BuildSettings* build_settings,
   base::FilePath ninja_file_name(build_settings->GetFullPath(
       SourceFile(build_settings->build_dir().value() + "build.ninja")));
   base::CreateDirectory(ninja_file_name.DirName());
-  std::string ninja_contents = file.str();
   if (util::WriteFileAtomically(ninja_file_name, ninja_contents.data(),
                                 static_cast<int>(ninja_contents.size())) !=
       static_cast<int>(ninja_contents.size())) {
@@ -280,7 +301,6 @@ bool NinjaBuildWriter::RunAndWriteFile(const BuildSettings* build_settings,
   // Dep file listing build dependencies.
   base::FilePath dep_file_name(build_settings->GetFullPath(
       SourceFile(build_settings->build_dir().value() + "build.ninja.d")));
-  std::string dep_contents = depfile.str();
   if (util::WriteFileAtomically(dep_file_name, dep_contents.data(),
                                 static_cast<int>(dep_contents.size())) !=
       static_cast<int>(dep_contents.size())) {
@@ -305,6 +325,19 @@ bool NinjaBuildWriter::RunAndWriteFile(const BuildSettings* build_settings,
   return true;
 }
 
+// static
+void NinjaBuildWriter::WriteBuildInputs(
+    const BuildSettings* build_settings,
+    const std::vector<base::FilePath>& files,
+    std::ostream& dep_out) {
+  const base::FilePath build_path =
+      build_settings->build_dir().Resolve(build_settings->root_path());
+
+  dep_out << "build.ninja.stamp:";
+  for (const base::FilePath& file : files)
+    WriteBuildInput(build_path, file, dep_out);
+}
+
 // static
 std::string NinjaBuildWriter::ExtractRegenerationCommands(
     std::istream& build_ninja_in) {
@@ -366,16 +399,8 @@ void NinjaBuildWriter::WriteNinjaRules() {
   const base::FilePath build_path =
       build_settings_->build_dir().Resolve(build_settings_->root_path());
 
-  EscapeOptions depfile_escape;
-  depfile_escape.mode = ESCAPE_DEPFILE;
-  auto item_callback = [this, &depfile_escape,
-                        &build_path](const base::FilePath& input_file) {
-    const base::FilePath file =
-        MakeAbsoluteFilePathRelativeIfPossible(build_path, input_file);
-    dep_out_ << " ";
-    EscapeStringToStream(dep_out_,
-                         FilePathToUTF8(file.NormalizePathSeparatorsTo('/')),
-                         depfile_escape);
+  auto item_callback = [this, &build_path](const base::FilePath& input_file) {
+    WriteBuildInput(build_path, input_file, dep_out_);
   };
 
   sorter.IterateOver(item_callback);
@@ -7,6 +7,7 @@
 
 #include <iosfwd>
 #include <map>
+#include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
@@ -22,6 +23,7 @@ class Toolchain;
 
 namespace base {
 class CommandLine;
+class FilePath;
 }  // namespace base
 
 // Generates the toplevel "build.ninja" file. This references the individual
@@ -48,6 +50,20 @@ class NinjaBuildWriter {
                               const Builder& builder,
                               Err* err);
 
+  // Writes the given contents to "build.ninja" and "build.ninja.d", and
+  // writes the empty "build.ninja.stamp" file expected by the regeneration
+  // rules (see WriteNinjaRules below).
+  static bool WriteFiles(const BuildSettings* settings,
+                         const std::string& ninja_contents,
+                         const std::string& dep_contents,
+                         Err* err);
+
+  // Writes "build.ninja.d" contents listing the given files as the inputs of
+  // the build. The files must be sorted and unique.
+  static void WriteBuildInputs(const BuildSettings* settings,
+                               const std::vector<base::FilePath>& files,
+                               std::ostream& dep_out);
+
   // Extracts from an existing build.ninja file's contents the commands
   // necessary to run GN and regenerate build.ninja.
   //
@@ -12,6 +12,7 @@
 #include <sstream>
 
 #include "base/strings/string_util.h"
+#include "gn/build_settings.h"
 #include "gn/c_substitution_type.h"
 #include "gn/config_values_extractors.h"
 #include "gn/deps_iterator.h"
@@ -19,6 +20,7 @@
 #include "gn/escape.h"
 #include "gn/filesystem_utils.h"
 #include "gn/general_tool.h"
+#include "gn/ninja_shared_vars_writer.h"
 #include "gn/ninja_target_command_util.h"
 #include "gn/ninja_utils.h"
 #include "gn/pool.h"
@@ -231,8 +233,26 @@ void NinjaCBinaryTargetWriter::WriteCompilerVars(
     const std::vector<ModuleDep>& module_dep_info) {
   const SubstitutionBits& subst = target_->toolchain()->substitution_bits();
 
-  WriteCCompilerVars(subst, /*indent=*/false,
-                     /*respect_source_types_used=*/true);
+  NinjaSharedVarsWriter* shared_vars =
+      settings_->build_settings()->ninja_shared_vars_writer();
+  if (shared_vars) {
+    // Targets with the same flags include the same file.
+    std::ostringstream vars;
+    WriteCCompilerVars(subst, /*indent=*/false,
+                       /*respect_source_types_used=*/true, vars);
+    if (vars.tellp() > 0) {
+      Err err;
+      SourceFile vars_file = shared_vars->WriteVars(vars.str(), &err);
+      if (err.has_error())
+        g_scheduler->FailWithError(err);
+      out_ << "include ";
+      path_output_.WriteFile(out_, vars_file);
+      out_ << std::endl;
+    }
+  } else {
+    WriteCCompilerVars(subst, /*indent=*/false,
+                       /*respect_source_types_used=*/true);
+  }
 
   if (!module_dep_info.empty()) {
     // TODO(scottmg): Currently clang modules only working for C++.
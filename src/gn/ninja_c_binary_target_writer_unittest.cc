@@ -8,7 +8,10 @@
 #include <sstream>
 #include <utility>
 
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
 #include "gn/config.h"
+#include "gn/ninja_shared_vars_writer.h"
 #include "gn/ninja_target_command_util.h"
 #include "gn/pool.h"
 #include "gn/scheduler.h"
@@ -165,6 +168,97 @@ TEST_F(NinjaCBinaryTargetWriterTest, SourceSet) {
   }
 }
 
+TEST_F(NinjaCBinaryTargetWriterTest, SharedCompilerVars) {
+  Err err;
+  TestWithScope setup;
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  setup.build_settings()->SetRootPath(temp_dir.GetPath());
+  setup.build_settings()->set_ninja_shared_vars_writer(
+      std::make_unique<NinjaSharedVarsWriter>(setup.build_settings()));
+
+  Config config(setup.settings(), Label(SourceDir("//foo/"), "config"));
+  config.visibility().SetPublic();
+  config.own_values().defines().push_back("FOO");
+  config.own_values().cflags().push_back("-fbar");
+  ASSERT_TRUE(config.OnResolved(&err));
+
+  // Targets with the same flags include the same variables.
+  std::string includes[3];
+  for (int i = 0; i < 3; i++) {
+    Target target(setup.settings(),
+                  Label(SourceDir("//foo/"), "bar" + std::to_string(i)));
+    target.set_output_type(Target::SOURCE_SET);
+    target.sources().push_back(SourceFile("//foo/input.cc"));
+    target.source_types_used().Set(SourceFile::SOURCE_CPP);
+    target.configs().push_back(LabelConfigPair(&config));
+    if (i == 2)
+      target.config_values().defines().push_back("BAZ");
+    target.SetToolchain(setup.toolchain());
+    ASSERT_TRUE(target.OnResolved(&err));
+
+    std::ostringstream out;
+    NinjaCBinaryTargetWriter writer(&target, out);
+    writer.Run();
+    std::string out_str = out.str();
+    ASSERT_EQ(0u, out_str.find("include ninja_vars/")) << out_str;
+    includes[i] = out_str.substr(8, out_str.find('\n') - 8);
+    EXPECT_NE(std::string::npos,
+              out_str.find("target_output_name = bar" + std::to_string(i)))
+        << out_str;
+  }
+  EXPECT_EQ(includes[0], includes[1]);
+  EXPECT_NE(includes[0], includes[2]);
+  EXPECT_EQ(2u,
+            setup.build_settings()->ninja_shared_vars_writer()->file_count());
+
+  std::string vars;
+  ASSERT_TRUE(base::ReadFileToString(
+      setup.build_settings()->GetFullPath(
+          SourceFile("//out/Debug/" + includes[0])),
+      &vars));
+  EXPECT_EQ(
+      "defines = -DFOO\n"
+      "include_dirs =\n"
+      "cflags = -fbar\n"
+      "cflags_cc =\n",
+      vars);
+
+  // Files left by previous runs are deleted, the ones in use are kept.
+  base::FilePath stale_path = setup.build_settings()->GetFullPath(
+      SourceFile("//out/Debug/ninja_vars/stale.ninja"));
+  ASSERT_EQ(0, base::WriteFile(stale_path, "", 0));
+  NinjaSharedVarsWriter::DeleteUnusedFiles(setup.build_settings());
+  EXPECT_FALSE(base::PathExists(stale_path));
+  EXPECT_TRUE(base::PathExists(setup.build_settings()->GetFullPath(
+      SourceFile("//out/Debug/" + includes[0]))));
+  EXPECT_TRUE(base::PathExists(setup.build_settings()->GetFullPath(
+      SourceFile("//out/Debug/" + includes[2]))));
+
+  // Without a writer, none are in use.
+  setup.build_settings()->set_ninja_shared_vars_writer(nullptr);
+  NinjaSharedVarsWriter::DeleteUnusedFiles(setup.build_settings());
+  EXPECT_FALSE(base::PathExists(setup.build_settings()->GetFullPath(
+      SourceFile("//out/Debug/" + includes[0]))));
+}
+
+TEST_F(NinjaCBinaryTargetWriterTest, SharedCompilerVarsWriteError) {
+  TestWithScope setup;
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  // The build directory can't be created under a regular file.
+  base::FilePath root = temp_dir.GetPath().AppendASCII("file");
+  ASSERT_EQ(0, base::WriteFile(root, "", 0));
+  setup.build_settings()->SetRootPath(root);
+  NinjaSharedVarsWriter shared_vars(setup.build_settings());
+
+  Err err;
+  shared_vars.WriteVars("defines = -DFOO\n", &err);
+  EXPECT_TRUE(err.has_error());
+  EXPECT_EQ(0u, shared_vars.file_count());
+}
+
 TEST_F(NinjaCBinaryTargetWriterTest, EscapeDefines) {
   TestWithScope setup;
   Err err;
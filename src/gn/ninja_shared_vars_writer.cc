@@ -0,0 +1,73 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/ninja_shared_vars_writer.h"
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/md5.h"
+#include "gn/build_settings.h"
+#include "gn/filesystem_utils.h"
+#include "gn/string_output_buffer.h"
+#include "gn/trace.h"
+
+NinjaSharedVarsWriter::NinjaSharedVarsWriter(
+    const BuildSettings* build_settings)
+    : build_settings_(build_settings) {}
+
+NinjaSharedVarsWriter::~NinjaSharedVarsWriter() = default;
+
+SourceFile NinjaSharedVarsWriter::WriteVars(const std::string& vars,
+                                            Err* err) {
+  // The name only depends on the contents, so files written by previous runs
+  // are still valid and are only rewritten if they were modified.
+  std::string hash = base::MD5String(vars);
+  SourceFile file(GetDir(build_settings_).value() + hash + ".ninja");
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!written_.insert(hash).second) {
+      AddTraceCounter("ninja_vars.reused", 1);
+      return file;
+    }
+  }
+
+  AddTraceCounter("ninja_vars.files", 1);
+  StringOutputBuffer storage;
+  storage.Append(vars);
+  if (!storage.WriteToFileIfChanged(build_settings_->GetFullPath(file), err)) {
+    // Let the next target with these variables try again.
+    std::lock_guard<std::mutex> lock(lock_);
+    written_.erase(hash);
+  }
+  return file;
+}
+
+size_t NinjaSharedVarsWriter::file_count() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return written_.size();
+}
+
+// static
+void NinjaSharedVarsWriter::DeleteUnusedFiles(
+    const BuildSettings* build_settings) {
+  const NinjaSharedVarsWriter* writer =
+      build_settings->ninja_shared_vars_writer();
+  base::FileEnumerator files(
+      build_settings->GetFullPath(GetDir(build_settings)), false,
+      base::FileEnumerator::FILES, FILE_PATH_LITERAL("*.ninja"));
+  for (base::FilePath path = files.Next(); !path.empty(); path = files.Next()) {
+    std::string hash = FilePathToUTF8(path.BaseName().RemoveExtension());
+    if (writer) {
+      std::lock_guard<std::mutex> lock(writer->lock_);
+      if (writer->written_.count(hash))
+        continue;
+    }
+    base::DeleteFile(path, false);
+  }
+}
+
+// static
+SourceDir NinjaSharedVarsWriter::GetDir(const BuildSettings* build_settings) {
+  return SourceDir(build_settings->build_dir().value() + "ninja_vars/");
+}
@@ -0,0 +1,52 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_NINJA_SHARED_VARS_WRITER_H_
+#define TOOLS_GN_NINJA_SHARED_VARS_WRITER_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#include "gn/source_dir.h"
+#include "gn/source_file.h"
+
+class BuildSettings;
+class Err;
+
+// Writes blocks of ninja variables to files named after their contents, so
+// that the ninja files of targets with identical compiler variables include
+// one shared file instead of repeating them. Enabled by
+// "gn gen --share-compiler-vars". Thread-safe.
+class NinjaSharedVarsWriter {
+ public:
+  explicit NinjaSharedVarsWriter(const BuildSettings* build_settings);
+  ~NinjaSharedVarsWriter();
+
+  // Returns the file holding the given variables, writing it the first time
+  // they are seen. Sets the error if the file can't be written.
+  SourceFile WriteVars(const std::string& vars, Err* err);
+
+  // Number of distinct blocks of variables written so far.
+  size_t file_count() const;
+
+  // Deletes the variable files in the build directory that weren't written
+  // by the build settings' writer, or all of them if it has none. Must be
+  // called once all targets have been written.
+  static void DeleteUnusedFiles(const BuildSettings* build_settings);
+
+ private:
+  // Returns the directory the files are written to.
+  static SourceDir GetDir(const BuildSettings* build_settings);
+
+  const BuildSettings* build_settings_;
+
+  mutable std::mutex lock_;
+  std::unordered_set<std::string> written_;
+
+  NinjaSharedVarsWriter(const NinjaSharedVarsWriter&) = delete;
+  NinjaSharedVarsWriter& operator=(const NinjaSharedVarsWriter&) = delete;
+};
+
+#endif  // TOOLS_GN_NINJA_SHARED_VARS_WRITER_H_
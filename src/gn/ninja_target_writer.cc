@@ -264,15 +264,22 @@ void NinjaTargetWriter::WriteSharedVars(const SubstitutionBits& bits) {
 void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
                                            bool indent,
                                            bool respect_source_used) {
+  WriteCCompilerVars(bits, indent, respect_source_used, out_);
+}
+
+void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
+                                           bool indent,
+                                           bool respect_source_used,
+                                           std::ostream& out) {
   // Defines.
   if (bits.used.count(&CSubstitutionDefines)) {
     if (indent)
-      out_ << "  ";
-    out_ << CSubstitutionDefines.ninja_name << " =";
+      out << "  ";
+    out << CSubstitutionDefines.ninja_name << " =";
     RecursiveTargetConfigToStream<std::string>(kRecursiveWriterSkipDuplicates,
                                                target_, &ConfigValues::defines,
-                                               DefineWriter(), out_);
-    out_ << std::endl;
+                                               DefineWriter(), out);
+    out << std::endl;
   }
 
   // Framework search path.
@@ -280,8 +287,8 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
     const Tool* tool = target_->toolchain()->GetTool(CTool::kCToolLink);
 
     if (indent)
-      out_ << "  ";
-    out_ << CSubstitutionFrameworkDirs.ninja_name << " =";
+      out << "  ";
+    out << CSubstitutionFrameworkDirs.ninja_name << " =";
     PathOutput framework_dirs_output(
         path_output_.current_dir(),
         settings_->build_settings()->root_path_utf8(), ESCAPE_NINJA_COMMAND);
@@ -289,22 +296,22 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
         kRecursiveWriterSkipDuplicates, target_, &ConfigValues::framework_dirs,
         FrameworkDirsWriter(framework_dirs_output,
                             tool->framework_dir_switch()),
-        out_);
-    out_ << std::endl;
+        out);
+    out << std::endl;
   }
 
   // Include directories.
   if (bits.used.count(&CSubstitutionIncludeDirs)) {
     if (indent)
-      out_ << "  ";
-    out_ << CSubstitutionIncludeDirs.ninja_name << " =";
+      out << "  ";
+    out << CSubstitutionIncludeDirs.ninja_name << " =";
     PathOutput include_path_output(
         path_output_.current_dir(),
         settings_->build_settings()->root_path_utf8(), ESCAPE_NINJA_COMMAND);
     RecursiveTargetConfigToStream<SourceDir>(
         kRecursiveWriterSkipDuplicates, target_, &ConfigValues::include_dirs,
-        IncludeWriter(include_path_output), out_);
-    out_ << std::endl;
+        IncludeWriter(include_path_output), out);
+    out << std::endl;
   }
 
   bool has_precompiled_headers =
@@ -317,7 +324,7 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
           : bits.used.count(&CSubstitutionAsmFlags)) {
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_,
                  &CSubstitutionAsmFlags, false, Tool::kToolNone,
-                 &ConfigValues::asmflags, opts, path_output_, out_, true,
+                 &ConfigValues::asmflags, opts, path_output_, out, true,
                  indent);
   }
   if (respect_source_used
@@ -329,14 +336,14 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
           : bits.used.count(&CSubstitutionCFlags)) {
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_, &CSubstitutionCFlags,
                  false, Tool::kToolNone, &ConfigValues::cflags, opts,
-                 path_output_, out_, true, indent);
+                 path_output_, out, true, indent);
   }
   if (respect_source_used
           ? target_->source_types_used().Get(SourceFile::SOURCE_C)
           : bits.used.count(&CSubstitutionCFlagsC)) {
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_, &CSubstitutionCFlagsC,
                  has_precompiled_headers, CTool::kCToolCc,
-                 &ConfigValues::cflags_c, opts, path_output_, out_, true,
+                 &ConfigValues::cflags_c, opts, path_output_, out, true,
                  indent);
   }
   if (respect_source_used
@@ -346,7 +353,7 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_,
                  &CSubstitutionCFlagsCc, has_precompiled_headers,
                  CTool::kCToolCxx, &ConfigValues::cflags_cc, opts, path_output_,
-                 out_, true, indent);
+                 out, true, indent);
   }
   if (respect_source_used
           ? target_->source_types_used().Get(SourceFile::SOURCE_M)
@@ -354,7 +361,7 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_,
                  &CSubstitutionCFlagsObjC, has_precompiled_headers,
                  CTool::kCToolObjC, &ConfigValues::cflags_objc, opts,
-                 path_output_, out_, true, indent);
+                 path_output_, out, true, indent);
   }
   if (respect_source_used
           ? target_->source_types_used().Get(SourceFile::SOURCE_MM)
@@ -362,27 +369,27 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_,
                  &CSubstitutionCFlagsObjCc, has_precompiled_headers,
                  CTool::kCToolObjCxx, &ConfigValues::cflags_objcc, opts,
-                 path_output_, out_, true, indent);
+                 path_output_, out, true, indent);
   }
   if (target_->source_types_used().SwiftSourceUsed() || !respect_source_used) {
     if (bits.used.count(&CSubstitutionSwiftModuleName)) {
       if (indent)
-        out_ << "  ";
-      out_ << CSubstitutionSwiftModuleName.ninja_name << " = ";
-      EscapeStringToStream(out_, target_->swift_values().module_name(), opts);
-      out_ << std::endl;
+        out << "  ";
+      out << CSubstitutionSwiftModuleName.ninja_name << " = ";
+      EscapeStringToStream(out, target_->swift_values().module_name(), opts);
+      out << std::endl;
     }
 
     if (bits.used.count(&CSubstitutionSwiftBridgeHeader)) {
       if (indent)
-        out_ << "  ";
-      out_ << CSubstitutionSwiftBridgeHeader.ninja_name << " = ";
+        out << "  ";
+      out << CSubstitutionSwiftBridgeHeader.ninja_name << " = ";
       if (!target_->swift_values().bridge_header().is_null()) {
-        path_output_.WriteFile(out_, target_->swift_values().bridge_header());
+        path_output_.WriteFile(out, target_->swift_values().bridge_header());
       } else {
-        out_ << R"("")";
+        out << R"("")";
       }
-      out_ << std::endl;
+      out << std::endl;
     }
 
     if (bits.used.count(&CSubstitutionSwiftModuleDirs)) {
@@ -393,21 +400,21 @@ void NinjaTargetWriter::WriteCCompilerVars(const SubstitutionBits& bits,
         swiftmodule_dirs.push_back(dep->swift_values().module_output_dir());
 
       if (indent)
-        out_ << "  ";
-      out_ << CSubstitutionSwiftModuleDirs.ninja_name << " =";
+        out << "  ";
+      out << CSubstitutionSwiftModuleDirs.ninja_name << " =";
       PathOutput swiftmodule_path_output(
           path_output_.current_dir(),
           settings_->build_settings()->root_path_utf8(), ESCAPE_NINJA_COMMAND);
       IncludeWriter swiftmodule_path_writer(swiftmodule_path_output);
       for (const SourceDir& swiftmodule_dir : swiftmodule_dirs) {
-        swiftmodule_path_writer(swiftmodule_dir, out_);
+        swiftmodule_path_writer(swiftmodule_dir, out);
       }
-      out_ << std::endl;
+      out << std::endl;
     }
 
     WriteOneFlag(kRecursiveWriterKeepDuplicates, target_,
                  &CSubstitutionSwiftFlags, false, CTool::kCToolSwift,
-                 &ConfigValues::swiftflags, opts, path_output_, out_, true,
+                 &ConfigValues::swiftflags, opts, path_output_, out, true,
                  indent);
   }
 }
@@ -477,8 +484,7 @@ std::vector<OutputFile> NinjaTargetWriter::WriteInputDepsStampOrPhonyAndGetDep(
 
   // Hard dependencies that are direct or indirect dependencies.
   // These are large (up to 100s), hence why we check other
-  const TargetSet& hard_deps = resolved().GetHardDeps(target_);
-  for (const Target* target : hard_deps) {
+  for (const Target* target : resolved().GetHardDeps(target_)) {
     // BUNDLE_DATA should normally be treated as a data-only dependency
     // (see Target::IsDataOnly()). Only the CREATE_BUNDLE target, that actually
     // consumes this data, needs to have the BUNDLE_DATA as an input dependency.
@@ -490,7 +496,7 @@ std::vector<OutputFile> NinjaTargetWriter::WriteInputDepsStampOrPhonyAndGetDep(
   // Additional hard dependencies passed in. These are usually empty or small,
   // and we don't want to duplicate the explicit hard deps of the target.
   for (const Target* target : additional_hard_deps) {
-    if (!hard_deps.contains(target))
+    if (!resolved().HasHardDep(target_, target))
       input_deps_targets.push_back(target);
   }
 
@@ -74,6 +74,10 @@ class NinjaTargetWriter {
   void WriteCCompilerVars(const SubstitutionBits& bits,
                           bool indent,
                           bool respect_source_used);
+  void WriteCCompilerVars(const SubstitutionBits& bits,
+                          bool indent,
+                          bool respect_source_used,
+                          std::ostream& out);
 
   // Writes out the substitution values that are shared between Rust tools
   // and action tools. Only the substitutions identified by the given bits will
@@ -4,11 +4,14 @@
 
 #include "gn/ninja_writer.h"
 
+#include <atomic>
+
 #include "gn/builder.h"
 #include "gn/loader.h"
 #include "gn/location.h"
 #include "gn/ninja_build_writer.h"
 #include "gn/ninja_toolchain_writer.h"
+#include "gn/scheduler.h"
 #include "gn/settings.h"
 #include "gn/target.h"
 
@@ -28,6 +31,15 @@ bool NinjaWriter::RunAndWriteFiles(const BuildSettings* build_settings,
   return NinjaBuildWriter::RunAndWriteFile(build_settings, builder, err);
 }
 
+// static
+bool NinjaWriter::RunAndWriteToolchainFiles(
+    const Builder& builder,
+    const PerToolchainRules& per_toolchain_rules,
+    Err* err) {
+  NinjaWriter writer(builder);
+  return writer.WriteToolchains(per_toolchain_rules, err);
+}
+
 bool NinjaWriter::WriteToolchains(const PerToolchainRules& per_toolchain_rules,
                                   Err* err) {
   if (per_toolchain_rules.empty()) {
@@ -36,16 +48,28 @@ bool NinjaWriter::WriteToolchains(const PerToolchainRules& per_toolchain_rules,
     return false;
   }
 
+  // The toolchain files are independent, so write them concurrently.
+  std::atomic<bool> success = true;
+  bool concurrent = per_toolchain_rules.size() > 1;
   for (const auto& i : per_toolchain_rules) {
     const Toolchain* toolchain = i.first;
     const Settings* settings =
         builder_.loader()->GetToolchainSettings(toolchain->label());
-    if (!NinjaToolchainWriter::RunAndWriteFile(settings, toolchain, i.second)) {
-      *err =
-          Err(Location(), "Couldn't open toolchain buildfile(s) for writing");
-      return false;
-    }
+    auto write = [settings, toolchain, rules = &i.second, &success]() {
+      if (!NinjaToolchainWriter::RunAndWriteFile(settings, toolchain, *rules))
+        success = false;
+    };
+    if (concurrent)
+      g_scheduler->PostPoolTask(std::move(write));
+    else
+      write();
   }
+  if (concurrent)
+    g_scheduler->WaitForPoolTasks();
 
+  if (!success) {
+    *err = Err(Location(), "Couldn't open toolchain buildfile(s) for writing");
+    return false;
+  }
   return true;
 }
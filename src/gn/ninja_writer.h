@@ -33,6 +33,13 @@ class NinjaWriter {
                                const PerToolchainRules& per_toolchain_rules,
                                Err* err);
 
+  // Writes only the toolchain files, concurrently on the scheduler's pool when
+  // there are several. Exposed for testing.
+  static bool RunAndWriteToolchainFiles(
+      const Builder& builder,
+      const PerToolchainRules& per_toolchain_rules,
+      Err* err);
+
  private:
   NinjaWriter(const Builder& builder);
   ~NinjaWriter();
@@ -0,0 +1,119 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/ninja_writer.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "gn/builder.h"
+#include "gn/filesystem_utils.h"
+#include "gn/loader.h"
+#include "gn/ninja_toolchain_writer.h"
+#include "gn/ninja_utils.h"
+#include "gn/settings.h"
+#include "gn/target.h"
+#include "gn/test_with_scheduler.h"
+#include "gn/test_with_scope.h"
+#include "gn/toolchain.h"
+#include "util/test/test.h"
+
+namespace {
+
+// Returns the settings of the toolchains it was given.
+class ToolchainSettingsLoader : public Loader {
+ public:
+  void AddToolchain(const Settings* settings) {
+    settings_[settings->toolchain_label()] = settings;
+  }
+
+  // Loader implementation:
+  void Load(const SourceFile& file,
+            const LocationRange& origin,
+            const Label& toolchain_name) override {}
+  void ToolchainLoaded(const Toolchain* toolchain) override {}
+  Label GetDefaultToolchain() const override { return Label(); }
+  const Settings* GetToolchainSettings(const Label& label) const override {
+    auto found = settings_.find(label);
+    return found == settings_.end() ? nullptr : found->second;
+  }
+  SourceFile BuildFileForLabel(const Label& label) const override {
+    return SourceFile(label.dir().value() + "BUILD.gn");
+  }
+
+ private:
+  ~ToolchainSettingsLoader() override = default;
+
+  std::map<Label, const Settings*> settings_;
+};
+
+using NinjaWriterTest = TestWithScheduler;
+
+}  // namespace
+
+TEST_F(NinjaWriterTest, ConcurrentToolchainFilesMatchSerialWrites) {
+  TestWithScope setup;
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  setup.build_settings()->SetRootPath(temp_dir.GetPath());
+
+  constexpr int kToolchainCount = 4;
+  constexpr int kTargetCount = 50;
+  auto loader = base::MakeRefCounted<ToolchainSettingsLoader>();
+  std::vector<std::unique_ptr<Settings>> settings;
+  std::vector<std::unique_ptr<Toolchain>> toolchains;
+  std::vector<std::unique_ptr<Target>> targets;
+  NinjaWriter::PerToolchainRules rules;
+  for (int i = 0; i < kToolchainCount; i++) {
+    std::string name = "tc" + std::to_string(i);
+    settings.push_back(
+        std::make_unique<Settings>(setup.build_settings(), name + "/"));
+    Label label(SourceDir("//toolchain/"), name);
+    settings.back()->set_toolchain_label(label);
+    loader->AddToolchain(settings.back().get());
+
+    toolchains.push_back(
+        std::make_unique<Toolchain>(settings.back().get(), label));
+    TestWithScope::SetupToolchain(toolchains.back().get());
+
+    std::vector<NinjaWriter::TargetRulePair>& toolchain_rules =
+        rules[toolchains.back().get()];
+    for (int j = 0; j < kTargetCount; j++) {
+      std::string target_name = "t" + std::to_string(j);
+      targets.push_back(std::make_unique<Target>(
+          settings.back().get(),
+          Label(SourceDir("//foo/"), target_name, label.dir(), label.name())));
+      toolchain_rules.emplace_back(
+          targets.back().get(),
+          "build " + name + "/" + target_name + ": phony\n");
+    }
+  }
+
+  Builder builder(loader.get());
+  Err err;
+  ASSERT_TRUE(NinjaWriter::RunAndWriteToolchainFiles(builder, rules, &err))
+      << err.message();
+
+  for (const auto& [toolchain, toolchain_rules] : rules) {
+    const Settings* toolchain_settings = toolchain->settings();
+    base::FilePath path = setup.build_settings()->GetFullPath(
+        GetNinjaFileForToolchain(toolchain_settings));
+    std::string concurrent;
+    ASSERT_TRUE(base::ReadFileToString(path, &concurrent));
+    ASSERT_TRUE(base::DeleteFile(path, false));
+
+    ASSERT_TRUE(NinjaToolchainWriter::RunAndWriteFile(
+        toolchain_settings, toolchain, toolchain_rules));
+    std::string serial;
+    ASSERT_TRUE(base::ReadFileToString(path, &serial));
+    EXPECT_EQ(serial, concurrent);
+    EXPECT_NE(std::string::npos,
+              concurrent.find("build " + toolchain->label().name() +
+                              "/t49: phony\n"));
+  }
+}
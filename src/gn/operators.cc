@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 #include <algorithm>
+#include <utility>
 
 #include "base/strings/string_number_conversions.h"
 #include "gn/err.h"
@@ -256,6 +257,20 @@ Value GetValueOrFillError(const BinaryOpNode* op_node,
   return value;
 }
 
+// Appends the items of the list |right| to the list |left|.
+void AppendList(Value* left, Value right) {
+  if (std::as_const(*left).list_value().empty()) {
+    // Share the right list instead of copying its items.
+    const ParseNode* origin = left->origin();
+    *left = std::move(right);
+    left->set_origin(origin);
+    return;
+  }
+  std::vector<Value>& dest = left->list_value();
+  for (Value& value : right.list_value())
+    dest.push_back(std::move(value));
+}
+
 void RemoveMatchesFromList(const BinaryOpNode* op_node,
                            Value* list,
                            const Value& to_remove,
@@ -375,8 +390,7 @@ Value ExecutePlus(const BinaryOpNode* op_node,
   if (left.type() == Value::LIST && right.type() == Value::LIST) {
     // Since left was passed by copy, avoid realloc by destructively appending
     // to it and using that as the result.
-    for (Value& value : right.list_value())
-      left.list_value().push_back(std::move(value));
+    AppendList(&left, std::move(right));
     return left;  // FIXME(brettw) does this copy?
   }
 
@@ -473,8 +487,7 @@ void ExecutePlusEquals(Scope* exec_scope,
     // List concat.
     if (right.type() == Value::LIST) {
       // Normal list concat. This is a destructive move.
-      for (Value& value : right.list_value())
-        mutable_dest->list_value().push_back(std::move(value));
+      AppendList(mutable_dest, std::move(right));
     } else {
       *err = Err(op_node->op(), "Incompatible types to add.",
                  "To append a single item to a list do \"foo += [ bar ]\".");
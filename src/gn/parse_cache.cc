@@ -0,0 +1,580 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/parse_cache.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/sha1.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "gn/input_file.h"
+#include "gn/parse_tree.h"
+#include "gn/token.h"
+#include "last_commit_position.h"
+#include "util/atomic_write.h"
+
+namespace {
+
+// Increment when changing the format below. Entries written by any other
+// version of GN are also rejected since the parse tree layout may differ.
+constexpr uint32_t kParseCacheVersion = 1;
+
+constexpr char kMagic[4] = {'G', 'N', 'P', 'C'};
+
+// Tags written before each node. kNullNode marks an absent optional child.
+enum NodeTag : uint8_t {
+  kNullNode = 0,
+  kAccessorNode,
+  kBinaryOpNode,
+  kBlockNode,
+  kBlockCommentNode,
+  kConditionNode,
+  kEndNode,
+  kFunctionCallNode,
+  kIdentifierNode,
+  kListNode,
+  kLiteralNode,
+  kUnaryOpNode,
+};
+
+// Token flags.
+constexpr uint8_t kTokenHasValue = 1 << 0;
+constexpr uint8_t kTokenHasFile = 1 << 1;
+
+// Writes a parse tree. Every token value must point into the file contents
+// and every location must refer to the file (or nothing), otherwise the tree
+// can't be reconstructed and writing fails.
+class TreeWriter {
+ public:
+  TreeWriter(const InputFile* file, std::string* out)
+      : file_(file), out_(out) {}
+
+  // Writes the node's tag, its own data and children, and finally the
+  // comments attached to it.
+  bool WriteNode(const ParseNode* node) {
+    if (!node) {
+      WriteU8(kNullNode);
+      return true;
+    }
+    return WriteNodeData(node) && WriteComments(node);
+  }
+
+  void WriteU8(uint8_t value) { out_->push_back(static_cast<char>(value)); }
+
+  void WriteU32(uint32_t value) {
+    for (int i = 0; i < 4; i++)
+      out_->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+  }
+
+  void WriteString(std::string_view str) {
+    WriteU32(static_cast<uint32_t>(str.size()));
+    out_->append(str);
+  }
+
+ private:
+  bool WriteNodeData(const ParseNode* node) {
+    if (const AccessorNode* accessor = node->AsAccessor()) {
+      WriteU8(kAccessorNode);
+      return WriteToken(accessor->base()) &&
+             WriteNode(accessor->subscript()) &&
+             WriteNode(accessor->member());
+    }
+    if (const BinaryOpNode* binary = node->AsBinaryOp()) {
+      WriteU8(kBinaryOpNode);
+      return WriteToken(binary->op()) && WriteNode(binary->left()) &&
+             WriteNode(binary->right());
+    }
+    if (const BlockNode* block = node->AsBlock()) {
+      WriteU8(kBlockNode);
+      WriteU8(static_cast<uint8_t>(block->result_mode()));
+      if (!WriteToken(block->Begin()) || !WriteNode(block->End()))
+        return false;
+      WriteU32(static_cast<uint32_t>(block->statements().size()));
+      for (const auto& statement : block->statements()) {
+        if (!WriteNode(statement.get()))
+          return false;
+      }
+      return true;
+    }
+    if (const BlockCommentNode* comment = node->AsBlockComment()) {
+      WriteU8(kBlockCommentNode);
+      return WriteToken(comment->comment());
+    }
+    if (const ConditionNode* condition = node->AsCondition()) {
+      WriteU8(kConditionNode);
+      return WriteToken(condition->if_token()) &&
+             WriteNode(condition->condition()) &&
+             WriteNode(condition->if_true()) &&
+             WriteNode(condition->if_false());
+    }
+    if (const EndNode* end = node->AsEnd()) {
+      WriteU8(kEndNode);
+      return WriteToken(end->value());
+    }
+    if (const FunctionCallNode* call = node->AsFunctionCall()) {
+      WriteU8(kFunctionCallNode);
+      return WriteToken(call->function()) && WriteNode(call->args()) &&
+             WriteNode(call->block());
+    }
+    if (const IdentifierNode* identifier = node->AsIdentifier()) {
+      WriteU8(kIdentifierNode);
+      return WriteToken(identifier->value());
+    }
+    if (const ListNode* list = node->AsList()) {
+      WriteU8(kListNode);
+      if (!WriteToken(list->Begin()) || !WriteNode(list->End()))
+        return false;
+      WriteU32(static_cast<uint32_t>(list->contents().size()));
+      for (const auto& item : list->contents()) {
+        if (!WriteNode(item.get()))
+          return false;
+      }
+      return true;
+    }
+    if (const LiteralNode* literal = node->AsLiteral()) {
+      WriteU8(kLiteralNode);
+      return WriteToken(literal->value());
+    }
+    if (const UnaryOpNode* unary = node->AsUnaryOp()) {
+      WriteU8(kUnaryOpNode);
+      return WriteToken(unary->op()) && WriteNode(unary->operand());
+    }
+    return false;
+  }
+
+  bool WriteToken(const Token& token) {
+    std::string_view contents = file_->contents();
+    std::string_view value = token.value();
+
+    uint8_t flags = 0;
+    uint32_t offset = 0;
+    if (value.data()) {
+      if (value.data() < contents.data() ||
+          value.data() + value.size() > contents.data() + contents.size())
+        return false;
+      flags |= kTokenHasValue;
+      offset = static_cast<uint32_t>(value.data() - contents.data());
+    }
+
+    const Location& location = token.location();
+    if (location.file()) {
+      if (location.file() != file_)
+        return false;
+      flags |= kTokenHasFile;
+    }
+
+    WriteU8(static_cast<uint8_t>(token.type()));
+    WriteU8(flags);
+    if (flags & kTokenHasValue) {
+      WriteU32(offset);
+      WriteU32(static_cast<uint32_t>(value.size()));
+    }
+    WriteU32(static_cast<uint32_t>(location.line_number()));
+    WriteU32(static_cast<uint32_t>(location.column_number()));
+    return true;
+  }
+
+  bool WriteTokens(const std::vector<Token>& tokens) {
+    WriteU32(static_cast<uint32_t>(tokens.size()));
+    for (const Token& token : tokens) {
+      if (!WriteToken(token))
+        return false;
+    }
+    return true;
+  }
+
+  bool WriteComments(const ParseNode* node) {
+    const Comments* comments = node->comments();
+    WriteU8(comments ? 1 : 0);
+    if (!comments)
+      return true;
+    return WriteTokens(comments->before()) &&
+           WriteTokens(comments->suffix()) && WriteTokens(comments->after());
+  }
+
+  const InputFile* file_;
+  std::string* out_;
+};
+
+// Reads a tree written by TreeWriter. All reads are bounds checked and any
+// inconsistency marks the reader as failed.
+class TreeReader {
+ public:
+  TreeReader(const InputFile* file, std::string_view data)
+      : file_(file), data_(data) {}
+
+  // Reads a node that may be of any type. Absent nodes are returned as null
+  // with no error.
+  std::unique_ptr<ParseNode> ReadNode() {
+    // Malformed data could otherwise nest deep enough to overflow the stack.
+    if (++depth_ > kMaxDepth)
+      return Fail<ParseNode>();
+    std::unique_ptr<ParseNode> result = DoReadNode();
+    depth_--;
+    return result;
+  }
+
+  // Reads a node that must either be absent or of the given type.
+  template <typename T>
+  std::unique_ptr<T> ReadNodeOfType(const T* (ParseNode::*as)() const) {
+    std::unique_ptr<ParseNode> node = ReadNode();
+    if (!node)
+      return nullptr;
+    if (!((*node).*as)())
+      return Fail<T>();
+    return std::unique_ptr<T>(static_cast<T*>(node.release()));
+  }
+
+  bool ReadU8(uint8_t* value) {
+    if (pos_ + 1 > data_.size())
+      return Fail();
+    *value = static_cast<uint8_t>(data_[pos_++]);
+    return true;
+  }
+
+  bool ReadU32(uint32_t* value) {
+    if (pos_ + 4 > data_.size())
+      return Fail();
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+      *value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[pos_++]))
+                << (i * 8);
+    return true;
+  }
+
+  bool ReadString(std::string_view* str) {
+    uint32_t size;
+    if (!ReadU32(&size) || size > data_.size() - pos_)
+      return Fail();
+    *str = data_.substr(pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool failed() const { return failed_; }
+  bool at_end() const { return pos_ == data_.size(); }
+
+ private:
+  static constexpr int kMaxDepth = 4096;
+
+  bool Fail() {
+    failed_ = true;
+    return false;
+  }
+  template <typename T>
+  std::unique_ptr<T> Fail() {
+    failed_ = true;
+    return nullptr;
+  }
+
+  std::unique_ptr<ParseNode> DoReadNode() {
+    uint8_t tag;
+    if (!ReadU8(&tag))
+      return nullptr;
+
+    std::unique_ptr<ParseNode> node;
+    switch (tag) {
+      case kNullNode:
+        return nullptr;
+      case kAccessorNode: {
+        auto accessor = std::make_unique<AccessorNode>();
+        Token base;
+        if (!ReadToken(&base))
+          return nullptr;
+        accessor->set_base(base);
+        accessor->set_subscript(ReadNode());
+        accessor->set_member(ReadNodeOfType(&ParseNode::AsIdentifier));
+        node = std::move(accessor);
+        break;
+      }
+      case kBinaryOpNode: {
+        auto binary = std::make_unique<BinaryOpNode>();
+        Token op;
+        if (!ReadToken(&op))
+          return nullptr;
+        binary->set_op(op);
+        binary->set_left(ReadNode());
+        binary->set_right(ReadNode());
+        node = std::move(binary);
+        break;
+      }
+      case kBlockNode: {
+        uint8_t result_mode;
+        if (!ReadU8(&result_mode) || result_mode > BlockNode::DISCARDS_RESULT)
+          return Fail<ParseNode>();
+        auto block = std::make_unique<BlockNode>(
+            static_cast<BlockNode::ResultMode>(result_mode));
+        Token begin;
+        if (!ReadToken(&begin))
+          return nullptr;
+        block->set_begin_token(begin);
+        block->set_end(ReadNodeOfType(&ParseNode::AsEnd));
+        uint32_t count;
+        if (!ReadU32(&count))
+          return nullptr;
+        for (uint32_t i = 0; i < count && !failed_; i++) {
+          std::unique_ptr<ParseNode> statement = ReadNode();
+          if (!statement)
+            return Fail<ParseNode>();
+          block->append_statement(std::move(statement));
+        }
+        node = std::move(block);
+        break;
+      }
+      case kBlockCommentNode: {
+        auto comment = std::make_unique<BlockCommentNode>();
+        Token token;
+        if (!ReadToken(&token))
+          return nullptr;
+        comment->set_comment(token);
+        node = std::move(comment);
+        break;
+      }
+      case kConditionNode: {
+        auto condition = std::make_unique<ConditionNode>();
+        Token if_token;
+        if (!ReadToken(&if_token))
+          return nullptr;
+        condition->set_if_token(if_token);
+        condition->set_condition(ReadNode());
+        condition->set_if_true(ReadNodeOfType(&ParseNode::AsBlock));
+        condition->set_if_false(ReadNode());
+        if (!condition->condition() || !condition->if_true())
+          return Fail<ParseNode>();
+        node = std::move(condition);
+        break;
+      }
+      case kEndNode: {
+        Token value;
+        if (!ReadToken(&value))
+          return nullptr;
+        node = std::make_unique<EndNode>(value);
+        break;
+      }
+      case kFunctionCallNode: {
+        auto call = std::make_unique<FunctionCallNode>();
+        Token function;
+        if (!ReadToken(&function))
+          return nullptr;
+        call->set_function(function);
+        call->set_args(ReadNodeOfType(&ParseNode::AsList));
+        call->set_block(ReadNodeOfType(&ParseNode::AsBlock));
+        if (!call->args())
+          return Fail<ParseNode>();
+        node = std::move(call);
+        break;
+      }
+      case kIdentifierNode: {
+        auto identifier = std::make_unique<IdentifierNode>();
+        Token value;
+        if (!ReadToken(&value))
+          return nullptr;
+        identifier->set_value(value);
+        node = std::move(identifier);
+        break;
+      }
+      case kListNode: {
+        auto list = std::make_unique<ListNode>();
+        Token begin;
+        if (!ReadToken(&begin))
+          return nullptr;
+        list->set_begin_token(begin);
+        list->set_end(ReadNodeOfType(&ParseNode::AsEnd));
+        uint32_t count;
+        if (!ReadU32(&count))
+          return nullptr;
+        for (uint32_t i = 0; i < count && !failed_; i++) {
+          std::unique_ptr<ParseNode> item = ReadNode();
+          if (!item)
+            return Fail<ParseNode>();
+          list->append_item(std::move(item));
+        }
+        node = std::move(list);
+        break;
+      }
+      case kLiteralNode: {
+        auto literal = std::make_unique<LiteralNode>();
+        Token value;
+        if (!ReadToken(&value))
+          return nullptr;
+        literal->set_value(value);
+        node = std::move(literal);
+        break;
+      }
+      case kUnaryOpNode: {
+        auto unary = std::make_unique<UnaryOpNode>();
+        Token op;
+        if (!ReadToken(&op))
+          return nullptr;
+        unary->set_op(op);
+        unary->set_operand(ReadNode());
+        if (!unary->operand())
+          return Fail<ParseNode>();
+        node = std::move(unary);
+        break;
+      }
+      default:
+        return Fail<ParseNode>();
+    }
+
+    if (failed_ || !ReadComments(node.get()))
+      return nullptr;
+    return node;
+  }
+
+  bool ReadToken(Token* token) {
+    uint8_t type;
+    uint8_t flags;
+    if (!ReadU8(&type) || !ReadU8(&flags) || type >= Token::NUM_TYPES)
+      return Fail();
+
+    std::string_view value;
+    if (flags & kTokenHasValue) {
+      uint32_t offset;
+      uint32_t size;
+      if (!ReadU32(&offset) || !ReadU32(&size))
+        return false;
+      std::string_view contents = file_->contents();
+      if (offset > contents.size() || size > contents.size() - offset)
+        return Fail();
+      value = std::string_view(contents.data() + offset, size);
+    }
+
+    uint32_t line;
+    uint32_t column;
+    if (!ReadU32(&line) || !ReadU32(&column))
+      return false;
+    Location location((flags & kTokenHasFile) ? file_ : nullptr,
+                      static_cast<int>(line), static_cast<int>(column));
+
+    *token = Token(location, static_cast<Token::Type>(type), value);
+    return true;
+  }
+
+  bool ReadTokens(std::vector<Token>* tokens) {
+    uint32_t count;
+    if (!ReadU32(&count))
+      return false;
+    for (uint32_t i = 0; i < count; i++) {
+      Token token;
+      if (!ReadToken(&token))
+        return false;
+      tokens->push_back(token);
+    }
+    return true;
+  }
+
+  bool ReadComments(ParseNode* node) {
+    uint8_t has_comments;
+    if (!ReadU8(&has_comments))
+      return false;
+    if (!has_comments)
+      return true;
+
+    std::vector<Token> before, suffix, after;
+    if (!ReadTokens(&before) || !ReadTokens(&suffix) || !ReadTokens(&after))
+      return false;
+    Comments* comments = node->comments_mutable();
+    for (const Token& token : before)
+      comments->append_before(token);
+    for (const Token& token : suffix)
+      comments->append_suffix(token);
+    for (const Token& token : after)
+      comments->append_after(token);
+    return true;
+  }
+
+  const InputFile* file_;
+  std::string_view data_;
+  size_t pos_ = 0;
+  int depth_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace
+
+ParseCache::ParseCache(const base::FilePath& cache_dir)
+    : cache_dir_(cache_dir) {}
+
+ParseCache::~ParseCache() = default;
+
+// static
+std::string ParseCache::GetKey(const InputFile& file) {
+  std::string_view contents = file.contents();
+  unsigned char hash[base::kSHA1Length];
+  base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(contents.data()),
+                      contents.size(), hash);
+  return base::ToLowerASCII(base::HexEncode(hash, sizeof(hash)));
+}
+
+std::unique_ptr<ParseNode> ParseCache::Lookup(const std::string& key,
+                                              const InputFile* file) const {
+  std::string data;
+  if (!base::ReadFileToString(GetEntryPath(key), &data))
+    return nullptr;
+  return Deserialize(file, data);
+}
+
+void ParseCache::Store(const std::string& key,
+                       const InputFile* file,
+                       const ParseNode* root) const {
+  std::string data;
+  if (!Serialize(file, root, &data))
+    return;
+  // Entries are written atomically so that concurrent GN processes sharing a
+  // build directory never observe a partially written one.
+  util::WriteFileAtomically(GetEntryPath(key), data.data(),
+                            static_cast<int>(data.size()));
+}
+
+// static
+bool ParseCache::Serialize(const InputFile* file,
+                           const ParseNode* root,
+                           std::string* out) {
+  out->clear();
+  TreeWriter writer(file, out);
+  out->append(kMagic, sizeof(kMagic));
+  writer.WriteU32(kParseCacheVersion);
+  writer.WriteString(LAST_COMMIT_POSITION);
+  writer.WriteU32(Token::NUM_TYPES);
+  writer.WriteU32(static_cast<uint32_t>(file->contents().size()));
+  return root && writer.WriteNode(root);
+}
+
+// static
+std::unique_ptr<ParseNode> ParseCache::Deserialize(const InputFile* file,
+                                                   std::string_view data) {
+  if (data.size() < sizeof(kMagic) ||
+      memcmp(data.data(), kMagic, sizeof(kMagic)) != 0)
+    return nullptr;
+
+  TreeReader reader(file, data.substr(sizeof(kMagic)));
+  uint32_t version;
+  std::string_view commit_position;
+  uint32_t num_token_types;
+  uint32_t contents_size;
+  if (!reader.ReadU32(&version) || version != kParseCacheVersion ||
+      !reader.ReadString(&commit_position) ||
+      commit_position != LAST_COMMIT_POSITION ||
+      !reader.ReadU32(&num_token_types) ||
+      num_token_types != Token::NUM_TYPES ||
+      !reader.ReadU32(&contents_size) ||
+      contents_size != file->contents().size())
+    return nullptr;
+
+  std::unique_ptr<ParseNode> root = reader.ReadNode();
+  if (reader.failed() || !reader.at_end())
+    return nullptr;
+  return root;
+}
+
+base::FilePath ParseCache::GetEntryPath(const std::string& key) const {
+  return cache_dir_.AppendASCII(key);
+}
@@ -0,0 +1,72 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_PARSE_CACHE_H_
+#define TOOLS_GN_PARSE_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "base/files/file_path.h"
+
+class InputFile;
+class ParseNode;
+
+// Persists the parse trees of input files on disk so that later runs don't
+// need to tokenize and parse files whose contents haven't changed.
+//
+// Entries are keyed by a hash of the file contents and stored as one file
+// each in the cache directory (normally inside the build directory). Tokens
+// are saved as offsets into the contents rather than as copies of their text,
+// so a cached tree is only meaningful together with the exact contents it was
+// parsed from, which the key guarantees. Entries also record the version of
+// GN that wrote them and are ignored by any other version.
+//
+// Any problem reading or writing the cache just results in a miss; callers
+// fall back to parsing normally.
+//
+// This class is threadsafe.
+class ParseCache {
+ public:
+  explicit ParseCache(const base::FilePath& cache_dir);
+  ~ParseCache();
+
+  const base::FilePath& cache_dir() const { return cache_dir_; }
+
+  // Returns the key identifying the given file's contents in the cache.
+  static std::string GetKey(const InputFile& file);
+
+  // Returns the parse tree stored under the given key, with all tokens
+  // pointing into |file|. Returns null if there is no valid entry.
+  std::unique_ptr<ParseNode> Lookup(const std::string& key,
+                                    const InputFile* file) const;
+
+  // Saves the given parse tree of |file| under the given key. Failures are
+  // ignored.
+  void Store(const std::string& key,
+             const InputFile* file,
+             const ParseNode* root) const;
+
+  // Converts a parse tree of the given file to and from the cache's binary
+  // format. Serialize returns false if the tree can't be represented (for
+  // example, a token that doesn't point into the file contents), and
+  // Deserialize returns null if the data is truncated or malformed. Exposed
+  // for testing.
+  static bool Serialize(const InputFile* file,
+                        const ParseNode* root,
+                        std::string* out);
+  static std::unique_ptr<ParseNode> Deserialize(const InputFile* file,
+                                                std::string_view data);
+
+ private:
+  base::FilePath GetEntryPath(const std::string& key) const;
+
+  base::FilePath cache_dir_;
+
+  ParseCache(const ParseCache&) = delete;
+  ParseCache& operator=(const ParseCache&) = delete;
+};
+
+#endif  // TOOLS_GN_PARSE_CACHE_H_
@@ -0,0 +1,126 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/parse_cache.h"
+
+#include <sstream>
+
+#include "base/files/scoped_temp_dir.h"
+#include "gn/input_file.h"
+#include "gn/parse_tree.h"
+#include "gn/parser.h"
+#include "gn/tokenizer.h"
+#include "util/test/test.h"
+
+namespace {
+
+const char kInput[] =
+    "# Leading comment.\n"
+    "import(\"//build/foo.gni\")\n"
+    "\n"
+    "if (is_linux && !is_android) {\n"
+    "  sources = [\n"
+    "    \"a.cc\",  # Suffix comment.\n"
+    "    \"b.cc\",\n"
+    "  ]\n"
+    "} else if (x.y == 2) {\n"
+    "  sources -= [ \"c.cc\" ]\n"
+    "} else {\n"
+    "  foo = bar[1] + baz.qux\n"
+    "}\n"
+    "\n"
+    "# Block comment.\n"
+    "\n"
+    "template(\"t\") {\n"
+    "  forward_variables_from(invoker, \"*\")\n"
+    "}\n";
+
+std::unique_ptr<ParseNode> ParseFile(const InputFile& file) {
+  Err err;
+  std::vector<Token> tokens = Tokenizer::Tokenize(&file, &err);
+  if (err.has_error())
+    return nullptr;
+  return Parser::Parse(tokens, &err);
+}
+
+std::string Render(const ParseNode* node) {
+  std::ostringstream out;
+  RenderToText(node->GetJSONNode(), 0, out);
+  return out.str();
+}
+
+}  // namespace
+
+TEST(ParseCache, RoundTrip) {
+  InputFile file(SourceFile("//BUILD.gn"));
+  file.SetContents(kInput);
+  std::unique_ptr<ParseNode> parsed = ParseFile(file);
+  ASSERT_TRUE(parsed);
+
+  std::string data;
+  ASSERT_TRUE(ParseCache::Serialize(&file, parsed.get(), &data));
+
+  std::unique_ptr<ParseNode> loaded = ParseCache::Deserialize(&file, data);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(Render(parsed.get()), Render(loaded.get()));
+
+  // Tokens of the loaded tree point into the file.
+  const BlockNode* block = loaded->AsBlock();
+  ASSERT_TRUE(block);
+  ASSERT_FALSE(block->statements().empty());
+  const FunctionCallNode* import = block->statements()[0]->AsFunctionCall();
+  ASSERT_TRUE(import);
+  EXPECT_EQ(&file, import->function().location().file());
+  EXPECT_EQ(file.contents().data() + 19, import->function().value().data());
+}
+
+TEST(ParseCache, RejectsBadData) {
+  InputFile file(SourceFile("//BUILD.gn"));
+  file.SetContents(kInput);
+  std::unique_ptr<ParseNode> parsed = ParseFile(file);
+  ASSERT_TRUE(parsed);
+
+  std::string data;
+  ASSERT_TRUE(ParseCache::Serialize(&file, parsed.get(), &data));
+
+  // Every truncation must be detected.
+  for (size_t i = 0; i < data.size(); i++)
+    EXPECT_FALSE(ParseCache::Deserialize(&file, data.substr(0, i)));
+
+  // Trailing garbage.
+  EXPECT_FALSE(ParseCache::Deserialize(&file, data + "x"));
+
+  // Data for different contents.
+  InputFile other(SourceFile("//BUILD.gn"));
+  other.SetContents("a = 1\n");
+  EXPECT_FALSE(ParseCache::Deserialize(&other, data));
+}
+
+TEST(ParseCache, StoreAndLookup) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  ParseCache cache(temp_dir.GetPath());
+
+  InputFile file(SourceFile("//BUILD.gn"));
+  file.SetContents(kInput);
+  std::string key = ParseCache::GetKey(file);
+  EXPECT_FALSE(cache.Lookup(key, &file));
+
+  std::unique_ptr<ParseNode> parsed = ParseFile(file);
+  ASSERT_TRUE(parsed);
+  cache.Store(key, &file, parsed.get());
+
+  // Another file with the same contents shares the entry, with locations
+  // referring to itself.
+  InputFile copy(SourceFile("//other/BUILD.gn"));
+  copy.SetContents(kInput);
+  EXPECT_EQ(key, ParseCache::GetKey(copy));
+  std::unique_ptr<ParseNode> loaded = cache.Lookup(key, &copy);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(&copy, loaded->GetRange().begin().file());
+
+  InputFile changed(SourceFile("//BUILD.gn"));
+  changed.SetContents(std::string(kInput) + "a = 1\n");
+  EXPECT_NE(key, ParseCache::GetKey(changed));
+}
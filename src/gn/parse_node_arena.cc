@@ -0,0 +1,85 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/parse_node_arena.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+
+#include "base/logging.h"
+
+namespace {
+
+// Most build files fit in a block or two.
+constexpr size_t kBlockSize = 16 * 1024;
+
+// new[] of chars doesn't guarantee more than this alignment.
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+#if !defined(OS_ZOS)
+thread_local ParseNodeArena* current_arena = nullptr;
+#else
+// TODO(gabylb) - zos: thread_local not yet supported, use zoslib's impl'n:
+__tlssim<ParseNodeArena*> __g_current_arena_impl(nullptr);
+#define current_arena (*__g_current_arena_impl.access())
+#endif
+
+}  // namespace
+
+ParseNodeArena::Scope::Scope(ParseNodeArena* arena)
+    : previous_(current_arena) {
+  current_arena = arena;
+}
+
+ParseNodeArena::Scope::~Scope() {
+  current_arena = previous_;
+}
+
+ParseNodeArena::ParseNodeArena() = default;
+
+ParseNodeArena::~ParseNodeArena() = default;
+
+// static
+ParseNodeArena* ParseNodeArena::Current() {
+  return current_arena;
+}
+
+void* ParseNodeArena::Allocate(size_t size) {
+  size = (size + kAlignment - 1) & ~(kAlignment - 1);
+  if (size > remaining_) {
+    size_t block_size = std::max(size, kBlockSize);
+    blocks_.push_back(std::unique_ptr<char[]>(new char[block_size]));
+    next_ = blocks_.back().get();
+    remaining_ = block_size;
+    DCHECK(reinterpret_cast<uintptr_t>(next_) % kAlignment == 0);
+
+    std::pair<const char*, const char*> range(next_, next_ + block_size);
+    block_ranges_.insert(std::upper_bound(block_ranges_.begin(),
+                                          block_ranges_.end(), range),
+                         range);
+  }
+  void* result = next_;
+  next_ += size;
+  remaining_ -= size;
+
+  allocation_count_++;
+  allocated_bytes_ += size;
+  return result;
+}
+
+bool ParseNodeArena::Contains(const void* ptr) const {
+  const char* address = static_cast<const char*>(ptr);
+  auto found = std::upper_bound(
+      block_ranges_.begin(), block_ranges_.end(), address,
+      [](const char* address,
+         const std::pair<const char*, const char*>& range) {
+        return address < range.first;
+      });
+  if (found == block_ranges_.begin())
+    return false;
+  --found;
+  return address < found->second;
+}
@@ -0,0 +1,71 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_PARSE_NODE_ARENA_H_
+#define TOOLS_GN_PARSE_NODE_ARENA_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Memory for the parse nodes of one file. Parsing allocates a lot of small
+// nodes that live as long as the file, so they are carved out of large blocks
+// that are all freed at once when the arena is destroyed.
+//
+// Nodes are allocated from an arena while a ParseNodeArena::Scope for it is
+// alive on the current thread (see ParseNode::operator new), and from the heap
+// otherwise. Nodes don't record where they come from, so the nodes of an arena
+// must be deleted while a scope for it is alive: ParseNode::operator delete
+// then runs their destructor but leaves their memory to the arena, which must
+// outlive them.
+class ParseNodeArena {
+ public:
+  // Makes new parse nodes on the current thread come from |arena| during the
+  // lifetime of this object.
+  class Scope {
+   public:
+    explicit Scope(ParseNodeArena* arena);
+    ~Scope();
+
+   private:
+    ParseNodeArena* previous_;
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  ParseNodeArena();
+  ~ParseNodeArena();
+
+  // Returns the arena of the innermost scope on the current thread, or null.
+  static ParseNodeArena* Current();
+
+  // Returns |size| bytes aligned for any type.
+  void* Allocate(size_t size);
+
+  // Returns true if |ptr| was returned by Allocate().
+  bool Contains(const void* ptr) const;
+
+  // Number of allocations made from this arena and their total size.
+  size_t allocation_count() const { return allocation_count_; }
+  size_t allocated_bytes() const { return allocated_bytes_; }
+
+ private:
+  std::vector<std::unique_ptr<char[]>> blocks_;
+
+  // The address ranges of the blocks, sorted by address.
+  std::vector<std::pair<const char*, const char*>> block_ranges_;
+  char* next_ = nullptr;
+  size_t remaining_ = 0;
+
+  size_t allocation_count_ = 0;
+  size_t allocated_bytes_ = 0;
+
+  ParseNodeArena(const ParseNodeArena&) = delete;
+  ParseNodeArena& operator=(const ParseNodeArena&) = delete;
+};
+
+#endif  // TOOLS_GN_PARSE_NODE_ARENA_H_
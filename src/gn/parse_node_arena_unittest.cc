@@ -0,0 +1,105 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/parse_node_arena.h"
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "gn/err.h"
+#include "gn/input_file.h"
+#include "gn/parse_tree.h"
+#include "gn/parser.h"
+#include "gn/tokenizer.h"
+#include "util/test/test.h"
+
+TEST(ParseNodeArena, Allocate) {
+  ParseNodeArena arena;
+  EXPECT_EQ(0u, arena.allocation_count());
+
+  // Allocations are aligned, including ones larger than a block.
+  std::vector<char*> allocations;
+  for (size_t size : {1, 24, 100000, 8}) {
+    void* memory = arena.Allocate(size);
+    EXPECT_EQ(0u,
+              reinterpret_cast<uintptr_t>(memory) % alignof(std::max_align_t));
+    allocations.push_back(static_cast<char*>(memory));
+  }
+  EXPECT_EQ(4u, arena.allocation_count());
+  EXPECT_LE(100033u, arena.allocated_bytes());
+
+  for (char* memory : allocations)
+    EXPECT_TRUE(arena.Contains(memory));
+  EXPECT_TRUE(arena.Contains(allocations[2] + 99999));
+  int not_in_arena = 0;
+  EXPECT_FALSE(arena.Contains(&not_in_arena));
+  std::unique_ptr<char[]> heap(new char[16]);
+  EXPECT_FALSE(arena.Contains(heap.get()));
+}
+
+TEST(ParseNodeArena, Scope) {
+  EXPECT_EQ(nullptr, ParseNodeArena::Current());
+
+  ParseNodeArena outer;
+  ParseNodeArena inner;
+  std::unique_ptr<ParseNode> heap_node = std::make_unique<EndNode>(Token());
+  {
+    ParseNodeArena::Scope outer_scope(&outer);
+    EXPECT_EQ(&outer, ParseNodeArena::Current());
+    {
+      ParseNodeArena::Scope inner_scope(&inner);
+      EXPECT_EQ(&inner, ParseNodeArena::Current());
+      std::make_unique<EndNode>(Token());
+    }
+    EXPECT_EQ(&outer, ParseNodeArena::Current());
+    std::make_unique<EndNode>(Token());
+    std::make_unique<EndNode>(Token());
+  }
+  EXPECT_EQ(nullptr, ParseNodeArena::Current());
+
+  EXPECT_EQ(2u, outer.allocation_count());
+  EXPECT_EQ(1u, inner.allocation_count());
+
+  // Nodes from the heap are freed even while an arena is current.
+  {
+    ParseNodeArena::Scope outer_scope(&outer);
+    heap_node.reset();
+  }
+}
+
+TEST(ParseNodeArena, ParseTree) {
+  InputFile input_file(SourceFile("/test"));
+  input_file.SetContents("a = [ 1, 2 ]\nb = a + [ 3 ]\n");
+  Err err;
+  std::vector<Token> tokens = Tokenizer::Tokenize(&input_file, &err);
+  ASSERT_FALSE(err.has_error());
+
+  ParseNodeArena arena;
+  std::unique_ptr<ParseNode> root;
+  {
+    ParseNodeArena::Scope scope(&arena);
+    root = Parser::Parse(tokens, &err);
+  }
+  ASSERT_FALSE(err.has_error());
+  ASSERT_TRUE(root);
+
+  // The block, the two assignments, and their operands.
+  EXPECT_LE(10u, arena.allocation_count());
+
+  // The tree doesn't depend on the tokens.
+  tokens.clear();
+  const BlockNode* block = root->AsBlock();
+  ASSERT_TRUE(block);
+  ASSERT_EQ(2u, block->statements().size());
+  const BinaryOpNode* assignment = block->statements()[1]->AsBinaryOp();
+  ASSERT_TRUE(assignment);
+  EXPECT_EQ("b", assignment->left()->AsIdentifier()->value().value());
+
+  // The nodes must be deleted while the arena is current.
+  ParseNodeArena::Scope scope(&arena);
+  root.reset();
+}
@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <new>
 #include <string>
 #include <tuple>
 
@@ -16,6 +17,7 @@
 #include "base/strings/string_util.h"
 #include "gn/functions.h"
 #include "gn/operators.h"
+#include "gn/parse_node_arena.h"
 #include "gn/scope.h"
 #include "gn/string_utils.h"
 
@@ -170,6 +172,21 @@ ParseNode::ParseNode() = default;
 
 ParseNode::~ParseNode() = default;
 
+// static
+void* ParseNode::operator new(size_t size) {
+  ParseNodeArena* arena = ParseNodeArena::Current();
+  return arena ? arena->Allocate(size) : ::operator new(size);
+}
+
+// static
+void ParseNode::operator delete(void* ptr) {
+  // Memory from an arena is released with the arena.
+  ParseNodeArena* arena = ParseNodeArena::Current();
+  if (arena && arena->Contains(ptr))
+    return;
+  ::operator delete(ptr);
+}
+
 const AccessorNode* ParseNode::AsAccessor() const {
   return nullptr;
 }
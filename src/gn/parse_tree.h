@@ -80,6 +80,12 @@ class ParseNode {
   ParseNode();
   virtual ~ParseNode();
 
+  // Nodes are allocated from the current ParseNodeArena if there is one, and
+  // from the heap otherwise. Nodes from an arena must be deleted while it is
+  // the current one.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+
   virtual const AccessorNode* AsAccessor() const;
   virtual const BinaryOpNode* AsBinaryOp() const;
   virtual const BlockCommentNode* AsBlockComment() const;
@@ -291,6 +297,7 @@ class BlockNode : public ParseNode {
   static std::unique_ptr<BlockNode> NewFromJSON(const base::Value& value);
 
   void set_begin_token(const Token& t) { begin_token_ = t; }
+  const Token& Begin() const { return begin_token_; }
   void set_end(std::unique_ptr<EndNode> e) { end_ = std::move(e); }
   const EndNode* End() const { return end_.get(); }
 
@@ -340,6 +347,7 @@ class ConditionNode : public ParseNode {
   base::Value GetJSONNode() const override;
   static std::unique_ptr<ConditionNode> NewFromJSON(const base::Value& value);
 
+  const Token& if_token() const { return if_token_; }
   void set_if_token(const Token& token) { if_token_ = token; }
 
   const ParseNode* condition() const { return condition_.get(); }
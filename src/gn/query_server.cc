@@ -0,0 +1,615 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/query_server.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <functional>
+
+#include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "gn/build_settings.h"
+#include "gn/commands.h"
+#include "gn/err.h"
+#include "gn/filesystem_utils.h"
+#include "gn/input_file_manager.h"
+#include "gn/scheduler.h"
+#include "gn/setup.h"
+#include "gn/standard_out.h"
+#include "gn/switches.h"
+#include "last_commit_position.h"
+#include "util/build_config.h"
+#include "util/msg_loop.h"
+
+#if defined(OS_POSIX)
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+namespace {
+
+// Messages larger than this are rejected.
+constexpr uint32_t kMaxMessageSize = 1u << 30;
+
+// Switches that affect how the build graph is loaded. Requests must use the
+// same values as the server.
+const char* const kLoadSwitches[] = {
+    switches::kArgs,
+    switches::kRootPattern,
+    switches::kRootTarget,
+    switches::kScriptExecutable,
+};
+
+void WriteU32(uint32_t value, std::string* out) {
+  for (int i = 0; i < 4; i++)
+    out->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+void WriteString(std::string_view str, std::string* out) {
+  WriteU32(static_cast<uint32_t>(str.size()), out);
+  out->append(str);
+}
+
+bool ReadU32(std::string_view* data, uint32_t* value) {
+  if (data->size() < 4)
+    return false;
+  *value = 0;
+  for (int i = 0; i < 4; i++)
+    *value |= static_cast<uint32_t>(static_cast<uint8_t>((*data)[i]))
+              << (i * 8);
+  data->remove_prefix(4);
+  return true;
+}
+
+bool ReadString(std::string_view* data, std::string* str) {
+  uint32_t size;
+  if (!ReadU32(data, &size) || size > data->size())
+    return false;
+  str->assign(data->substr(0, size));
+  data->remove_prefix(size);
+  return true;
+}
+
+bool ReadBool(std::string_view* data, bool* value) {
+  if (data->empty() || static_cast<uint8_t>((*data)[0]) > 1)
+    return false;
+  *value = (*data)[0] == 1;
+  data->remove_prefix(1);
+  return true;
+}
+
+#if defined(OS_POSIX)
+
+// How long the server waits for a client to send its request or to read the
+// response. The server handles one client at a time, so a client that stops
+// in the middle mustn't hold it up for long.
+constexpr int kServerTimeoutSeconds = 10;
+
+// How long a client waits for the server. The response can require
+// reloading the build graph first.
+constexpr int kClientTimeoutSeconds = 600;
+
+// How long the server waits before accepting again when it's out of
+// resources.
+constexpr useconds_t kAcceptRetryMicroseconds = 100 * 1000;
+
+bool WriteAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t written = HANDLE_EINTR(write(fd, data.data(), data.size()));
+    if (written <= 0)
+      return false;
+    data.remove_prefix(written);
+  }
+  return true;
+}
+
+bool ReadAll(int fd, size_t size, std::string* out) {
+  out->resize(size);
+  size_t done = 0;
+  while (done < size) {
+    ssize_t result = HANDLE_EINTR(read(fd, &(*out)[done], size - done));
+    if (result <= 0)
+      return false;
+    done += result;
+  }
+  return true;
+}
+
+// Messages are sent as their size followed by the data.
+bool SendMessage(int fd, std::string_view message) {
+  std::string size;
+  WriteU32(static_cast<uint32_t>(message.size()), &size);
+  return WriteAll(fd, size) && WriteAll(fd, message);
+}
+
+bool ReceiveMessage(int fd, std::string* message) {
+  std::string size_data;
+  if (!ReadAll(fd, 4, &size_data))
+    return false;
+  std::string_view view(size_data);
+  uint32_t size;
+  return ReadU32(&view, &size) && size <= kMaxMessageSize &&
+         ReadAll(fd, size, message);
+}
+
+// Makes reads and writes on the given socket fail if they block for longer
+// than the given time.
+void SetSocketTimeouts(int fd, int seconds) {
+  timeval timeout = {};
+  timeout.tv_sec = seconds;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool MakeSocketAddress(const base::FilePath& path, sockaddr_un* addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (path.value().size() >= sizeof(addr->sun_path))
+    return false;
+  memcpy(addr->sun_path, path.value().c_str(), path.value().size());
+  return true;
+}
+
+// Returns a socket connected to the given path, or -1.
+int ConnectToSocket(const base::FilePath& path) {
+  sockaddr_un addr;
+  if (!MakeSocketAddress(path, &addr))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  if (HANDLE_EINTR(connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                           sizeof(addr))) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Runs the callback with the standard input reading the given contents and
+// the standard output captured, and returns the output.
+std::string RunWithRedirectedStdio(std::string_view stdin_contents,
+                                   const std::function<void()>& callback) {
+  FILE* in = tmpfile();
+  FILE* out = tmpfile();
+  if (!in || !out) {
+    if (in)
+      fclose(in);
+    if (out)
+      fclose(out);
+    callback();
+    return std::string();
+  }
+  fwrite(stdin_contents.data(), 1, stdin_contents.size(), in);
+  fflush(in);
+  rewind(in);
+
+  fflush(stdout);
+  int saved_stdin = dup(STDIN_FILENO);
+  int saved_stdout = dup(STDOUT_FILENO);
+  dup2(fileno(in), STDIN_FILENO);
+  dup2(fileno(out), STDOUT_FILENO);
+  clearerr(stdin);
+
+  callback();
+
+  fflush(stdout);
+  dup2(saved_stdout, STDOUT_FILENO);
+  dup2(saved_stdin, STDIN_FILENO);
+  close(saved_stdout);
+  close(saved_stdin);
+  clearerr(stdin);
+
+  std::string output;
+  fseek(out, 0, SEEK_END);
+  long size = ftell(out);
+  if (size > 0) {
+    output.resize(size);
+    rewind(out);
+    output.resize(fread(&output[0], 1, output.size(), out));
+  }
+  fclose(in);
+  fclose(out);
+  return output;
+}
+
+// Makes the given command line the one of the current process.
+void SetProcessCommandLine(const std::vector<std::string>& argv) {
+  std::vector<const char*> c_argv;
+  for (const std::string& arg : argv)
+    c_argv.push_back(arg.c_str());
+  base::CommandLine::Reset();
+  base::CommandLine::Init(static_cast<int>(c_argv.size()), c_argv.data());
+}
+
+#endif  // defined(OS_POSIX)
+
+}  // namespace
+
+std::string QueryRequest::Serialize() const {
+  std::string out;
+  WriteString(version, &out);
+  WriteString(current_dir, &out);
+  WriteU32(static_cast<uint32_t>(argv.size()), &out);
+  for (const std::string& arg : argv)
+    WriteString(arg, &out);
+  WriteString(stdin_contents, &out);
+  out.push_back(decorated_output ? 1 : 0);
+  return out;
+}
+
+// static
+bool QueryRequest::Deserialize(std::string_view data, QueryRequest* out) {
+  uint32_t argc;
+  if (!ReadString(&data, &out->version) ||
+      !ReadString(&data, &out->current_dir) || !ReadU32(&data, &argc) ||
+      argc > data.size() / 4)
+    return false;
+  out->argv.resize(argc);
+  for (std::string& arg : out->argv) {
+    if (!ReadString(&data, &arg))
+      return false;
+  }
+  return ReadString(&data, &out->stdin_contents) &&
+         ReadBool(&data, &out->decorated_output) && data.empty();
+}
+
+std::string QueryResponse::Serialize() const {
+  std::string out;
+  out.push_back(accepted ? 1 : 0);
+  WriteU32(static_cast<uint32_t>(exit_code), &out);
+  WriteString(output, &out);
+  return out;
+}
+
+// static
+bool QueryResponse::Deserialize(std::string_view data, QueryResponse* out) {
+  uint32_t exit_code;
+  if (!ReadBool(&data, &out->accepted) || !ReadU32(&data, &exit_code) ||
+      !ReadString(&data, &out->output))
+    return false;
+  out->exit_code = static_cast<int>(exit_code);
+  return data.empty();
+}
+
+bool IsQueryCommand(std::string_view command) {
+  return command == commands::kAnalyze || command == commands::kDesc ||
+         command == commands::kOutputs || command == commands::kPath ||
+         command == commands::kRefs;
+}
+
+base::FilePath GetQueryServerSocketPath(const BuildSettings* build_settings) {
+  return build_settings->GetFullPath(
+      SourceFile(build_settings->build_dir().value() + "gn_server.sock"));
+}
+
+#if defined(OS_POSIX)
+
+bool RunCommandOnQueryServer(const BuildSettings* build_settings,
+                             std::string_view stdin_contents,
+                             int* exit_code) {
+  base::FilePath socket_path = GetQueryServerSocketPath(build_settings);
+  if (!base::PathExists(socket_path))
+    return false;
+
+  QueryRequest request;
+  base::FilePath current_dir;
+  if (!base::GetCurrentDirectory(&current_dir))
+    return false;
+  request.version = LAST_COMMIT_POSITION;
+  request.current_dir = FilePathToUTF8(current_dir);
+  request.argv = base::CommandLine::ForCurrentProcess()->argv();
+  request.stdin_contents.assign(stdin_contents);
+  request.decorated_output = IsOutputDecorated();
+
+  int fd = ConnectToSocket(socket_path);
+  if (fd < 0)
+    return false;  // Not running anymore.
+
+  // Don't die if the server goes away while sending, or wait forever on one
+  // that stopped responding. Either way, the command runs in this process.
+  signal(SIGPIPE, SIG_IGN);
+  SetSocketTimeouts(fd, kClientTimeoutSeconds);
+
+  std::string data;
+  QueryResponse response;
+  bool ok = SendMessage(fd, request.Serialize()) &&
+            ReceiveMessage(fd, &data) &&
+            QueryResponse::Deserialize(data, &response);
+  close(fd);
+  if (!ok || !response.accepted)
+    return false;
+
+  fwrite(response.output.data(), 1, response.output.size(), stdout);
+  fflush(stdout);
+  *exit_code = response.exit_code;
+  return true;
+}
+
+#else
+
+bool RunCommandOnQueryServer(const BuildSettings* build_settings,
+                             std::string_view stdin_contents,
+                             int* exit_code) {
+  return false;
+}
+
+#endif  // defined(OS_POSIX)
+
+QueryServer::QueryServer(const std::string& build_dir)
+    : build_dir_(build_dir),
+      server_argv_(base::CommandLine::ForCurrentProcess()->argv()) {}
+
+QueryServer::~QueryServer() {
+#if defined(OS_POSIX)
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    base::DeleteFile(socket_path_, false);
+  }
+#endif
+  delete setup_;
+}
+
+// static
+QueryServer::FileStamp QueryServer::GetFileStamp(const base::FilePath& path) {
+  FileStamp stamp;
+  base::File::Info info;
+  if (base::GetFileInfo(path, &info)) {
+    stamp.exists = true;
+    stamp.size = info.size;
+    stamp.last_modified = info.last_modified;
+  }
+  return stamp;
+}
+
+void QueryServer::Load(const std::vector<SourceFile>* changed_files) {
+  // Keep the files that were parsed for the previous graph, minus the changed
+  // ones. The previous graph is deleted first since a Setup can't be created
+  // while another one is in use.
+  scoped_refptr<InputFileManager> input_file_manager;
+  if (setup_) {
+    if (changed_files) {
+      input_file_manager = setup_->scheduler().input_file_manager();
+      input_file_manager->InvalidateFiles(*changed_files);
+    }
+    delete setup_;
+    setup_ = nullptr;
+  }
+
+  setup_ = new Setup;
+  load_output_ = RunWithRedirectedStdio(
+      std::string_view(), [this, &input_file_manager]() {
+        loaded_ = setup_->DoSetup(build_dir_, false);
+        if (loaded_ && input_file_manager)
+          setup_->scheduler().set_input_file_manager(input_file_manager);
+        loaded_ = loaded_ && setup_->Run();
+      });
+  if (!loaded_) {
+    // Work that was left when the load failed refers to the graph.
+    MsgLoop::Current()->DiscardPendingTasks();
+  }
+  OutputString(load_output_);
+  RecordInputs();
+}
+
+void QueryServer::RecordInputs() {
+  source_inputs_.clear();
+  input_stamps_.clear();
+  for (const InputFile* file :
+       setup_->scheduler().input_file_manager()->GetLoadedPhysicalInputFiles())
+    source_inputs_[file->physical_name()] = file->name();
+  for (const auto& pair : source_inputs_)
+    input_stamps_[pair.first] = GetFileStamp(pair.first);
+  for (const base::FilePath& path : g_scheduler->GetGenDependencies())
+    input_stamps_[path] = GetFileStamp(path);
+  if (!setup_->dotfile_name().empty())
+    input_stamps_[setup_->dotfile_name()] =
+        GetFileStamp(setup_->dotfile_name());
+}
+
+void QueryServer::UpdateIfNeeded() {
+  // A failed load may be fixed by a file that didn't exist, so always retry.
+  if (!loaded_) {
+    Load(nullptr);
+    return;
+  }
+
+  std::vector<SourceFile> changed_files;
+  for (const auto& [path, stamp] : input_stamps_) {
+    if (GetFileStamp(path) == stamp)
+      continue;
+    auto found = source_inputs_.find(path);
+    if (found == source_inputs_.end()) {
+      // Not a file the input file manager loaded, such as args.gn or the
+      // dotfile. Start from scratch.
+      Load(nullptr);
+      return;
+    }
+    changed_files.push_back(found->second);
+  }
+  if (!changed_files.empty())
+    Load(&changed_files);
+}
+
+QueryResponse QueryServer::HandleRequest(const QueryRequest& request) {
+  QueryResponse response;
+#if defined(OS_POSIX)
+  if (request.version != LAST_COMMIT_POSITION || request.argv.empty())
+    return response;
+
+  base::CommandLine cmdline(request.argv);
+  std::vector<std::string> args = cmdline.GetArgs();
+  if (args.empty() || !IsQueryCommand(args[0]))
+    return response;
+  const base::CommandLine& server_cmdline =
+      *base::CommandLine::ForCurrentProcess();
+  for (const char* load_switch : kLoadSwitches) {
+    if (cmdline.GetSwitchValueString(load_switch) !=
+        server_cmdline.GetSwitchValueString(load_switch))
+      return response;
+  }
+
+  UpdateIfNeeded();
+
+  response.accepted = true;
+  if (!loaded_) {
+    response.exit_code = 1;
+    response.output = load_output_;
+    return response;
+  }
+
+  if (!base::SetCurrentDirectory(UTF8ToFilePath(request.current_dir))) {
+    response.accepted = false;
+    return response;
+  }
+
+  // Run the command as if it was invoked in this process.
+  bool decorated = IsOutputDecorated();
+  SetOutputDecorated(request.decorated_output);
+  SetProcessCommandLine(request.argv);
+  commands::SetResidentSetupForQuery(setup_);
+  response.output =
+      RunWithRedirectedStdio(request.stdin_contents, [&response, &args]() {
+        commands::CommandSwitches switches;
+        if (!switches.InitFrom(*base::CommandLine::ForCurrentProcess())) {
+          response.exit_code = 1;
+          return;
+        }
+        commands::CommandSwitches previous =
+            commands::CommandSwitches::Set(std::move(switches));
+        const commands::CommandInfoMap& command_map = commands::GetCommands();
+        response.exit_code = command_map.find(args[0])->second.runner(
+            std::vector<std::string>(args.begin() + 1, args.end()));
+        commands::CommandSwitches::Set(std::move(previous));
+      });
+  commands::SetResidentSetupForQuery(nullptr);
+  SetProcessCommandLine(server_argv_);
+  SetOutputDecorated(decorated);
+  base::SetCurrentDirectory(server_dir_);
+#endif  // defined(OS_POSIX)
+  return response;
+}
+
+#if defined(OS_POSIX)
+
+bool QueryServer::Start(Err* err) {
+  if (!base::GetCurrentDirectory(&server_dir_)) {
+    *err = Err(Location(), "Can't get the current directory.");
+    return false;
+  }
+
+  Load(nullptr);
+  if (!setup_->build_settings().root_path().empty() &&
+      !setup_->build_settings().build_dir().is_null()) {
+    socket_path_ = GetQueryServerSocketPath(&setup_->build_settings());
+  } else {
+    *err = Err(Location(), "Couldn't find the build directory.",
+               "The build directory must exist and be set up with \"gn gen\".");
+    return false;
+  }
+
+  sockaddr_un addr;
+  if (!MakeSocketAddress(socket_path_, &addr)) {
+    *err = Err(Location(), "The build directory path is too long.",
+               "The path of the server's socket must fit in a Unix domain "
+               "socket address:\n  " +
+                   FilePathToUTF8(socket_path_));
+    return false;
+  }
+
+  // Only one server can run for a build directory. A socket file without a
+  // server is left over from one that was killed.
+  int other = ConnectToSocket(socket_path_);
+  if (other >= 0) {
+    close(other);
+    *err = Err(Location(), "A server is already running.",
+               "Another \"gn server\" is serving this build directory.");
+    return false;
+  }
+  base::DeleteFile(socket_path_, false);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    *err = Err(Location(), "Couldn't create a socket.");
+    return false;
+  }
+  // Only the user may connect.
+  mode_t old_umask = umask(0077);
+  int bound =
+      bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  umask(old_umask);
+  if (bound != 0 || listen(listen_fd_, SOMAXCONN) != 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+    *err = Err(Location(), "Couldn't listen on the socket.",
+               FilePathToUTF8(socket_path_));
+    return false;
+  }
+
+  // Don't die if a client goes away before getting its response.
+  signal(SIGPIPE, SIG_IGN);
+  return true;
+}
+
+bool QueryServer::Run(Err* err) {
+  for (;;) {
+    int fd = HANDLE_EINTR(accept(listen_fd_, nullptr, nullptr));
+    if (fd < 0) {
+      switch (errno) {
+        case ECONNABORTED:
+        case EPROTO:
+          // The client went away before being accepted.
+          continue;
+        case EMFILE:
+        case ENFILE:
+        case ENOBUFS:
+        case ENOMEM:
+          // Wait for resources to be released instead of spinning.
+          usleep(kAcceptRetryMicroseconds);
+          continue;
+        default:
+          *err = Err(Location(), "Couldn't accept connections.",
+                     std::string(strerror(errno)));
+          return false;
+      }
+    }
+    ServeConnection(fd);
+    close(fd);
+  }
+}
+
+void QueryServer::ServeConnection(int fd) {
+  SetSocketTimeouts(fd, kServerTimeoutSeconds);
+  std::string data;
+  QueryRequest request;
+  if (!ReceiveMessage(fd, &data) || !QueryRequest::Deserialize(data, &request))
+    return;
+  SendMessage(fd, HandleRequest(request).Serialize());
+}
+
+#else
+
+bool QueryServer::Start(Err* err) {
+  *err = Err(Location(), "\"gn server\" isn't supported on this platform.");
+  return false;
+}
+
+bool QueryServer::Run(Err* err) {
+  *err = Err(Location(), "\"gn server\" isn't supported on this platform.");
+  return false;
+}
+
+void QueryServer::ServeConnection(int fd) {}
+
+#endif  // defined(OS_POSIX)
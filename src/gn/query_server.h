@@ -0,0 +1,147 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_QUERY_SERVER_H_
+#define TOOLS_GN_QUERY_SERVER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "gn/source_file.h"
+#include "util/ticks.h"
+
+class BuildSettings;
+class Err;
+class Setup;
+
+// "gn server" keeps the build graph of one build directory in memory and runs
+// the commands that only query it (see IsQueryCommand()) on behalf of other
+// GN processes. Those forward their command line to the server over a Unix
+// domain socket in the build directory, and print what the server sends back.
+//
+// Before running a command, the server checks whether any file read while
+// loading the graph has changed and if so loads the graph again, parsing
+// only the changed files again.
+
+// A command forwarded to the server.
+struct QueryRequest {
+  // Identifies the version of GN. Servers refuse requests from other
+  // versions.
+  std::string version;
+
+  std::string current_dir;
+  std::vector<std::string> argv;
+
+  // What the command reads from the standard input.
+  std::string stdin_contents;
+
+  // Whether the output should be decorated with colors.
+  bool decorated_output = false;
+
+  std::string Serialize() const;
+  static bool Deserialize(std::string_view data, QueryRequest* out);
+};
+
+struct QueryResponse {
+  // False if the server refused to run the command, in which case the client
+  // runs it itself.
+  bool accepted = false;
+
+  int exit_code = 0;
+  std::string output;
+
+  std::string Serialize() const;
+  static bool Deserialize(std::string_view data, QueryResponse* out);
+};
+
+// Returns true if the given command can be run by the server.
+bool IsQueryCommand(std::string_view command);
+
+// Returns the path of the server's socket in the given build directory.
+base::FilePath GetQueryServerSocketPath(const BuildSettings* build_settings);
+
+// Runs the command line of the current process on the server for the given
+// build directory and prints its output. Returns false if there is no server,
+// or it refused the request, in which case the command should be run
+// locally. |stdin_contents| is what the command already read from the
+// standard input.
+bool RunCommandOnQueryServer(const BuildSettings* build_settings,
+                             std::string_view stdin_contents,
+                             int* exit_code);
+
+class QueryServer {
+ public:
+  // |build_dir| is the build directory as given on the command line.
+  explicit QueryServer(const std::string& build_dir);
+  ~QueryServer();
+
+  // Loads the build graph and starts listening. On failure, returns false and
+  // sets the error. Errors from loading the graph are printed instead, and
+  // reported to clients until a change to the inputs fixes them.
+  bool Start(Err* err);
+
+  // Serves requests until the process is killed. Returns false if the server
+  // can't accept connections anymore.
+  bool Run(Err* err);
+
+  // Handles one request. Exposed for testing.
+  QueryResponse HandleRequest(const QueryRequest& request);
+
+ private:
+  // Size and modification time of an input.
+  struct FileStamp {
+    bool exists = false;
+    int64_t size = 0;
+    Ticks last_modified = 0;
+
+    bool operator==(const FileStamp& other) const {
+      return exists == other.exists && size == other.size &&
+             last_modified == other.last_modified;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+  };
+  static FileStamp GetFileStamp(const base::FilePath& path);
+
+  // Loads the build graph. If |changed_files| is set, the files parsed for
+  // the previous graph are reused except for those.
+  void Load(const std::vector<SourceFile>* changed_files);
+
+  // Loads the graph again if any of its inputs changed since it was loaded.
+  void UpdateIfNeeded();
+
+  // Records the stamps of the inputs of the current graph.
+  void RecordInputs();
+
+  // Serves the client connected on the given socket.
+  void ServeConnection(int fd);
+
+  std::string build_dir_;
+  base::FilePath server_dir_;
+  std::vector<std::string> server_argv_;
+
+  // The current build graph, null while not loaded. Owned.
+  Setup* setup_ = nullptr;
+
+  // Whether the graph loaded successfully, and what was printed while
+  // loading it.
+  bool loaded_ = false;
+  std::string load_output_;
+
+  // Inputs that were loaded through the input file manager, by name, and all
+  // files the graph depends on with their stamps when it was loaded.
+  std::map<base::FilePath, SourceFile> source_inputs_;
+  std::map<base::FilePath, FileStamp> input_stamps_;
+
+  int listen_fd_ = -1;
+  base::FilePath socket_path_;
+
+  QueryServer(const QueryServer&) = delete;
+  QueryServer& operator=(const QueryServer&) = delete;
+};
+
+#endif  // TOOLS_GN_QUERY_SERVER_H_
@@ -0,0 +1,66 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/query_server.h"
+
+#include "util/test/test.h"
+
+TEST(QueryServer, RequestRoundTrip) {
+  QueryRequest request;
+  request.version = "1234 (abcdef)";
+  request.current_dir = "/src/out";
+  request.argv = {"gn", "desc", ".", "//foo:bar", "--format=json"};
+  request.stdin_contents = std::string("{\"files\": []}\0x", 16);
+  request.decorated_output = true;
+  std::string data = request.Serialize();
+
+  QueryRequest loaded;
+  ASSERT_TRUE(QueryRequest::Deserialize(data, &loaded));
+  EXPECT_EQ(request.version, loaded.version);
+  EXPECT_EQ(request.current_dir, loaded.current_dir);
+  EXPECT_EQ(request.argv, loaded.argv);
+  EXPECT_EQ(request.stdin_contents, loaded.stdin_contents);
+  EXPECT_TRUE(loaded.decorated_output);
+
+  // Every truncation must be detected, as well as trailing garbage.
+  for (size_t i = 0; i < data.size(); i++) {
+    QueryRequest truncated;
+    EXPECT_FALSE(QueryRequest::Deserialize(data.substr(0, i), &truncated));
+  }
+  QueryRequest extended;
+  EXPECT_FALSE(QueryRequest::Deserialize(data + "x", &extended));
+}
+
+TEST(QueryServer, ResponseRoundTrip) {
+  QueryResponse response;
+  response.accepted = true;
+  response.exit_code = 1;
+  response.output = "ERROR at //BUILD.gn:1:1\n";
+  std::string data = response.Serialize();
+
+  QueryResponse loaded;
+  ASSERT_TRUE(QueryResponse::Deserialize(data, &loaded));
+  EXPECT_TRUE(loaded.accepted);
+  EXPECT_EQ(1, loaded.exit_code);
+  EXPECT_EQ(response.output, loaded.output);
+
+  for (size_t i = 0; i < data.size(); i++) {
+    QueryResponse truncated;
+    EXPECT_FALSE(QueryResponse::Deserialize(data.substr(0, i), &truncated));
+  }
+  QueryResponse extended;
+  EXPECT_FALSE(QueryResponse::Deserialize(data + "x", &extended));
+}
+
+TEST(QueryServer, IsQueryCommand) {
+  EXPECT_TRUE(IsQueryCommand("desc"));
+  EXPECT_TRUE(IsQueryCommand("refs"));
+  EXPECT_TRUE(IsQueryCommand("analyze"));
+
+  // Commands that write files or don't need the build graph.
+  EXPECT_FALSE(IsQueryCommand("gen"));
+  EXPECT_FALSE(IsQueryCommand("clean"));
+  EXPECT_FALSE(IsQueryCommand("format"));
+  EXPECT_FALSE(IsQueryCommand("server"));
+}
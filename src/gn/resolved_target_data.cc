@@ -63,12 +63,31 @@ void ResolvedTargetData::ComputeFrameworkInfo(TargetInfo* info) const {
   info->has_framework_info = true;
 }
 
+std::vector<const Target*> ResolvedTargetData::GetHardDeps(
+    const Target* target) const {
+  std::vector<const Target*> result;
+  const CompressedBitSet& hard_deps = *GetTargetHardDeps(target)->hard_deps;
+  result.reserve(hard_deps.size());
+  hard_deps.ForEach([this, &result](size_t index) {
+    result.push_back(hard_deps_[index]);
+  });
+  return result;
+}
+
+bool ResolvedTargetData::HasHardDep(const Target* target,
+                                    const Target* dep) const {
+  size_t index = hard_deps_.IndexOf(dep);
+  return index != UniqueVector<const Target*>::kIndexNone &&
+         GetTargetHardDeps(target)->hard_deps->contains(index);
+}
+
 void ResolvedTargetData::ComputeHardDeps(TargetInfo* info) const {
-  TargetSet all_hard_deps;
+  CompressedBitSet all_hard_deps;
+  std::shared_ptr<const CompressedBitSet> first_dep_hard_deps;
   for (const Target* dep : info->deps.linked_deps()) {
     // Direct hard dependencies
     if (info->target->hard_dep() || dep->hard_dep()) {
-      all_hard_deps.insert(dep);
+      all_hard_deps.insert(hard_deps_.PushBackWithIndex(dep).second);
       continue;
     }
     // If |dep| is binary target and |dep| has no public header,
@@ -83,9 +102,18 @@ void ResolvedTargetData::ComputeHardDeps(TargetInfo* info) const {
 
     // Recursive hard dependencies of all dependencies.
     const TargetInfo* dep_info = GetTargetHardDeps(dep);
-    all_hard_deps.insert(dep_info->hard_deps);
+    if (!first_dep_hard_deps && !dep_info->hard_deps->empty())
+      first_dep_hard_deps = dep_info->hard_deps;
+    all_hard_deps.insert(*dep_info->hard_deps);
   }
-  info->hard_deps = std::move(all_hard_deps);
+
+  // Share the set of the first dependency when nothing else was added to it,
+  // as when hard deps are forwarded through long chains of groups.
+  if (first_dep_hard_deps && *first_dep_hard_deps == all_hard_deps)
+    info->hard_deps = std::move(first_dep_hard_deps);
+  else
+    info->hard_deps =
+        std::make_shared<const CompressedBitSet>(std::move(all_hard_deps));
   info->has_hard_deps = true;
 }
 
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/containers/span.h"
+#include "gn/compressed_bit_set.h"
 #include "gn/lib_file.h"
 #include "gn/resolved_target_deps.h"
 #include "gn/source_dir.h"
@@ -98,10 +99,11 @@ class ResolvedTargetData {
 
   // Retrieves a set of hard dependencies for this target.
   // All hard deps from this target and all dependencies, but not the
-  // target itself.
-  const TargetSet& GetHardDeps(const Target* target) const {
-    return GetTargetHardDeps(target)->hard_deps;
-  }
+  // target itself, in the order in which they were first found.
+  std::vector<const Target*> GetHardDeps(const Target* target) const;
+
+  // Returns true if |dep| is one of the hard dependencies of |target|.
+  bool HasHardDep(const Target* target, const Target* dep) const;
 
   // Retrieves an ordered list of (target, is_public) pairs for all link-time
   // libraries inherited by this target.
@@ -158,8 +160,10 @@ class ResolvedTargetData {
     std::vector<std::string> frameworks;
     std::vector<std::string> weak_frameworks;
 
-    // Only valid if |has_hard_deps| is true.
-    TargetSet hard_deps;
+    // Only valid if |has_hard_deps| is true. The indices in |hard_deps_| of
+    // the hard deps. Targets that only forward the hard deps of one of their
+    // dependencies share its set.
+    std::shared_ptr<const CompressedBitSet> hard_deps;
 
     // Only valid if |has_inherited_libs| is true.
     std::vector<TargetPublicPair> inherited_libs;
@@ -274,6 +278,11 @@ class ResolvedTargetData {
   // instances for best performance.
   mutable UniqueVector<const Target*> targets_;
   mutable std::vector<std::unique_ptr<TargetInfo>> infos_;
+
+  // The targets that are hard deps of others. They are numbered in the order
+  // in which they are found, so that the hard deps of a target, which are
+  // usually found together, have nearby indices.
+  mutable UniqueVector<const Target*> hard_deps_;
 };
 
 #endif  // TOOLS_GN_RESOLVED_TARGET_DATA_H_
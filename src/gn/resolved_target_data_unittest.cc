@@ -408,3 +408,46 @@ TEST(ResolvedTargetDataTest, SharedInheritance) {
   EXPECT_EQ(&inter, exe_inherited[0].target());
   EXPECT_EQ(&pub, exe_inherited[1].target());
 }
+
+// Tests that hard deps are inherited through targets whose headers are public.
+TEST(ResolvedTargetDataTest, HardDeps) {
+  TestWithScope setup;
+  Err err;
+
+  // Create a dependency graph:
+  //   A (exe) -> B (group) -> C (group) -> D (action)
+  //                        -> E (action) -> F (action)
+  //           -> G (source_set, private headers) -> H (action)
+  TestTarget a(setup, "//foo:a", Target::EXECUTABLE);
+  TestTarget b(setup, "//foo:b", Target::GROUP);
+  TestTarget c(setup, "//foo:c", Target::GROUP);
+  TestTarget d(setup, "//foo:d", Target::ACTION);
+  TestTarget e(setup, "//foo:e", Target::ACTION);
+  TestTarget f(setup, "//foo:f", Target::ACTION);
+  TestTarget g(setup, "//foo:g", Target::SOURCE_SET);
+  TestTarget h(setup, "//foo:h", Target::ACTION);
+  g.set_all_headers_public(false);
+
+  a.private_deps().push_back(LabelTargetPair(&b));
+  a.private_deps().push_back(LabelTargetPair(&g));
+  b.private_deps().push_back(LabelTargetPair(&c));
+  b.private_deps().push_back(LabelTargetPair(&e));
+  c.private_deps().push_back(LabelTargetPair(&d));
+  e.private_deps().push_back(LabelTargetPair(&f));
+  g.private_deps().push_back(LabelTargetPair(&h));
+
+  for (TestTarget* target : {&h, &g, &f, &e, &d, &c, &b, &a})
+    ASSERT_TRUE(target->OnResolved(&err));
+
+  ResolvedTargetData resolved;
+  EXPECT_EQ((std::vector<const Target*>{&d, &e}), resolved.GetHardDeps(&a));
+  EXPECT_EQ((std::vector<const Target*>{&d, &e}), resolved.GetHardDeps(&b));
+  EXPECT_EQ((std::vector<const Target*>{&d}), resolved.GetHardDeps(&c));
+  EXPECT_EQ((std::vector<const Target*>{&f}), resolved.GetHardDeps(&e));
+  EXPECT_EQ((std::vector<const Target*>{&h}), resolved.GetHardDeps(&g));
+
+  EXPECT_TRUE(resolved.HasHardDep(&a, &e));
+  EXPECT_FALSE(resolved.HasHardDep(&a, &f));
+  EXPECT_FALSE(resolved.HasHardDep(&a, &h));
+  EXPECT_FALSE(resolved.HasHardDep(&a, &b));
+}
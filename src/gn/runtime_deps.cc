@@ -4,8 +4,8 @@
 
 #include "gn/runtime_deps.h"
 
-#include <map>
-#include <set>
+#include <mutex>
+#include <optional>
 #include <sstream>
 
 #include "base/command_line.h"
@@ -28,106 +28,6 @@ namespace {
 
 using RuntimeDepsVector = std::vector<std::pair<OutputFile, const Target*>>;
 
-// Adds the given file to the deps list if it hasn't already been listed in
-// the found_files list. Updates the list.
-void AddIfNew(const OutputFile& output_file,
-              const Target* source,
-              RuntimeDepsVector* deps,
-              std::set<OutputFile>* found_file) {
-  if (found_file->find(output_file) != found_file->end())
-    return;  // Already there.
-  deps->push_back(std::make_pair(output_file, source));
-}
-
-// Automatically converts a string that looks like a source to an OutputFile.
-void AddIfNew(const std::string& str,
-              const Target* source,
-              RuntimeDepsVector* deps,
-              std::set<OutputFile>* found_file) {
-  OutputFile output_file(
-      RebasePath(str, source->settings()->build_settings()->build_dir(),
-                 source->settings()->build_settings()->root_path_utf8()));
-  AddIfNew(output_file, source, deps, found_file);
-}
-
-// To avoid duplicate traversals of targets, or duplicating output files that
-// might be listed by more than one target, the set of targets and output files
-// that have been found so far is passed. The "value" of the seen_targets map
-// is a boolean indicating if the seen dep was a data dep (true = data_dep).
-// data deps add more stuff, so we will want to revisit a target if it's a
-// data dependency and we've previously only seen it as a regular dep.
-void RecursiveCollectRuntimeDeps(const Target* target,
-                                 bool is_target_data_dep,
-                                 RuntimeDepsVector* deps,
-                                 std::map<const Target*, bool>* seen_targets,
-                                 std::set<OutputFile>* found_files) {
-  const auto& found_seen_target = seen_targets->find(target);
-  if (found_seen_target != seen_targets->end()) {
-    // Already visited.
-    if (found_seen_target->second || !is_target_data_dep) {
-      // Already visited as a data dep, or the current dep is not a data
-      // dep so visiting again will be a no-op.
-      return;
-    }
-    // In the else case, the previously seen target was a regular dependency
-    // and we'll now process it as a data dependency.
-  }
-  (*seen_targets)[target] = is_target_data_dep;
-
-  // Add the main output file for executables, shared libraries, and
-  // loadable modules.
-  if (target->output_type() == Target::EXECUTABLE ||
-      target->output_type() == Target::LOADABLE_MODULE ||
-      target->output_type() == Target::SHARED_LIBRARY) {
-    for (const auto& runtime_output : target->runtime_outputs())
-      AddIfNew(runtime_output, target, deps, found_files);
-  }
-
-  // Add all data files.
-  for (const auto& file : target->data())
-    AddIfNew(file, target, deps, found_files);
-
-  // Actions/copy have all outputs considered when the're a data dep.
-  if (is_target_data_dep && (target->output_type() == Target::ACTION ||
-                             target->output_type() == Target::ACTION_FOREACH ||
-                             target->output_type() == Target::COPY_FILES)) {
-    std::vector<SourceFile> outputs;
-    target->action_values().GetOutputsAsSourceFiles(target, &outputs);
-    for (const auto& output_file : outputs)
-      AddIfNew(output_file.value(), target, deps, found_files);
-  }
-
-  // Data dependencies.
-  for (const auto& dep_pair : target->data_deps()) {
-    RecursiveCollectRuntimeDeps(dep_pair.ptr, true, deps, seen_targets,
-                                found_files);
-  }
-
-  // Do not recurse into bundle targets. A bundle's dependencies should be
-  // copied into the bundle itself for run-time access.
-  if (target->output_type() == Target::CREATE_BUNDLE) {
-    SourceDir bundle_root_dir =
-        target->bundle_data().GetBundleRootDirOutputAsDir(target->settings());
-    AddIfNew(bundle_root_dir.value(), target, deps, found_files);
-    return;
-  }
-
-  // Non-data dependencies (both public and private).
-  for (const auto& dep_pair : target->GetDeps(Target::DEPS_LINKED)) {
-    if (dep_pair.ptr->output_type() == Target::EXECUTABLE)
-      continue;  // Skip executables that aren't data deps.
-    if (dep_pair.ptr->output_type() == Target::SHARED_LIBRARY &&
-        (target->output_type() == Target::ACTION ||
-         target->output_type() == Target::ACTION_FOREACH)) {
-      // Skip shared libraries that action depends on,
-      // unless it were listed in data deps.
-      continue;
-    }
-    RecursiveCollectRuntimeDeps(dep_pair.ptr, false, deps, seen_targets,
-                                found_files);
-  }
-}
-
 bool CollectRuntimeDepsFromFlag(const BuildSettings* build_settings,
                                 const Builder& builder,
                                 RuntimeDepsVector* files_to_write,
@@ -206,6 +106,7 @@ bool CollectRuntimeDepsFromFlag(const BuildSettings* build_settings,
 
 bool WriteRuntimeDepsFile(const OutputFile& output_file,
                           const Target* target,
+                          const RuntimeDepsVector& runtime_deps,
                           Err* err) {
   SourceFile output_as_source =
       output_file.AsSourceFile(target->settings()->build_settings());
@@ -214,7 +115,7 @@ bool WriteRuntimeDepsFile(const OutputFile& output_file,
 
   StringOutputBuffer storage;
   std::ostream contents(&storage);
-  for (const auto& pair : ComputeRuntimeDeps(target))
+  for (const auto& pair : runtime_deps)
     contents << pair.first.value() << std::endl;
 
   ScopedTrace trace(TraceItem::TRACE_FILE_WRITE, output_as_source.value());
@@ -293,18 +194,173 @@ Multiple outputs
 )";
 
 RuntimeDepsVector ComputeRuntimeDeps(const Target* target) {
-  RuntimeDepsVector result;
-  std::map<const Target*, bool> seen_targets;
-  std::set<OutputFile> found_files;
+  return RuntimeDepsCalculator().Compute(target);
+}
+
+RuntimeDepsCalculator::RuntimeDepsCalculator() = default;
+
+RuntimeDepsCalculator::~RuntimeDepsCalculator() = default;
 
+RuntimeDepsVector RuntimeDepsCalculator::Compute(const Target* target) {
+  Prepare(target);
+  return ComputePrepared(target);
+}
+
+void RuntimeDepsCalculator::Prepare(const Target* target) {
   // The initial target is not considered a data dependency so that actions's
   // outputs (if the current target is an action) are not automatically
   // considered data deps.
-  RecursiveCollectRuntimeDeps(target, false, &result, &seen_targets,
-                              &found_files);
+  GetNode(target, false);
+}
+
+RuntimeDepsVector RuntimeDepsCalculator::ComputePrepared(
+    const Target* target) const {
+  const Node* root = nodes_.at(target).regular.get();
+
+  // Walk the nodes depth-first, skipping the nodes already seen and keeping
+  // the first occurrence of each file. This lists the files in the same order
+  // as a depth-first walk of the targets. The walk uses its own stack, so that
+  // long dependency chains don't overflow the thread's.
+  RuntimeDepsVector result;
+  std::vector<bool> seen_nodes(node_count_);
+  std::vector<bool> seen_files(files_.size());
+  auto visit = [this, &result, &seen_nodes, &seen_files](const Node* node) {
+    seen_nodes[node->index] = true;
+    for (const Entry& entry : node->entries) {
+      if (seen_files[entry.file])
+        continue;
+      seen_files[entry.file] = true;
+      result.emplace_back(files_[entry.file], entry.source);
+    }
+  };
+
+  std::vector<std::pair<const Node*, size_t>> stack;
+  visit(root);
+  stack.emplace_back(root, 0);
+  while (!stack.empty()) {
+    auto& [node, next_dep] = stack.back();
+    if (next_dep == node->deps.size()) {
+      stack.pop_back();
+      continue;
+    }
+    const Node* dep = node->deps[next_dep++];
+    if (seen_nodes[dep->index])
+      continue;
+    visit(dep);
+    stack.emplace_back(dep, 0);
+  }
   return result;
 }
 
+const RuntimeDepsCalculator::Node* RuntimeDepsCalculator::GetNode(
+    const Target* target,
+    bool is_target_data_dep) {
+  // Nodes are created with their own entries, then get their dependencies
+  // from this list, which avoids recursing down long dependency chains.
+  std::vector<std::pair<Node*, const Target*>> pending;
+  const Node* result = FindOrAddNode(target, is_target_data_dep, &pending);
+  while (!pending.empty()) {
+    auto [node, cur] = pending.back();
+    pending.pop_back();
+
+    for (const auto& dep_pair : cur->data_deps())
+      node->deps.push_back(FindOrAddNode(dep_pair.ptr, true, &pending));
+
+    // Do not recurse into bundle targets. A bundle's dependencies should be
+    // copied into the bundle itself for run-time access. The bundle directory
+    // goes after the data deps.
+    if (cur->output_type() == Target::CREATE_BUNDLE) {
+      std::unique_ptr<Node>& bundle = nodes_[cur].bundle;
+      bundle = std::make_unique<Node>();
+      bundle->index = node_count_++;
+      SourceDir bundle_root_dir =
+          cur->bundle_data().GetBundleRootDirOutputAsDir(cur->settings());
+      AddEntry(bundle_root_dir.value(), cur, &bundle->entries);
+      node->deps.push_back(bundle.get());
+      continue;
+    }
+
+    // Non-data dependencies (both public and private).
+    for (const auto& dep_pair : cur->GetDeps(Target::DEPS_LINKED)) {
+      if (dep_pair.ptr->output_type() == Target::EXECUTABLE)
+        continue;  // Skip executables that aren't data deps.
+      if (dep_pair.ptr->output_type() == Target::SHARED_LIBRARY &&
+          (cur->output_type() == Target::ACTION ||
+           cur->output_type() == Target::ACTION_FOREACH)) {
+        // Skip shared libraries that action depends on,
+        // unless it were listed in data deps.
+        continue;
+      }
+      node->deps.push_back(FindOrAddNode(dep_pair.ptr, false, &pending));
+    }
+  }
+  return result;
+}
+
+RuntimeDepsCalculator::Node* RuntimeDepsCalculator::FindOrAddNode(
+    const Target* target,
+    bool is_target_data_dep,
+    std::vector<std::pair<Node*, const Target*>>* pending) {
+  // Being a data dep only adds the outputs of actions and copies, other
+  // targets have one node.
+  if (target->output_type() != Target::ACTION &&
+      target->output_type() != Target::ACTION_FOREACH &&
+      target->output_type() != Target::COPY_FILES)
+    is_target_data_dep = false;
+  TargetNodes& nodes = nodes_[target];
+  std::unique_ptr<Node>& node = is_target_data_dep ? nodes.data : nodes.regular;
+  if (node)
+    return node.get();
+
+  node = std::make_unique<Node>();
+  node->index = node_count_++;
+  AddOwnEntries(target, is_target_data_dep, &node->entries);
+  pending->emplace_back(node.get(), target);
+  return node.get();
+}
+
+void RuntimeDepsCalculator::AddOwnEntries(const Target* target,
+                                          bool is_target_data_dep,
+                                          std::vector<Entry>* entries) {
+  // Add the main output file for executables, shared libraries, and
+  // loadable modules.
+  if (target->output_type() == Target::EXECUTABLE ||
+      target->output_type() == Target::LOADABLE_MODULE ||
+      target->output_type() == Target::SHARED_LIBRARY) {
+    for (const auto& runtime_output : target->runtime_outputs())
+      entries->push_back({GetFileIndex(runtime_output), target});
+  }
+
+  // Add all data files.
+  for (const auto& file : target->data())
+    AddEntry(file, target, entries);
+
+  // Actions/copy have all outputs considered when the're a data dep.
+  if (is_target_data_dep) {
+    std::vector<SourceFile> outputs;
+    target->action_values().GetOutputsAsSourceFiles(target, &outputs);
+    for (const auto& output_file : outputs)
+      AddEntry(output_file.value(), target, entries);
+  }
+}
+
+// Automatically converts a string that looks like a source to an OutputFile.
+void RuntimeDepsCalculator::AddEntry(const std::string& str,
+                                     const Target* source,
+                                     std::vector<Entry>* entries) {
+  OutputFile output_file(
+      RebasePath(str, source->settings()->build_settings()->build_dir(),
+                 source->settings()->build_settings()->root_path_utf8()));
+  entries->push_back({GetFileIndex(output_file), source});
+}
+
+uint32_t RuntimeDepsCalculator::GetFileIndex(const OutputFile& file) {
+  auto inserted = file_indices_.emplace(file, files_.size());
+  if (inserted.second)
+    files_.push_back(file);
+  return inserted.first->second;
+}
+
 bool WriteRuntimeDepsFilesIfNecessary(const BuildSettings* build_settings,
                                       const Builder& builder,
                                       Err* err) {
@@ -319,12 +375,28 @@ bool WriteRuntimeDepsFilesIfNecessary(const BuildSettings* build_settings,
         std::make_pair(target->write_runtime_deps_output(), target));
   }
 
+  // The targets usually share most of their dependencies, so add the nodes of
+  // all of them to one calculator first. Then each task on the scheduler's
+  // pool walks the nodes of its target and writes its file.
+  RuntimeDepsCalculator calculator;
+  for (const auto& entry : files_to_write)
+    calculator.Prepare(entry.second);
+
+  std::mutex err_lock;
   for (const auto& entry : files_to_write) {
-    // Currently this writes all runtime deps files sequentially. We generally
-    // expect few of these. We can run this on the worker pool if it looks
-    // like it's talking a long time.
-    if (!WriteRuntimeDepsFile(entry.first, entry.second, err))
-      return false;
+    g_scheduler->PostPoolTask([output_file = entry.first,
+                               target = entry.second, &calculator, &err_lock,
+                               err]() {
+      Err write_err;
+      if (!WriteRuntimeDepsFile(output_file, target,
+                                calculator.ComputePrepared(target),
+                                &write_err)) {
+        std::lock_guard<std::mutex> lock(err_lock);
+        if (!err->has_error())
+          *err = write_err;
+      }
+    });
   }
-  return true;
+  g_scheduler->WaitForPoolTasks();
+  return !err->has_error();
 }
@@ -5,13 +5,19 @@
 #ifndef TOOLS_GN_RUNTIME_DEPS_H
 #define TOOLS_GN_RUNTIME_DEPS_H
 
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "gn/output_file.h"
+
 class Builder;
 class BuildSettings;
 class Err;
-class OutputFile;
 class Target;
 
 extern const char kRuntimeDeps_Help[];
@@ -22,6 +28,80 @@ extern const char kRuntimeDeps_Help[];
 std::vector<std::pair<OutputFile, const Target*>> ComputeRuntimeDeps(
     const Target* target);
 
+// Computes the runtime dependencies of several targets. The own runtime deps
+// of each target are only computed once, and are shared by all the targets
+// depending on it. Not thread-safe.
+class RuntimeDepsCalculator {
+ public:
+  RuntimeDepsCalculator();
+  ~RuntimeDepsCalculator();
+
+  // Same result as ComputeRuntimeDeps().
+  std::vector<std::pair<OutputFile, const Target*>> Compute(
+      const Target* target);
+
+  // Compute() in two steps: Prepare() adds the nodes of the target and its
+  // dependencies, then ComputePrepared() walks them. ComputePrepared() may
+  // run on several threads at once, as long as no Prepare() runs meanwhile.
+  void Prepare(const Target* target);
+  std::vector<std::pair<OutputFile, const Target*>> ComputePrepared(
+      const Target* target) const;
+
+ private:
+  // A runtime dependency, the file being an index in files_.
+  struct Entry {
+    uint32_t file;
+    const Target* source;
+  };
+
+  // The runtime deps a target adds itself, and the nodes of the dependencies
+  // contributing theirs, in the order they are listed. Nodes are shared by all
+  // the targets depending on them, so memory grows with the size of the graph
+  // rather than with the number of files reachable from each target.
+  struct Node {
+    size_t index = 0;  // Unique, less than node_count_.
+    std::vector<Entry> entries;
+    std::vector<const Node*> deps;
+  };
+
+  // The nodes of a target, depending on whether it's reached as a data dep.
+  // A bundle gets an extra node for its directory, which goes after its data
+  // deps.
+  struct TargetNodes {
+    std::unique_ptr<Node> regular;
+    std::unique_ptr<Node> data;
+    std::unique_ptr<Node> bundle;
+  };
+
+  // Returns the node of the given target, creating it and those of its
+  // dependencies the first time.
+  const Node* GetNode(const Target* target, bool is_target_data_dep);
+
+  // Returns the node of the given target. A new node only has its own entries
+  // and is added to |pending| to get its dependencies.
+  Node* FindOrAddNode(const Target* target,
+                      bool is_target_data_dep,
+                      std::vector<std::pair<Node*, const Target*>>* pending);
+
+  // Appends the entries of the target itself, without its dependencies.
+  void AddOwnEntries(const Target* target,
+                     bool is_target_data_dep,
+                     std::vector<Entry>* entries);
+  void AddEntry(const std::string& str,
+                const Target* source,
+                std::vector<Entry>* entries);
+  uint32_t GetFileIndex(const OutputFile& file);
+
+  std::vector<OutputFile> files_;
+  std::unordered_map<OutputFile, uint32_t> file_indices_;
+
+  std::unordered_map<const Target*, TargetNodes> nodes_;
+  size_t node_count_ = 0;
+
+  RuntimeDepsCalculator(const RuntimeDepsCalculator&) = delete;
+  RuntimeDepsCalculator& operator=(const RuntimeDepsCalculator&) = delete;
+};
+
 // Writes all runtime deps files requested on the command line, or does nothing
 // if no files were specified.
 bool WriteRuntimeDepsFilesIfNecessary(const BuildSettings* build_settings,
@@ -419,6 +419,58 @@ TEST_F(RuntimeDeps, Dupe) {
       << GetVectorDescription(result);
 }
 
+// Tests that files listed by more than one target are only listed once, and
+// that targets sharing dependencies get the same results from one calculator.
+TEST_F(RuntimeDeps, SharedDependencies) {
+  TestWithScope setup;
+  Err err;
+
+  // Dependency hierarchy: first(exe) --[data_deps]--> shared(group) -> base
+  //                       second(exe) -> shared(group)
+  Target base(setup.settings(), Label(SourceDir("//"), "base"));
+  InitTargetWithType(setup, &base, Target::SOURCE_SET);
+  base.data().push_back("//base.dat");
+  base.data().push_back("//common.dat");
+  ASSERT_TRUE(base.OnResolved(&err));
+
+  Target shared(setup.settings(), Label(SourceDir("//"), "shared"));
+  InitTargetWithType(setup, &shared, Target::GROUP);
+  shared.data().push_back("//common.dat");
+  shared.private_deps().push_back(LabelTargetPair(&base));
+  ASSERT_TRUE(shared.OnResolved(&err));
+
+  Target first(setup.settings(), Label(SourceDir("//"), "first"));
+  InitTargetWithType(setup, &first, Target::EXECUTABLE);
+  first.data().push_back("//base.dat");
+  first.data_deps().push_back(LabelTargetPair(&shared));
+  ASSERT_TRUE(first.OnResolved(&err));
+
+  Target second(setup.settings(), Label(SourceDir("//"), "second"));
+  InitTargetWithType(setup, &second, Target::EXECUTABLE);
+  second.private_deps().push_back(LabelTargetPair(&shared));
+  ASSERT_TRUE(second.OnResolved(&err));
+
+  RuntimeDepsCalculator calculator;
+  std::vector<std::pair<OutputFile, const Target*>> result =
+      calculator.Compute(&first);
+  EXPECT_EQ((std::vector<std::pair<OutputFile, const Target*>>{
+                MakePair("./first", &first),
+                MakePair("../../base.dat", &first),
+                MakePair("../../common.dat", &shared)}),
+            result)
+      << GetVectorDescription(result);
+  EXPECT_EQ(ComputeRuntimeDeps(&first), result);
+
+  result = calculator.Compute(&second);
+  EXPECT_EQ((std::vector<std::pair<OutputFile, const Target*>>{
+                MakePair("./second", &second),
+                MakePair("../../common.dat", &shared),
+                MakePair("../../base.dat", &base)}),
+            result)
+      << GetVectorDescription(result);
+  EXPECT_EQ(ComputeRuntimeDeps(&second), result);
+}
+
 // Tests that actions can't have output substitutions.
 TEST_F(RuntimeDeps, WriteRuntimeDepsVariable) {
   TestWithScope setup;
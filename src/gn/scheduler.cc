@@ -6,8 +6,11 @@
 
 #include <algorithm>
 
+#include "gn/import_manager.h"
 #include "gn/standard_out.h"
+#include "gn/string_atom.h"
 #include "gn/target.h"
+#include "gn/trace.h"
 
 namespace {}  // namespace
 
@@ -24,6 +27,13 @@ Scheduler::~Scheduler() {
   g_scheduler = nullptr;
 }
 
+void Scheduler::set_share_imports(bool share) {
+  if (share)
+    shared_imports_ = std::make_unique<SharedImports>();
+  else
+    shared_imports_.reset();
+}
+
 bool Scheduler::Run() {
   main_thread_run_loop_->Run();
   bool local_is_failed;
@@ -35,6 +45,26 @@ bool Scheduler::Run() {
   // Don't do this while holding |lock_|, since it will block on the workers,
   // which may be in turn waiting on the lock.
   WaitForPoolTasks();
+
+  if (TracingEnabled()) {
+    WorkerPool::Stats stats = worker_pool_.GetStats();
+    SetTraceCounterMax("worker_pool.threads", worker_pool_.thread_count());
+    AddTraceCounter("worker_pool.tasks_run", stats.tasks_run);
+    AddTraceCounter("worker_pool.steals", stats.steals);
+    AddTraceCounter("worker_pool.idle_ms",
+                    TickDelta(stats.idle_nanoseconds).InMilliseconds());
+    SetTraceCounterMax("worker_pool.max_queue_depth", stats.max_queue_depth);
+
+    AddTraceCounter("input_files.lock_contention",
+                    input_file_manager_->TakeLockContention());
+
+    // String atoms are global, so these are totals for the whole process.
+    StringAtom::Stats atom_stats = StringAtom::GetStats();
+    SetTraceCounterMax("string_atoms.count", atom_stats.count);
+    SetTraceCounterMax("string_atoms.bytes", atom_stats.bytes);
+    SetTraceCounterMax("string_atoms.lock_contention",
+                       atom_stats.lock_contention);
+  }
   return !local_is_failed;
 }
 
@@ -61,13 +91,25 @@ void Scheduler::ScheduleWork(std::function<void()> work) {
   worker_pool_.PostTask([this, work = std::move(work)]() {
     work();
     DecrementWorkCount();
-    if (!pool_work_count_.Decrement()) {
-      std::unique_lock<std::mutex> auto_lock(pool_work_count_lock_);
-      pool_work_count_cv_.notify_one();
-    }
+    OnPoolTaskDone();
+  });
+}
+
+void Scheduler::PostPoolTask(std::function<void()> work) {
+  pool_work_count_.Increment();
+  worker_pool_.PostTask([this, work = std::move(work)]() {
+    work();
+    OnPoolTaskDone();
   });
 }
 
+void Scheduler::OnPoolTaskDone() {
+  if (!pool_work_count_.Decrement()) {
+    std::unique_lock<std::mutex> auto_lock(pool_work_count_lock_);
+    pool_work_count_cv_.notify_one();
+  }
+}
+
 void Scheduler::AddGenDependency(const base::FilePath& file) {
   std::lock_guard<std::mutex> lock(lock_);
   gen_dependencies_.push_back(file);
@@ -80,13 +122,13 @@ std::vector<base::FilePath> Scheduler::GetGenDependencies() const {
 
 void Scheduler::AddWrittenFile(const SourceFile& file) {
   std::lock_guard<std::mutex> lock(lock_);
-  written_files_.push_back(file);
+  written_files_.insert(file);
 }
 
 void Scheduler::AddUnknownGeneratedInput(const Target* target,
                                          const SourceFile& file) {
   std::lock_guard<std::mutex> lock(lock_);
-  unknown_generated_inputs_.insert(std::make_pair(file, target));
+  unknown_generated_inputs_.emplace_back(file, target);
 }
 
 void Scheduler::AddWriteRuntimeDepsTarget(const Target* target) {
@@ -113,12 +155,12 @@ bool Scheduler::IsFileGeneratedByWriteRuntimeDeps(
 
 void Scheduler::AddGeneratedFile(const SourceFile& entry) {
   std::lock_guard<std::mutex> lock(lock_);
-  generated_files_.insert(std::make_pair(entry, true));
+  generated_files_.insert(entry);
 }
 
 bool Scheduler::IsFileGeneratedByTarget(const SourceFile& file) const {
   std::lock_guard<std::mutex> lock(lock_);
-  return generated_files_.find(file) != generated_files_.end();
+  return generated_files_.count(file) != 0;
 }
 
 std::multimap<SourceFile, const Target*> Scheduler::GetUnknownGeneratedInputs()
@@ -130,10 +172,12 @@ std::multimap<SourceFile, const Target*> Scheduler::GetUnknownGeneratedInputs()
   //
   // It's assumed that this function is called once during cleanup to check for
   // errors, so performing this work in the lock doesn't matter.
-  std::multimap<SourceFile, const Target*> filtered = unknown_generated_inputs_;
-  for (const SourceFile& file : written_files_)
-    filtered.erase(file);
-
+  // The result is sorted by file so errors are reported deterministically.
+  std::multimap<SourceFile, const Target*> filtered;
+  for (const auto& [file, target] : unknown_generated_inputs_) {
+    if (written_files_.count(file) == 0)
+      filtered.emplace(file, target);
+  }
   return filtered;
 }
 
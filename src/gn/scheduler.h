@@ -8,7 +8,11 @@
 #include <condition_variable>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "base/atomic_ref_count.h"
 #include "base/files/file_path.h"
@@ -19,6 +23,7 @@
 #include "util/msg_loop.h"
 #include "util/worker_pool.h"
 
+class SharedImports;
 class Target;
 
 // Maintains the thread pool and error state.
@@ -36,6 +41,17 @@ class Scheduler {
 
   InputFileManager* input_file_manager() { return input_file_manager_.get(); }
 
+  // Replaces the input file manager, for example to reuse the files another
+  // scheduler has loaded. Must be called before any files are loaded.
+  void set_input_file_manager(scoped_refptr<InputFileManager> manager) {
+    input_file_manager_ = std::move(manager);
+  }
+
+  // Returns the results of imports shared by all the toolchains, or null if
+  // imports aren't shared (see the --share-imports switch).
+  SharedImports* shared_imports() { return shared_imports_.get(); }
+  void set_share_imports(bool share);
+
   bool verbose_logging() const { return verbose_logging_; }
   void set_verbose_logging(bool v) { verbose_logging_ = v; }
 
@@ -47,6 +63,14 @@ class Scheduler {
 
   void ScheduleWork(std::function<void()> work);
 
+  // Runs |work| on the worker pool without keeping Run() going, for work done
+  // once the build graph is complete. Use WaitForPoolTasks() to wait for it.
+  void PostPoolTask(std::function<void()> work);
+
+  // Waits for tasks scheduled via ScheduleWork() or PostPoolTask() to
+  // complete their execution.
+  void WaitForPoolTasks();
+
   void Shutdown();
 
   // Declares that the given file was read and affected the build output.
@@ -107,13 +131,15 @@ class Scheduler {
 
   void OnComplete();
 
-  // Waits for tasks scheduled via ScheduleWork() to complete their execution.
-  void WaitForPoolTasks();
+  // Called by every pool task once its work is done.
+  void OnPoolTaskDone();
 
   MsgLoop* main_thread_run_loop_;
 
   scoped_refptr<InputFileManager> input_file_manager_;
 
+  std::unique_ptr<SharedImports> shared_imports_;
+
   bool verbose_logging_ = false;
 
   base::AtomicRefCount work_count_;
@@ -142,10 +168,12 @@ class Scheduler {
 
   // Protected by the lock. See the corresponding Add/Get functions above.
   std::vector<base::FilePath> gen_dependencies_;
-  std::vector<SourceFile> written_files_;
+  // The source file sets hash by the interned path, so lookups are cheap even
+  // for the hundreds of thousands of generated files in a large build.
+  std::unordered_set<SourceFile> written_files_;
   std::vector<const Target*> write_runtime_deps_targets_;
-  std::multimap<SourceFile, const Target*> unknown_generated_inputs_;
-  std::map<SourceFile, bool> generated_files_;
+  std::vector<std::pair<SourceFile, const Target*>> unknown_generated_inputs_;
+  std::unordered_set<SourceFile> generated_files_;
 
   Scheduler(const Scheduler&) = delete;
   Scheduler& operator=(const Scheduler&) = delete;
@@ -25,8 +25,59 @@ bool IsPrivateVar(std::string_view name) {
   return name.empty() || name[0] == '_';
 }
 
+#if !defined(OS_ZOS)
+thread_local ToolchainDependence* current_dependence = nullptr;
+#else
+// TODO(gabylb) - zos: thread_local not yet supported, use zoslib's impl'n:
+__tlssim<ToolchainDependence*> __g_current_dependence_impl(nullptr);
+#define current_dependence (*__g_current_dependence_impl.access())
+#endif
+
 }  // namespace
 
+ToolchainDependence::ToolchainDependence(const Scope* import_scope)
+    : import_scope_(import_scope), previous_(current_dependence) {
+  current_dependence = this;
+}
+
+ToolchainDependence::~ToolchainDependence() {
+  current_dependence = previous_;
+}
+
+// static
+bool ToolchainDependence::IsTracking() {
+  return current_dependence && current_dependence->import_scope_;
+}
+
+// static
+void ToolchainDependence::Found() {
+  if (current_dependence)
+    current_dependence->found_ = true;
+}
+
+// static
+void ToolchainDependence::OnImport(bool toolchain_dependent,
+                                   const Variables& variables) {
+  if (!IsTracking())
+    return;
+  if (toolchain_dependent) {
+    current_dependence->found_ = true;
+    return;
+  }
+  current_dependence->variables_.insert(variables.begin(), variables.end());
+}
+
+// static
+void ToolchainDependence::OnLookupPast(const Scope* scope,
+                                       std::string_view ident,
+                                       const Value* value) {
+  if (!current_dependence || current_dependence->import_scope_ != scope)
+    return;
+  Variables& variables = current_dependence->variables_;
+  if (variables.find(ident) == variables.end())
+    variables.emplace(std::string(ident), value ? *value : Value());
+}
+
 // Defaults to all false, which are the things least likely to cause errors.
 Scope::MergeOptions::MergeOptions()
     : clobber_existing(false),
@@ -88,28 +139,40 @@ const Value* Scope::GetValue(std::string_view ident, bool counts_as_used) {
 const Value* Scope::GetValueWithScope(std::string_view ident,
                                       bool counts_as_used,
                                       const Scope** found_in_scope) {
+  return GetValueWithScope(ident, RecordMap::Hash(ident), counts_as_used,
+                           found_in_scope);
+}
+
+const Value* Scope::GetValueWithScope(std::string_view ident,
+                                      size_t hash,
+                                      bool counts_as_used,
+                                      const Scope** found_in_scope) {
   // First check for programmatically-provided values.
   for (auto* provider : programmatic_providers_) {
     const Value* v = provider->GetProgrammaticValue(ident);
     if (v) {
+      ToolchainDependence::Found();
       *found_in_scope = nullptr;
       return v;
     }
   }
 
-  RecordMap::iterator found = values_.find(ident);
-  if (found != values_.end()) {
+  if (ScopeRecord* record = values_.Find(ident, hash)) {
     if (counts_as_used)
-      found->second.used = true;
+      record->used = true;
     *found_in_scope = this;
-    return &found->second.value;
+    return &record->value;
   }
 
   // Search in the parent scope.
-  if (const_containing_)
-    return const_containing_->GetValueWithScope(ident, found_in_scope);
+  if (const_containing_) {
+    const Value* value =
+        const_containing_->GetValueWithScope(ident, hash, found_in_scope);
+    ToolchainDependence::OnLookupPast(this, ident, value);
+    return value;
+  }
   if (mutable_containing_) {
-    return mutable_containing_->GetValueWithScope(ident, counts_as_used,
+    return mutable_containing_->GetValueWithScope(ident, hash, counts_as_used,
                                                   found_in_scope);
   }
   return nullptr;
@@ -118,26 +181,32 @@ const Value* Scope::GetValueWithScope(std::string_view ident,
 Value* Scope::GetMutableValue(std::string_view ident,
                               SearchNested search_mode,
                               bool counts_as_used) {
+  return GetMutableValue(ident, RecordMap::Hash(ident), search_mode,
+                         counts_as_used);
+}
+
+Value* Scope::GetMutableValue(std::string_view ident,
+                              size_t hash,
+                              SearchNested search_mode,
+                              bool counts_as_used) {
   // Don't do programmatic values, which are not mutable.
-  RecordMap::iterator found = values_.find(ident);
-  if (found != values_.end()) {
+  if (ScopeRecord* record = values_.Find(ident, hash)) {
     if (counts_as_used)
-      found->second.used = true;
-    return &found->second.value;
+      record->used = true;
+    return &record->value;
   }
 
   // Search in the parent mutable scope if requested, but not const one.
   if (search_mode == SEARCH_NESTED && mutable_containing_) {
-    return mutable_containing_->GetMutableValue(ident, Scope::SEARCH_NESTED,
-                                                counts_as_used);
+    return mutable_containing_->GetMutableValue(
+        ident, hash, Scope::SEARCH_NESTED, counts_as_used);
   }
   return nullptr;
 }
 
 std::string_view Scope::GetStorageKey(std::string_view ident) const {
-  RecordMap::const_iterator found = values_.find(ident);
-  if (found != values_.end())
-    return found->first;
+  if (const ScopeRecord* record = values_.Find(ident))
+    return record->name;
 
   // Search in parent scope.
   if (containing())
@@ -152,44 +221,48 @@ const Value* Scope::GetValue(std::string_view ident) const {
 
 const Value* Scope::GetValueWithScope(std::string_view ident,
                                       const Scope** found_in_scope) const {
-  RecordMap::const_iterator found = values_.find(ident);
-  if (found != values_.end()) {
+  return GetValueWithScope(ident, RecordMap::Hash(ident), found_in_scope);
+}
+
+const Value* Scope::GetValueWithScope(std::string_view ident,
+                                      size_t hash,
+                                      const Scope** found_in_scope) const {
+  if (const ScopeRecord* record = values_.Find(ident, hash)) {
     *found_in_scope = this;
-    return &found->second.value;
+    return &record->value;
+  }
+  if (containing()) {
+    const Value* value =
+        containing()->GetValueWithScope(ident, hash, found_in_scope);
+    ToolchainDependence::OnLookupPast(this, ident, value);
+    return value;
   }
-  if (containing())
-    return containing()->GetValueWithScope(ident, found_in_scope);
   return nullptr;
 }
 
 Value* Scope::SetValue(std::string_view ident,
                        Value v,
                        const ParseNode* set_node) {
-  Record& r = values_[ident];  // Clears any existing value.
-  r.value = std::move(v);
-  r.value.set_origin(set_node);
-  return &r.value;
+  ScopeRecord* record = values_.FindOrAdd(ident);
+  record->value = std::move(v);  // Clears any existing value.
+  record->value.set_origin(set_node);
+  return &record->value;
 }
 
 void Scope::RemoveIdentifier(std::string_view ident) {
-  RecordMap::iterator found = values_.find(ident);
-  if (found != values_.end())
-    values_.erase(found);
+  values_.Remove(ident);
 }
 
 void Scope::RemovePrivateIdentifiers() {
-  // Do it in two phases to avoid mutating while iterating. Our hash map is
-  // currently backed by several different vendor-specific implementations and
-  // I'm not sure if all of them support mutating while iterating. Since this
-  // is not perf-critical, do the safe thing.
+  // Do it in two phases to avoid mutating while iterating.
   std::vector<std::string_view> to_remove;
-  for (const auto& cur : values_) {
-    if (IsPrivateVar(cur.first))
-      to_remove.push_back(cur.first);
+  for (const ScopeRecord& cur : values_) {
+    if (IsPrivateVar(cur.name))
+      to_remove.push_back(cur.name);
   }
 
   for (const auto& cur : to_remove)
-    values_.erase(cur);
+    values_.Remove(cur);
 }
 
 bool Scope::AddTemplate(const std::string& name, const Template* templ) {
@@ -232,53 +305,48 @@ SourceFileSet Scope::CollectBuildDependencyFiles() const {
 }
 
 void Scope::MarkUsed(std::string_view ident) {
-  RecordMap::iterator found = values_.find(ident);
-  if (found == values_.end()) {
+  ScopeRecord* record = values_.Find(ident);
+  if (!record) {
     NOTREACHED();
     return;
   }
-  found->second.used = true;
+  record->used = true;
 }
 
 void Scope::MarkAllUsed() {
-  for (auto& cur : values_)
-    cur.second.used = true;
+  for (ScopeRecord& cur : values_)
+    cur.used = true;
 }
 
 void Scope::MarkAllUsed(const std::set<std::string>& excluded_values) {
-  for (auto& cur : values_) {
+  for (ScopeRecord& cur : values_) {
     if (!excluded_values.empty() &&
-        excluded_values.find(std::string(cur.first)) != excluded_values.end()) {
+        excluded_values.find(std::string(cur.name)) != excluded_values.end()) {
       continue;  // Skip this excluded value.
     }
-    cur.second.used = true;
+    cur.used = true;
   }
 }
 
 void Scope::MarkUnused(std::string_view ident) {
-  RecordMap::iterator found = values_.find(ident);
-  if (found == values_.end()) {
+  ScopeRecord* record = values_.Find(ident);
+  if (!record) {
     NOTREACHED();
     return;
   }
-  found->second.used = false;
+  record->used = false;
 }
 
 bool Scope::IsSetButUnused(std::string_view ident) const {
-  RecordMap::const_iterator found = values_.find(ident);
-  if (found != values_.end()) {
-    if (!found->second.used) {
-      return true;
-    }
-  }
-  return false;
+  const ScopeRecord* record = values_.Find(ident);
+  return record && !record->used;
 }
 
 bool Scope::CheckForUnusedVars(Err* err) const {
-  for (const auto& pair : values_) {
-    if (!pair.second.used) {
+  for (const ScopeRecord& record : values_) {
+    if (!record.used) {
       std::string help =
-          "You set the variable \"" + std::string(pair.first) +
+          "You set the variable \"" + std::string(record.name) +
           "\" here and it was unused before it went\nout of scope.";
 
       // Gather the template invocations that led up to this scope.
@@ -290,15 +358,14 @@ bool Scope::CheckForUnusedVars(Err* err) const {
         }
       }
 
-      const BinaryOpNode* binary = pair.second.value.origin()->AsBinaryOp();
+      const BinaryOpNode* binary = record.value.origin()->AsBinaryOp();
       if (binary && binary->op().type() == Token::EQUAL) {
         // Make a nicer error message for normal var sets.
         *err =
             Err(binary->left()->GetRange(), "Assignment had no effect.", help);
       } else {
         // This will happen for internally-generated variables.
-        *err =
-            Err(pair.second.value.origin(), "Assignment had no effect.", help);
+        *err = Err(record.value.origin(), "Assignment had no effect.", help);
       }
       return false;
     }
@@ -307,8 +374,8 @@ bool Scope::CheckForUnusedVars(Err* err) const {
 }
 
 void Scope::GetCurrentScopeValues(KeyValueMap* output) const {
-  for (const auto& pair : values_)
-    (*output)[pair.first] = pair.second.value;
+  for (const ScopeRecord& record : values_)
+    (*output)[record.name] = record.value;
 }
 
 bool Scope::CheckCurrentScopeValuesEqual(const Scope* other) const {
@@ -319,9 +386,9 @@ bool Scope::CheckCurrentScopeValuesEqual(const Scope* other) const {
   if (values_.size() != other->values_.size()) {
     return false;
   }
-  for (const auto& pair : values_) {
-    const Value* v = other->GetValue(pair.first);
-    if (!v || *v != pair.second.value) {
+  for (const ScopeRecord& record : values_) {
+    const Value* v = other->GetValue(record.name);
+    if (!v || *v != record.value) {
       return false;
     }
   }
@@ -334,8 +401,8 @@ bool Scope::NonRecursiveMergeTo(Scope* dest,
                                 const char* desc_for_err,
                                 Err* err) const {
   // Values.
-  for (const auto& pair : values_) {
-    const std::string_view current_name = pair.first;
+  for (const ScopeRecord& record : values_) {
+    const std::string_view current_name = record.name;
     if (options.skip_private_vars && IsPrivateVar(current_name))
       continue;  // Skip this private var.
     if (!options.excluded_values.empty() &&
@@ -344,7 +411,7 @@ bool Scope::NonRecursiveMergeTo(Scope* dest,
       continue;  // Skip this excluded value.
     }
 
-    const Value& new_value = pair.second.value;
+    const Value& new_value = record.value;
     if (!options.clobber_existing) {
       const Value* existing_value = dest->GetValue(current_name);
       if (existing_value && new_value != *existing_value) {
@@ -354,7 +421,7 @@ bool Scope::NonRecursiveMergeTo(Scope* dest,
                    "This " + desc_string + " contains \"" +
                        std::string(current_name) + "\"");
         err->AppendSubErr(
-            Err(pair.second.value, "defined here.",
+            Err(record.value, "defined here.",
                 "Which would clobber the one in your current scope"));
         err->AppendSubErr(
             Err(*existing_value, "defined here.",
@@ -364,7 +431,9 @@ bool Scope::NonRecursiveMergeTo(Scope* dest,
         return false;
       }
     }
-    dest->values_[current_name] = pair.second;
+    ScopeRecord* dest_record = dest->values_.FindOrAdd(current_name);
+    dest_record->used = record.used;
+    dest_record->value = record.value;
 
     if (options.mark_dest_used)
       dest->MarkUsed(current_name);
@@ -460,6 +529,24 @@ bool Scope::NonRecursiveMergeTo(Scope* dest,
   return true;
 }
 
+void Scope::CopyToNewContaining(Scope* dest) const {
+  TemplateCopies copies;
+  CopyToNewContaining(dest, &copies);
+}
+
+void Scope::CopyToNewContaining(Scope* dest, TemplateCopies* copies) const {
+  MergeOptions options;
+  options.clobber_existing = true;
+  Err err;
+  NonRecursiveMergeTo(dest, options, nullptr, "<SHOULDN'T HAPPEN>", &err);
+  DCHECK(!err.has_error());
+
+  for (auto& pair : dest->templates_) {
+    pair.second = pair.second->CopyToNewContaining(
+        const_containing_, dest->const_containing_, copies);
+  }
+}
+
 std::unique_ptr<Scope> Scope::MakeClosure() const {
   std::unique_ptr<Scope> result;
   if (const_containing_) {
@@ -634,11 +721,11 @@ Scope::GetTemplateInvocationEntries() const {
 bool Scope::RecordMapValuesEqual(const RecordMap& a, const RecordMap& b) {
   if (a.size() != b.size())
     return false;
-  for (const auto& pair : a) {
-    const auto& found_b = b.find(pair.first);
-    if (found_b == b.end())
+  for (const ScopeRecord& record : a) {
+    const ScopeRecord* found_b = b.Find(record.name, record.hash);
+    if (!found_b)
       return false;  // Item in 'a' but not 'b'.
-    if (pair.second.value != found_b->second.value)
+    if (record.value != found_b->value)
       return false;  // Values for variable in 'a' and 'b' are different.
   }
   return true;
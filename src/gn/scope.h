@@ -18,6 +18,7 @@
 #include "gn/err.h"
 #include "gn/location.h"
 #include "gn/pattern.h"
+#include "gn/scope_record_map.h"
 #include "gn/source_dir.h"
 #include "gn/source_file.h"
 #include "gn/value.h"
@@ -27,6 +28,57 @@ class ParseNode;
 class Settings;
 class Template;
 
+// Tracks what the execution of an import on the current thread depends on,
+// so that its result can be shared with the toolchains for which it would be
+// the same (see ImportManager).
+//
+// The variables it reads from outside of its scope, such as the ones set by
+// the build config, are recorded with their values. Other dependencies on the
+// toolchain, such as built-in variables like "current_toolchain", and most
+// built-in functions and templates, prevent sharing the result at all.
+class ToolchainDependence {
+ public:
+  // The variables read from outside of the import, by name, with their value
+  // or a value of type NONE if they weren't defined.
+  using Variables = std::map<std::string, Value, std::less<>>;
+
+  // Tracks the execution of the import with the given scope until destroyed.
+  // Null stops tracking, for the execution of an import whose result isn't
+  // shared.
+  explicit ToolchainDependence(const Scope* import_scope);
+  ~ToolchainDependence();
+
+  // Whether the result of the import can't be shared.
+  bool found() const { return found_; }
+
+  const Variables& variables() const { return variables_; }
+  Variables TakeVariables() { return std::move(variables_); }
+
+  static bool IsTracking();
+
+  // Notes that the import being tracked depends on the toolchain.
+  static void Found();
+
+  // Notes that the import being tracked imports a file whose result depends
+  // on the given variables, or on the toolchain if |toolchain_dependent|.
+  static void OnImport(bool toolchain_dependent, const Variables& variables);
+
+  // Notes a lookup of |ident| continuing past |scope| to its containing scope
+  // and finding |value|, which may be null.
+  static void OnLookupPast(const Scope* scope,
+                           std::string_view ident,
+                           const Value* value);
+
+ private:
+  const Scope* import_scope_;
+  bool found_ = false;
+  Variables variables_;
+  ToolchainDependence* previous_;
+
+  ToolchainDependence(const ToolchainDependence&) = delete;
+  ToolchainDependence& operator=(const ToolchainDependence&) = delete;
+};
+
 // Scope for the script execution.
 //
 // Scopes are nested. Writing goes into the toplevel scope, reading checks
@@ -255,6 +307,20 @@ class Scope {
                            const char* desc_for_err,
                            Err* err) const;
 
+  // Copies this scope's values into |dest|, a new scope whose containing
+  // scope replaces const_containing(), as when sharing the result of an
+  // import with another toolchain (see ImportManager). Templates whose
+  // closures are based on const_containing() are recreated with closures
+  // based on the containing scope of |dest|, recursively, so that they don't
+  // see the variables of the original toolchain.
+  void CopyToNewContaining(Scope* dest) const;
+
+  // The templates copied by CopyToNewContaining(), by original template, so
+  // that templates found in several closures are copied once.
+  using TemplateCopies =
+      std::map<const Template*, scoped_refptr<const Template>>;
+  void CopyToNewContaining(Scope* dest, TemplateCopies* copies) const;
+
   // Constructs a scope that is a copy of the current one. Nested scopes will
   // be collapsed until we reach a const containing scope. Private values will
   // be included. The resulting closure will reference the const containing
@@ -348,15 +414,21 @@ class Scope {
  private:
   friend class ProgrammaticProvider;
 
-  struct Record {
-    Record() : used(false) {}
-    explicit Record(const Value& v) : used(false), value(v) {}
+  using RecordMap = ScopeRecordMap;
 
-    bool used;  // Set to true when the variable is used.
-    Value value;
-  };
-
-  using RecordMap = std::unordered_map<std::string_view, Record>;
+  // Versions of the lookups above taking the hash of |ident|, computed once
+  // for the whole chain of containing scopes.
+  const Value* GetValueWithScope(std::string_view ident,
+                                 size_t hash,
+                                 bool counts_as_used,
+                                 const Scope** found_in_scope);
+  const Value* GetValueWithScope(std::string_view ident,
+                                 size_t hash,
+                                 const Scope** found_in_scope) const;
+  Value* GetMutableValue(std::string_view ident,
+                         size_t hash,
+                         SearchNested search_mode,
+                         bool counts_as_used);
 
   void AddProvider(ProgrammaticProvider* p);
   void RemoveProvider(ProgrammaticProvider* p);
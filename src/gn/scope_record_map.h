@@ -0,0 +1,157 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_SCOPE_RECORD_MAP_H_
+#define TOOLS_GN_SCOPE_RECORD_MAP_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "gn/hash_table_base.h"
+#include "gn/value.h"
+
+// A variable stored in a Scope.
+struct ScopeRecord {
+  ScopeRecord() = default;
+  ScopeRecord(std::string_view n, size_t h) : name(n), hash(h) {}
+
+  std::string_view name;
+  size_t hash = 0;
+  bool used = false;  // Set to true when the variable is used.
+  Value value;
+};
+
+struct ScopeRecordNode {
+  ScopeRecord* record;
+
+  bool is_null() const { return !record; }
+  bool is_tombstone() const { return record == MakeTombstone(); }
+  bool is_valid() const { return !is_null() && !is_tombstone(); }
+  size_t hash_value() const { return record->hash; }
+
+  // The special address 1 marks removed records, as in PointerSetNode.
+  static ScopeRecord* MakeTombstone() {
+    return reinterpret_cast<ScopeRecord*>(1u);
+  }
+};
+
+// The variables of a Scope, in an open-addressing hash table keyed by name.
+//
+// Records are allocated individually so that pointers to values stay valid
+// while variables are added. Each record keeps the hash of its name, which
+// avoids string comparisons when probing and rehashing, and lets lookups that
+// walk a chain of scopes hash the name only once (see Hash()).
+//
+// Removal leaves a tombstone that a later insertion can reuse. Since the base
+// class only counts valid nodes when deciding to grow, the table is rebuilt
+// once tombstones would leave too few null buckets for probing to stop, which
+// keeps removal amortized constant time.
+class ScopeRecordMap : public HashTableBase<ScopeRecordNode> {
+ public:
+  using BaseType = HashTableBase<ScopeRecordNode>;
+  using Node = BaseType::Node;
+
+  ScopeRecordMap() = default;
+  ~ScopeRecordMap() {
+    for (Node& node : ValidNodesRange())
+      delete node.record;
+  }
+
+  static size_t Hash(std::string_view name) {
+    return std::hash<std::string_view>()(name);
+  }
+
+  // Returns the record for |name|, whose hash is |hash|, or null.
+  ScopeRecord* Find(std::string_view name, size_t hash) const {
+    Node* node = Lookup(name, hash);
+    return node->is_valid() ? node->record : nullptr;
+  }
+  ScopeRecord* Find(std::string_view name) const {
+    return Find(name, Hash(name));
+  }
+
+  // Returns the record for |name|, adding an empty one if there is none.
+  ScopeRecord* FindOrAdd(std::string_view name) {
+    size_t hash = Hash(name);
+    Node* node = Lookup(name, hash);
+    if (node->is_valid())
+      return node->record;
+    bool reused_tombstone = node->is_tombstone();
+    ScopeRecord* record = new ScopeRecord(name, hash);
+    node->record = record;
+    if (UpdateAfterInsert()) {
+      // Growing only copies valid nodes.
+      tombstone_count_ = 0;
+    } else if (reused_tombstone) {
+      tombstone_count_--;
+    } else {
+      PurgeTombstonesIfNeeded();
+    }
+    return record;
+  }
+
+  // Removes the record for |name|, if any.
+  void Remove(std::string_view name) {
+    Node* node = Lookup(name, Hash(name));
+    if (!node->is_valid())
+      return;
+    delete node->record;
+    node->record = ScopeRecordNode::MakeTombstone();
+    UpdateAfterRemoval();
+    tombstone_count_++;
+  }
+
+  // Iteration over the records, in no particular order.
+  struct iterator : public NodeIterator {
+    ScopeRecord& operator*() { return *node_->record; }
+    ScopeRecord* operator->() { return node_->record; }
+  };
+
+  struct const_iterator : public NodeIterator {
+    const ScopeRecord& operator*() const { return *node_->record; }
+    const ScopeRecord* operator->() const { return node_->record; }
+  };
+
+  iterator begin() { return {NodeBegin()}; }
+  iterator end() { return {NodeEnd()}; }
+  const_iterator begin() const { return {NodeBegin()}; }
+  const_iterator end() const { return {NodeEnd()}; }
+
+ private:
+  Node* Lookup(std::string_view name, size_t hash) const {
+    return NodeLookup(hash, [name, hash](const Node* node) {
+      return node->record->hash == hash && node->record->name == name;
+    });
+  }
+
+  // Rebuilds the table without tombstones when fewer than one bucket in
+  // eight is null.
+  void PurgeTombstonesIfNeeded() {
+    size_t bucket_count = NodeBucketCount();
+    if ((size() + tombstone_count_) * 8 < bucket_count * 7)
+      return;
+
+    std::vector<ScopeRecord*> records;
+    records.reserve(size());
+    for (Node& node : ValidNodesRange())
+      records.push_back(node.record);
+
+    NodeClear();
+    tombstone_count_ = 0;
+    for (ScopeRecord* record : records) {
+      Lookup(record->name, record->hash)->record = record;
+      UpdateAfterInsert();
+    }
+  }
+
+  size_t tombstone_count_ = 0;
+
+  ScopeRecordMap(const ScopeRecordMap&) = delete;
+  ScopeRecordMap& operator=(const ScopeRecordMap&) = delete;
+};
+
+#endif  // TOOLS_GN_SCOPE_RECORD_MAP_H_
@@ -0,0 +1,90 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/scope_record_map.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "util/test/test.h"
+
+TEST(ScopeRecordMap, FindOrAdd) {
+  ScopeRecordMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.Find("a"));
+
+  ScopeRecord* a = map.FindOrAdd("a");
+  ASSERT_TRUE(a);
+  EXPECT_EQ("a", a->name);
+  EXPECT_FALSE(a->used);
+  EXPECT_EQ(Value::NONE, a->value.type());
+  a->value = Value(nullptr, "hello");
+
+  EXPECT_EQ(a, map.FindOrAdd("a"));
+  EXPECT_EQ(a, map.Find("a"));
+  EXPECT_EQ(a, map.Find("a", ScopeRecordMap::Hash("a")));
+  EXPECT_EQ(1u, map.size());
+
+  // Records don't move when the table grows.
+  std::vector<std::string> names;
+  for (int i = 0; i < 100; i++)
+    names.push_back("var" + std::to_string(i));
+  for (const std::string& name : names)
+    map.FindOrAdd(name)->value = Value(nullptr, name);
+  EXPECT_EQ(101u, map.size());
+  EXPECT_EQ(a, map.Find("a"));
+  EXPECT_EQ("hello", a->value.string_value());
+  for (const std::string& name : names)
+    EXPECT_EQ(name, map.Find(name)->value.string_value());
+
+  std::set<std::string> iterated;
+  for (const ScopeRecord& record : map)
+    iterated.insert(std::string(record.name));
+  EXPECT_EQ(101u, iterated.size());
+}
+
+TEST(ScopeRecordMap, Remove) {
+  ScopeRecordMap map;
+  map.Remove("a");
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 20; i++)
+    names.push_back("var" + std::to_string(i));
+  for (const std::string& name : names)
+    map.FindOrAdd(name);
+  ScopeRecord* kept = map.Find("var19");
+
+  for (int i = 0; i < 10; i++)
+    map.Remove(names[i]);
+  EXPECT_EQ(10u, map.size());
+  for (int i = 0; i < 10; i++)
+    EXPECT_FALSE(map.Find(names[i])) << names[i];
+  for (int i = 10; i < 20; i++)
+    EXPECT_TRUE(map.Find(names[i])) << names[i];
+  EXPECT_EQ(kept, map.Find("var19"));
+
+  // Iteration skips removed records.
+  size_t iterated = 0;
+  for (const ScopeRecord& record : map) {
+    EXPECT_TRUE(map.Find(record.name)) << record.name;
+    iterated++;
+  }
+  EXPECT_EQ(10u, iterated);
+
+  // A removed name can be added again.
+  ScopeRecord* readded = map.FindOrAdd(names[0]);
+  EXPECT_EQ(readded, map.Find(names[0]));
+  EXPECT_EQ(11u, map.size());
+  map.Remove(names[0]);
+
+  // Adding and removing many names doesn't fill the table.
+  for (int i = 0; i < 1000; i++) {
+    std::string name = "loop" + std::to_string(i);
+    map.FindOrAdd(name);
+    map.Remove(name);
+  }
+  EXPECT_EQ(10u, map.size());
+  EXPECT_FALSE(map.Find("loop0"));
+}
@@ -24,6 +24,7 @@
 #include "gn/filesystem_utils.h"
 #include "gn/input_file.h"
 #include "gn/label_pattern.h"
+#include "gn/parse_cache.h"
 #include "gn/parse_tree.h"
 #include "gn/parser.h"
 #include "gn/source_dir.h"
@@ -444,6 +445,8 @@ bool Setup::DoSetupWithErr(const std::string& build_dir,
                            const base::CommandLine& cmdline,
                            Err* err) {
   scheduler_.set_verbose_logging(cmdline.HasSwitch(switches::kVerbose));
+  builder_.set_concurrent_resolution(
+      cmdline.HasSwitch(switches::kConcurrentResolve));
   if (cmdline.HasSwitch(switches::kTime) ||
       cmdline.HasSwitch(switches::kTracelog))
     EnableTracing();
@@ -461,6 +464,11 @@ bool Setup::DoSetupWithErr(const std::string& build_dir,
   if (!FillBuildDir(build_dir, !force_create, err))
     return false;
 
+  if (cmdline.HasSwitch(switches::kParseCache))
+    EnableParseCache();
+  if (cmdline.HasSwitch(switches::kShareImports))
+    scheduler_.set_share_imports(true);
+
   // Apply project-specific default (if specified).
   // Must happen before FillArguments().
   if (default_args_) {
@@ -503,8 +511,19 @@ void Setup::RunPreMessageLoop() {
   // Will be decremented with the loader is drained.
   g_scheduler->IncrementWorkCount();
 
-  // Load the root build file.
-  loader_->Load(root_build_file_, LocationRange(), Label());
+  if (build_files_to_load_.empty()) {
+    // Load the root build file.
+    loader_->Load(root_build_file_, LocationRange(), Label());
+    return;
+  }
+
+  // The first load must not name a toolchain so that it triggers loading the
+  // default build config. The loader holds the others until that's done.
+  loader_->Load(build_files_to_load_[0].first, LocationRange(), Label());
+  for (size_t i = 1; i < build_files_to_load_.size(); i++) {
+    loader_->Load(build_files_to_load_[i].first, LocationRange(),
+                  build_files_to_load_[i].second);
+  }
 }
 
 bool Setup::RunPostMessageLoop(const base::CommandLine& cmdline) {
@@ -514,7 +533,10 @@ bool Setup::RunPostMessageLoop(const base::CommandLine& cmdline) {
     return false;
   }
 
-  if (!build_settings_.build_args().VerifyAllOverridesUsed(&err)) {
+  // When only part of the build is loaded, arguments may be declared in files
+  // that weren't run, so unused overrides can't be detected.
+  if (build_files_to_load_.empty() &&
+      !build_settings_.build_args().VerifyAllOverridesUsed(&err)) {
     if (cmdline.HasSwitch(switches::kFailOnUnusedArgs)) {
       err.PrintToStdout();
       return false;
@@ -653,7 +675,7 @@ bool Setup::SaveArgsToFile() {
       build_settings_.GetFullPath(GetBuildArgFile());
   base::CreateDirectory(build_arg_file.DirName());
 
-  std::string contents = args_input_file_->contents();
+  std::string contents(args_input_file_->contents());
   commands::FormatStringToString(contents, commands::TreeDumpMode::kInactive,
                                  &contents, nullptr);
 #if defined(OS_WIN)
@@ -788,6 +810,16 @@ bool Setup::FillBuildDir(const std::string& build_dir,
   return true;
 }
 
+void Setup::EnableParseCache() {
+  base::FilePath cache_dir =
+      build_settings_.GetFullPath(build_settings_.build_dir())
+          .Append(FILE_PATH_LITERAL("gn_parse_cache"));
+  if (!base::CreateDirectory(cache_dir))
+    return;
+  scheduler_.input_file_manager()->set_parse_cache(
+      std::make_unique<ParseCache>(cache_dir));
+}
+
 // On Chromium repositories on Windows the Python executable can be specified as
 // python, python.bat, or python.exe (ditto for python3, and with or without a
 // full path specification). This handles all of these cases and returns a fully
@@ -6,6 +6,8 @@
 #define TOOLS_GN_SETUP_H_
 
 #include <memory>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "base/files/file_path.h"
@@ -85,6 +87,16 @@ class Setup {
   // want to rely on them being valid.
   void set_fill_arguments(bool fa) { fill_arguments_ = fa; }
 
+  // Before Run, replaces the initial load of the root build file with loads
+  // of the given build files, each in the given toolchain. The first file
+  // must belong to the default toolchain. Everything else is loaded on demand
+  // as usual. Used by incremental generation, which only needs the parts of
+  // the build that may have changed.
+  void set_build_files_to_load(
+      std::vector<std::pair<SourceFile, Label>> build_files) {
+    build_files_to_load_ = std::move(build_files);
+  }
+
   // After a successful run, setting this will additionally cause the public
   // headers to be checked. Defaults to false.
   void set_check_public_headers(bool s) { check_public_headers_ = s; }
@@ -125,6 +137,10 @@ class Setup {
   LoaderImpl* loader() { return loader_.get(); }
 
   const SourceFile& GetDotFile() const { return dotfile_input_file_->name(); }
+  const base::FilePath& dotfile_name() const { return dotfile_name_; }
+  std::string_view GetDotFileContents() const {
+    return dotfile_input_file_->contents();
+  }
 
   // Name of the file in the root build directory that contains the build
   // arguments.
@@ -161,6 +177,11 @@ class Setup {
                     bool require_exists,
                     Err* err);
 
+  // Makes the input file manager use the parse cache in the build directory.
+  // Must happen after FillBuildDir. If the cache directory can't be created,
+  // files are just parsed normally.
+  void EnableParseCache();
+
   // Fills the python path portion of the command line. On failure, sets
   // it to just "python".
   bool FillPythonPath(const base::CommandLine& cmdline, Err* err);
@@ -176,6 +197,9 @@ class Setup {
 
   SourceFile root_build_file_;
 
+  // See set_build_files_to_load().
+  std::vector<std::pair<SourceFile, Label>> build_files_to_load_;
+
   bool check_public_headers_ = false;
   bool check_system_includes_ = false;
 
@@ -97,6 +97,16 @@ void OutputMarkdownDec(TextDecoration dec) {
 
 }  // namespace
 
+bool IsOutputDecorated() {
+  EnsureInitialized();
+  return is_console;
+}
+
+void SetOutputDecorated(bool decorated) {
+  EnsureInitialized();
+  is_console = decorated;
+}
+
 #if defined(OS_WIN)
 
 void OutputString(const std::string& output,
@@ -29,6 +29,13 @@ void OutputString(const std::string& output,
                   TextDecoration dec = DECORATION_NONE,
                   HtmlEscaping = DEFAULT_ESCAPING);
 
+// Returns whether OutputString() decorates the output with colors, which
+// depends on the command line and whether the standard output is a console.
+bool IsOutputDecorated();
+
+// Overrides the above, for output that is shown by another process.
+void SetOutputDecorated(bool decorated);
+
 // If printing markdown, this generates table-of-contents entries with
 // links to the actual help; otherwise, prints a one-line description.
 void PrintSectionHelp(const std::string& line,
@@ -5,6 +5,7 @@
 #include "gn/string_atom.h"
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -32,9 +33,13 @@ namespace {
 //      a new std::string is allocated and its address inserted into the tree
 //      before being returned.
 //
-// Because the mutex is a large bottleneck, each thread implements
-// its own local string pointer cache, and will only call StringAtomSet::find()
-// in case of a lookup miss. This is critical for good performance.
+// All of these are split into shards selected by the string hash, each with
+// its own mutex, which is only needed to add new strings.
+//
+// Because even lock-free lookups in shared memory are slow, each thread
+// implements its own local string pointer cache, and will only call
+// StringAtomSet::find() in case of a lookup miss. This is critical for good
+// performance.
 //
 
 static const std::string kEmptyString;
@@ -105,40 +110,135 @@ struct KeySet : public HashTableBase<KeyNode> {
   }
 };
 
-class StringAtomSet {
+// A shard of the global set. Each shard holds the strings whose hash has the
+// shard's index in its top bits.
+//
+// Strings already in the shard are found without taking a lock: the table is
+// an open-addressing array of atomic slots that is only modified under the
+// lock, by filling empty slots or by publishing a larger copy. Tables that
+// were replaced are kept alive since other threads may still be reading
+// them, which costs at most as much memory again as the current table.
+class StringAtomShard {
  public:
-  StringAtomSet() {
-    // Ensure kEmptyString is in our set while not being allocated
-    // from a slab. The end result is that find("") should always
-    // return this address.
-    //
-    // This allows the StringAtom() default initializer to use the same
-    // address directly, avoiding a table lookup.
-    //
-    size_t hash = set_.Hash("");
-    auto* node = set_.Lookup(hash, "");
-    set_.Insert(node, hash, &kEmptyString);
-  }
+  StringAtomShard() { Grow(); }
 
-  // Find the unique constant string pointer for |key|.
-  const std::string* find(std::string_view key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    size_t hash = set_.Hash(key);
-    auto* node = set_.Lookup(hash, key);
-    if (node->key)
-      return node->key;
+  // Find the unique constant string pointer for |key|, whose hash is |hash|.
+  const std::string* find(size_t hash, std::string_view key) {
+    Slot* slot = nullptr;
+    const std::string* result =
+        Probe(table_.load(std::memory_order_acquire), hash, key, &slot);
+    if (result)
+      return result;
+
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      lock.lock();
+      lock_contention_++;
+    }
+    // Look again, another thread may have added the string or grown the table
+    // in the meantime.
+    result = Probe(table_.load(std::memory_order_relaxed), hash, key, &slot);
+    if (result)
+      return result;
 
     // Allocate new string, insert its address in the set.
     if (slab_index_ >= kStringsPerSlab) {
       slabs_.push_back(new Slab());
       slab_index_ = 0;
     }
-    std::string* result = slabs_.back()->init(slab_index_++, key);
-    set_.Insert(node, hash, result);
-    return result;
+    std::string* str = slabs_.back()->init(slab_index_++, key);
+    Insert(slot, hash, str);
+    count_++;
+    bytes_ += key.size();
+    return str;
+  }
+
+  // Inserts |str| without allocating it.
+  void InsertStatic(size_t hash, const std::string* str) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot* slot = nullptr;
+    if (!Probe(table_.load(std::memory_order_relaxed), hash, *str, &slot))
+      Insert(slot, hash, str);
+  }
+
+  void AddStats(StringAtom::Stats* stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats->count += count_;
+    stats->bytes += bytes_;
+    stats->lock_contention += lock_contention_;
   }
 
  private:
+  // A slot is empty until |key| is set, which is done after setting |hash|.
+  struct Slot {
+    std::atomic<size_t> hash;
+    std::atomic<const std::string*> key;
+  };
+
+  struct Table {
+    explicit Table(size_t size) : mask(size - 1), slots(new Slot[size]()) {}
+
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  // Returns the string of |key| in |table|. If there is none, returns null
+  // and sets |*empty_slot| to the slot where it should be inserted.
+  //
+  // Callers must not read the key of that slot again: without the lock,
+  // another thread may have filled it with a different string since.
+  static const std::string* Probe(Table* table,
+                                  size_t hash,
+                                  std::string_view key,
+                                  Slot** empty_slot) {
+    for (size_t index = hash;; index++) {
+      Slot* slot = &table->slots[index & table->mask];
+      const std::string* slot_key = slot->key.load(std::memory_order_acquire);
+      if (!slot_key) {
+        *empty_slot = slot;
+        return nullptr;
+      }
+      if (slot->hash.load(std::memory_order_relaxed) == hash &&
+          *slot_key == key)
+        return slot_key;
+    }
+  }
+
+  // Fills the empty |slot| of the current table, growing it if needed. Must
+  // be called with the lock held.
+  void Insert(Slot* slot, size_t hash, const std::string* key) {
+    slot->hash.store(hash, std::memory_order_relaxed);
+    slot->key.store(key, std::memory_order_release);
+    // Keep the load factor under 3/4.
+    if (++size_ * 4 > (table_.load(std::memory_order_relaxed)->mask + 1) * 3)
+      Grow();
+  }
+
+  // Publishes a copy of the current table twice as large. Must be called with
+  // the lock held, or from the constructor.
+  void Grow() {
+    Table* old_table = table_.load(std::memory_order_relaxed);
+    auto table = std::make_unique<Table>(old_table ? (old_table->mask + 1) * 2
+                                                   : kInitialTableSize);
+    if (old_table) {
+      for (size_t i = 0; i <= old_table->mask; i++) {
+        const Slot& old_slot = old_table->slots[i];
+        const std::string* key = old_slot.key.load(std::memory_order_relaxed);
+        if (!key)
+          continue;
+        size_t hash = old_slot.hash.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        Probe(table.get(), hash, *key, &slot);
+        slot->hash.store(hash, std::memory_order_relaxed);
+        slot->key.store(key, std::memory_order_relaxed);
+      }
+    }
+    table_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  static constexpr size_t kInitialTableSize = 256;
+
   static constexpr unsigned int kStringsPerSlab = 128;
 
   // Each slab is allocated independently, has a fixed address and stores
@@ -172,10 +272,57 @@ class StringAtomSet {
     StringStorage items_[kStringsPerSlab];
   };
 
+  std::atomic<Table*> table_ = nullptr;
+
+  // Protected by the lock.
   std::mutex mutex_;
-  KeySet set_;
+  size_t size_ = 0;
+  std::vector<std::unique_ptr<Table>> tables_;
   std::vector<Slab*> slabs_;
   unsigned int slab_index_ = kStringsPerSlab;
+
+  // Statistics, see StringAtom::Stats.
+  size_t count_ = 0;
+  size_t bytes_ = 0;
+  size_t lock_contention_ = 0;
+};
+
+class StringAtomSet {
+ public:
+  StringAtomSet() {
+    // Ensure kEmptyString is in our set while not being allocated
+    // from a slab. The end result is that find("") should always
+    // return this address.
+    //
+    // This allows the StringAtom() default initializer to use the same
+    // address directly, avoiding a table lookup.
+    //
+    size_t hash = KeySet::Hash("");
+    GetShard(hash).InsertStatic(hash, &kEmptyString);
+  }
+
+  // Find the unique constant string pointer for |key|, whose hash is |hash|.
+  const std::string* find(size_t hash, std::string_view key) {
+    return GetShard(hash).find(hash, key);
+  }
+
+  StringAtom::Stats GetStats() {
+    StringAtom::Stats stats;
+    for (StringAtomShard& shard : shards_)
+      shard.AddStats(&stats);
+    return stats;
+  }
+
+ private:
+  static constexpr int kShardBits = 3;
+
+  // The tables index their nodes with the low bits of the hash, so the shard
+  // is chosen with the high ones.
+  StringAtomShard& GetShard(size_t hash) {
+    return shards_[hash >> (sizeof(size_t) * 8 - kShardBits)];
+  }
+
+  std::array<StringAtomShard, 1 << kShardBits> shards_;
 };
 
 StringAtomSet& GetStringAtomSet() {
@@ -195,7 +342,7 @@ class ThreadLocalCache {
     if (node->key)
       return node->key;
 
-    KeyType result = GetStringAtomSet().find(key);
+    KeyType result = GetStringAtomSet().find(hash, key);
     local_set_.Insert(node, hash, result);
     return result;
   }
@@ -224,3 +371,8 @@ StringAtom::StringAtom(std::string_view str) noexcept
     : value_(*s_local_cache->find(str)) {
 }
 #endif
+
+// static
+StringAtom::Stats StringAtom::GetStats() {
+  return GetStringAtomSet().GetStats();
+}
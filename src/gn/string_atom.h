@@ -84,6 +84,17 @@ class StringAtom {
     return *this;
   }
 
+  // Statistics about the strings interned so far, to size the tables.
+  struct Stats {
+    // Number of distinct strings interned.
+    size_t count = 0;
+    // Sum of the sizes of these strings.
+    size_t bytes = 0;
+    // Number of times a thread had to wait for another to intern a string.
+    size_t lock_contention = 0;
+  };
+  static Stats GetStats();
+
   bool empty() const { return value_.empty(); }
 
   // Explicit conversions.
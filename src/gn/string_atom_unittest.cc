@@ -10,6 +10,7 @@
 #include <array>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 TEST(StringAtomTest, EmptyString) {
@@ -146,3 +147,36 @@ TEST(StringAtom, AllocMoreThanASingleSlabOfKeys) {
     ASSERT_EQ(keys[nn].str(), string_for(nn));
   }
 }
+
+TEST(StringAtom, ConcurrentInterning) {
+  // Threads interning the same new strings all get the same atoms.
+  const size_t kCount = 1000;
+  const int kThreadCount = 4;
+  auto string_for = [](size_t index) -> std::string {
+    return "concurrent_" + std::to_string(index);
+  };
+
+  StringAtom::Stats before = StringAtom::GetStats();
+  std::vector<std::vector<StringAtom>> keys(kThreadCount);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; i++) {
+    threads.emplace_back([&, i]() {
+      for (size_t nn = 0; nn < kCount; ++nn)
+        keys[i].push_back(StringAtom(string_for(nn)));
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  size_t bytes = 0;
+  for (size_t nn = 0; nn < kCount; ++nn) {
+    ASSERT_EQ(keys[0][nn].str(), string_for(nn));
+    bytes += string_for(nn).size();
+    for (int i = 1; i < kThreadCount; i++)
+      ASSERT_TRUE(keys[0][nn].SameAs(keys[i][nn]));
+  }
+
+  StringAtom::Stats after = StringAtom::GetStats();
+  EXPECT_EQ(kCount, after.count - before.count);
+  EXPECT_EQ(bytes, after.bytes - before.bytes);
+}
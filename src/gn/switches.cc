@@ -38,6 +38,31 @@ Examples
   gn desc out/Default --args="some_list=[1, false, \"foo\"]"
 )";
 
+const char kCheckCache[] = "check-cache";
+const char kCheckCache_HelpShort[] =
+    "--check-cache: Reuse results from previous header checks.";
+const char kCheckCache_Help[] =
+    R"(--check-cache: Reuse results from previous header checks.
+
+  Applies to "gn check" and "gn gen --check". Saves the includes found in every
+  checked file in the "gn_check_cache" file inside the build directory, and
+  uses them instead of reading the file again when a later check finds the
+  file's size and modification time unchanged.
+
+  The cache also remembers which files passed the check. A file is not checked
+  again as long as its includes, the targets providing the included files and
+  the dependencies of the target listing it are unchanged. Files with errors
+  are always checked again, so the errors reported are the same as without
+  the cache.
+
+  The cache file can be deleted at any time. Use "--time" with "gn gen --check"
+  to see how many scans and checks were reused.
+
+Examples
+
+  gn check out/Default --check-cache
+)";
+
 #define COLOR_HELP_LONG                                                       \
   "--[no]color: Forces colored output on or off.\n"                           \
   "\n"                                                                        \
@@ -54,6 +79,25 @@ const char kColor[] = "color";
 const char kColor_HelpShort[] = "--color: Force colored output.";
 const char kColor_Help[] = COLOR_HELP_LONG;
 
+const char kConcurrentResolve[] = "concurrent-resolve";
+const char kConcurrentResolve_HelpShort[] =
+    "--concurrent-resolve: Resolve targets on the worker threads.";
+const char kConcurrentResolve_Help[] =
+    R"(--concurrent-resolve: Resolve targets on the worker threads.
+
+  Once all dependencies of a target are known, GN checks the target and
+  computes the values it inherits from its dependencies. Normally this happens
+  on the main thread, which can limit how fast very large builds load.
+
+  With this switch, that work is done on the worker threads instead, so
+  independent targets are resolved in parallel. The generated files are the
+  same either way.
+
+Examples
+
+  gn gen out/Default --concurrent-resolve
+)";
+
 const char kDotfile[] = "dotfile";
 const char kDotfile_HelpShort[] =
     "--dotfile: Override the name of the \".gn\" file.";
@@ -109,6 +153,25 @@ const char kNinjaExecutable_Help[] =
   post-processing on the generated files for more consistent builds.
 )";
 
+const char kParseCache[] = "parse-cache";
+const char kParseCache_HelpShort[] =
+    "--parse-cache: Reuse parse results from previous runs.";
+const char kParseCache_Help[] =
+    R"(--parse-cache: Reuse parse results from previous runs.
+
+  Saves the parse tree of every loaded build file in the "gn_parse_cache"
+  directory inside the build directory, and loads it from there instead of
+  parsing the file again when a later run finds the file unchanged. Entries
+  are keyed by the file contents, so editing a file never reuses a stale tree.
+
+  The cache directory can be deleted at any time. Use "--time" to see how many
+  files were served from it.
+
+Examples
+
+  gn gen out/Default --parse-cache
+)";
+
 const char kScriptExecutable[] = "script-executable";
 const char kScriptExecutable_HelpShort[] =
     "--script-executable: Set the executable used to execute scripts.";
@@ -246,6 +309,31 @@ Runtime deps output file
   "bar.so").
 )";
 
+const char kShareImports[] = "share-imports";
+const char kShareImports_HelpShort[] =
+    "--share-imports: Share imports across toolchains.";
+const char kShareImports_Help[] =
+    R"(--share-imports: Share imports across toolchains.
+
+  Normally every toolchain executes each file it imports, since the result
+  can depend on the variables of the toolchain. With this switch, the
+  variables an import reads from the build config are recorded along with its
+  result, and a toolchain for which they have the same values copies that
+  result instead of executing the file again.
+
+  Imports reading a built-in variable like "current_toolchain", or calling a
+  built-in function that may depend on the toolchain like "declare_args" or
+  "get_label_info", are executed by every toolchain as usual. So are the files
+  importing them.
+
+  Since shared imports are executed once, the "exec_script" and "write_file"
+  calls they make run once. Use "--time" to see how many imports were shared.
+
+Examples
+
+  gn gen out/Default --share-imports
+)";
+
 const char kThreads[] = "threads";
 const char kThreads_HelpShort[] =
     "--threads: Specify number of worker threads.";
@@ -331,18 +419,22 @@ const SwitchInfoMap& GetSwitches() {
   static SwitchInfoMap info_map;
   if (info_map.empty()) {
     INSERT_VARIABLE(Args)
+    INSERT_VARIABLE(CheckCache)
     INSERT_VARIABLE(Color)
+    INSERT_VARIABLE(ConcurrentResolve)
     INSERT_VARIABLE(Dotfile)
     INSERT_VARIABLE(FailOnUnusedArgs)
     INSERT_VARIABLE(Markdown)
     INSERT_VARIABLE(NinjaExecutable)
     INSERT_VARIABLE(NoColor)
+    INSERT_VARIABLE(ParseCache)
     INSERT_VARIABLE(Root)
     INSERT_VARIABLE(RootPattern)
     INSERT_VARIABLE(RootTarget)
     INSERT_VARIABLE(Quiet)
     INSERT_VARIABLE(RuntimeDepsListFile)
     INSERT_VARIABLE(ScriptExecutable)
+    INSERT_VARIABLE(ShareImports)
     INSERT_VARIABLE(Threads)
     INSERT_VARIABLE(Time)
     INSERT_VARIABLE(Tracelog)
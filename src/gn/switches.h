@@ -30,10 +30,18 @@ extern const char kArgs[];
 extern const char kArgs_HelpShort[];
 extern const char kArgs_Help[];
 
+extern const char kCheckCache[];
+extern const char kCheckCache_HelpShort[];
+extern const char kCheckCache_Help[];
+
 extern const char kColor[];
 extern const char kColor_HelpShort[];
 extern const char kColor_Help[];
 
+extern const char kConcurrentResolve[];
+extern const char kConcurrentResolve_HelpShort[];
+extern const char kConcurrentResolve_Help[];
+
 extern const char kDotfile[];
 extern const char kDotfile_HelpShort[];
 extern const char kDotfile_Help[];
@@ -54,6 +62,10 @@ extern const char kNoColor[];
 extern const char kNoColor_HelpShort[];
 extern const char kNoColor_Help[];
 
+extern const char kParseCache[];
+extern const char kParseCache_HelpShort[];
+extern const char kParseCache_Help[];
+
 extern const char kScriptExecutable[];
 extern const char kScriptExecutable_HelpShort[];
 extern const char kScriptExecutable_Help[];
@@ -78,6 +90,10 @@ extern const char kRuntimeDepsListFile[];
 extern const char kRuntimeDepsListFile_HelpShort[];
 extern const char kRuntimeDepsListFile_Help[];
 
+extern const char kShareImports[];
+extern const char kShareImports_HelpShort[];
+extern const char kShareImports_Help[];
+
 extern const char kThreads[];
 extern const char kThreads_HelpShort[];
 extern const char kThreads_Help[];
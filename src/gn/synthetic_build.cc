@@ -0,0 +1,228 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/synthetic_build.h"
+
+#include <algorithm>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "gn/err.h"
+#include "gn/filesystem_utils.h"
+
+namespace {
+
+const char kToolchainTemplate[] = R"(
+toolchain("$NAME") {
+  tool("cxx") {
+    depfile = "{{output}}.d"
+    command = "c++ -MMD -MF $depfile {{defines}} {{include_dirs}} " +
+              "{{cflags}} {{cflags_cc}} -c {{source}} -o {{output}}"
+    depsformat = "gcc"
+    description = "CXX {{output}}"
+    outputs = [
+      "{{source_out_dir}}/{{target_output_name}}.{{source_name_part}}.o",
+    ]
+  }
+  tool("alink") {
+    command = "ar rcs {{output}} {{inputs}}"
+    description = "AR {{output}}"
+    outputs = [
+      "{{target_out_dir}}/{{target_output_name}}{{output_extension}}",
+    ]
+    default_output_extension = ".a"
+    output_prefix = "lib"
+  }
+  tool("stamp") {
+    command = "touch {{output}}"
+    description = "STAMP {{output}}"
+  }
+  tool("copy") {
+    command = "cp -af {{source}} {{output}}"
+    description = "COPY {{source}} {{output}}"
+  }
+}
+)";
+
+std::string Int(int i) {
+  return base::IntToString(i);
+}
+
+std::string LibraryLabel(const SyntheticBuildParams& params, int i) {
+  return "//d" + Int(i / params.targets_per_dir) + ":t" + Int(i);
+}
+
+// Returns the name of the template (or function) libraries are defined with.
+std::string LibraryFunction(const SyntheticBuildParams& params) {
+  if (params.template_depth == 0)
+    return "static_library";
+  return "lib" + Int(params.template_depth - 1);
+}
+
+std::string GetBuildConfig(const SyntheticBuildParams& params) {
+  std::string result = "set_default_toolchain(\"//build/toolchain:tc0\")\n";
+  result += "default_configs = [\n";
+  for (int i = 0; i < params.configs; i++)
+    result += "  \"//build:c" + Int(i) + "\",\n";
+  result += "]\n";
+  result += "set_defaults(\"static_library\") {\n";
+  result += "  configs = default_configs\n";
+  result += "}\n";
+  return result;
+}
+
+std::string GetConfigs(const SyntheticBuildParams& params) {
+  std::string result;
+  for (int i = 0; i < params.configs; i++) {
+    result += "config(\"c" + Int(i) + "\") {\n";
+    result += "  defines = [ \"CONFIG_" + Int(i) + "\" ]\n";
+    result += "  cflags = [ \"-fconfig-" + Int(i) + "\" ]\n";
+    result += "  include_dirs = [ \"//include/c" + Int(i) + "\" ]\n";
+    result += "}\n";
+  }
+  return result;
+}
+
+std::string GetToolchains(const SyntheticBuildParams& params) {
+  std::string result;
+  for (int i = 0; i < params.toolchains; i++) {
+    std::string toolchain = kToolchainTemplate;
+    toolchain.replace(toolchain.find("$NAME"), 5, "tc" + Int(i));
+    result += toolchain;
+  }
+  return result;
+}
+
+std::string GetTemplates(const SyntheticBuildParams& params) {
+  std::string result;
+  if (params.list_appends > 0) {
+    result += "synthetic_items = [\n";
+    for (int i = 0; i < params.list_appends; i++)
+      result += "  \"item" + Int(i) + "\",\n";
+    result += "]\n";
+  }
+  for (int i = 0; i < params.template_depth; i++) {
+    std::string wrapped = i == 0 ? "static_library" : "lib" + Int(i - 1);
+    result += "template(\"lib" + Int(i) + "\") {\n";
+    result += "  " + wrapped + "(target_name) {\n";
+    result += "    forward_variables_from(invoker, \"*\")\n";
+    result += "    if (!defined(defines)) {\n";
+    result += "      defines = []\n";
+    result += "    }\n";
+    result += "    defines += [ \"DEPTH_" + Int(i) + "=\" + target_name ]\n";
+    if (params.statements > 0) {
+      result += "    _count = 0\n";
+      for (int j = 0; j < params.statements; j++) {
+        result += "    if (_count <= " + Int(j) + ") {\n";
+        result += "      _count += 1\n";
+        result += "    } else {\n";
+        result += "      _count -= 1\n";
+        result += "    }\n";
+      }
+      result += "    defines += [ \"COUNT_" + Int(i) + "=$_count\" ]\n";
+    }
+    if (params.list_appends > 0) {
+      result += "    if (!defined(data)) {\n";
+      result += "      data = []\n";
+      result += "    }\n";
+      result += "    foreach(item, synthetic_items) {\n";
+      result += "      data += [ \"" + Int(i) + "/\" + item ]\n";
+      result += "    }\n";
+    }
+    result += "  }\n";
+    result += "}\n";
+  }
+  return result;
+}
+
+// Returns the build file for the libraries in [begin, end).
+std::string GetLibraries(const SyntheticBuildParams& params,
+                         int dir,
+                         int begin,
+                         int end) {
+  std::string function = LibraryFunction(params);
+  std::string result = "import(\"//build/templates.gni\")\n";
+  for (int i = begin; i < end; i++) {
+    std::string name = "t" + Int(i);
+    result += "\n" + function + "(\"" + name + "\") {\n";
+    result += "  sources = [ \"" + name + "_a.cc\", \"" + name + "_b.cc\" ]\n";
+    result += "  deps = [";
+    int first_child = i * params.fan_out + 1;
+    int last_child = std::min(params.targets, first_child + params.fan_out);
+    for (int child = first_child; child < last_child; child++)
+      result += " \"" + LibraryLabel(params, child) + "\",";
+    result += " ]\n";
+    result += "}\n";
+  }
+  result += "\ngroup(\"d" + Int(dir) + "\") {\n";
+  result += "  deps = [ \":t" + Int(begin) + "\" ]\n";
+  result += "}\n";
+  return result;
+}
+
+std::string GetRootBuildFile(const SyntheticBuildParams& params, int dirs) {
+  std::string result = "group(\"all\") {\n  deps = [\n";
+  for (int toolchain = 0; toolchain < params.toolchains; toolchain++) {
+    std::string suffix;
+    if (toolchain > 0)
+      suffix = "(//build/toolchain:tc" + Int(toolchain) + ")";
+    for (int dir = 0; dir < dirs; dir++)
+      result += "    \"//d" + Int(dir) + suffix + "\",\n";
+  }
+  result += "  ]\n}\n";
+  return result;
+}
+
+bool WriteBuildFile(const base::FilePath& root,
+                    const std::string& name,
+                    const std::string& contents,
+                    Err* err) {
+  base::FilePath path = root.AppendASCII(name);
+  if (!base::CreateDirectory(path.DirName()) ||
+      base::WriteFile(path, contents.data(),
+                      static_cast<int>(contents.size())) !=
+          static_cast<int>(contents.size())) {
+    *err = Err(Location(), "Unable to write file.",
+               "I was writing \"" + FilePathToUTF8(path) + "\".");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool WriteSyntheticBuild(const base::FilePath& root,
+                         const SyntheticBuildParams& params,
+                         Err* err) {
+  if (params.targets < 1 || params.fan_out < 0 || params.template_depth < 0 ||
+      params.list_appends < 0 || params.statements < 0 || params.configs < 0 ||
+      params.toolchains < 1 || params.targets_per_dir < 1) {
+    *err = Err(Location(), "Invalid synthetic build parameters.");
+    return false;
+  }
+
+  int dirs = (params.targets + params.targets_per_dir - 1) /
+             params.targets_per_dir;
+  if (!WriteBuildFile(root, ".gn", "buildconfig = \"//build/BUILDCONFIG.gn\"\n",
+                      err) ||
+      !WriteBuildFile(root, "build/BUILDCONFIG.gn", GetBuildConfig(params),
+                      err) ||
+      !WriteBuildFile(root, "build/BUILD.gn", GetConfigs(params), err) ||
+      !WriteBuildFile(root, "build/toolchain/BUILD.gn", GetToolchains(params),
+                      err) ||
+      !WriteBuildFile(root, "build/templates.gni", GetTemplates(params), err) ||
+      !WriteBuildFile(root, "BUILD.gn", GetRootBuildFile(params, dirs), err))
+    return false;
+
+  for (int dir = 0; dir < dirs; dir++) {
+    int begin = dir * params.targets_per_dir;
+    int end = std::min(params.targets, begin + params.targets_per_dir);
+    if (!WriteBuildFile(root, "d" + Int(dir) + "/BUILD.gn",
+                        GetLibraries(params, dir, begin, end), err))
+      return false;
+  }
+  return true;
+}
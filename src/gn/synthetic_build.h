@@ -0,0 +1,52 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TOOLS_GN_SYNTHETIC_BUILD_H_
+#define TOOLS_GN_SYNTHETIC_BUILD_H_
+
+namespace base {
+class FilePath;
+}
+
+class Err;
+
+// Describes a generated source tree used to measure the performance of GN on
+// builds of various shapes.
+struct SyntheticBuildParams {
+  // Number of libraries in the build. The libraries form a tree where each
+  // one depends on the next |fan_out| ones.
+  int targets = 1000;
+  int fan_out = 3;
+
+  // Number of templates each library goes through before reaching
+  // static_library(). Each template forwards everything to the next and adds
+  // a define.
+  int template_depth = 2;
+
+  // Number of items each template appends one by one to the "data" list it
+  // forwards, like build files accumulating sources or deps in a loop.
+  int list_appends = 0;
+
+  // Number of conditional assignments each template evaluates, like the logic
+  // of templates computing flags from build arguments.
+  int statements = 0;
+
+  // Number of configs applied to every library by default.
+  int configs = 4;
+
+  // Number of toolchains the whole build is loaded in.
+  int toolchains = 1;
+
+  // Libraries are spread over build files holding this many each.
+  int targets_per_dir = 20;
+};
+
+// Writes the source tree of a synthetic build described by |params| in the
+// given directory, which must exist. "//:all" depends on every library in
+// every toolchain.
+bool WriteSyntheticBuild(const base::FilePath& root,
+                         const SyntheticBuildParams& params,
+                         Err* err);
+
+#endif  // TOOLS_GN_SYNTHETIC_BUILD_H_
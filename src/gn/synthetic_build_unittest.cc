@@ -0,0 +1,52 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "gn/synthetic_build.h"
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "gn/err.h"
+#include "gn/input_file.h"
+#include "gn/parse_tree.h"
+#include "gn/parser.h"
+#include "gn/tokenizer.h"
+#include "util/test/test.h"
+
+TEST(SyntheticBuild, WritesParsableFiles) {
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  SyntheticBuildParams params;
+  params.targets = 45;
+  params.toolchains = 2;
+  params.list_appends = 3;
+  params.statements = 3;
+  Err err;
+  ASSERT_TRUE(WriteSyntheticBuild(temp_dir.GetPath(), params, &err));
+
+  // Three directories of libraries, the root build file and four files in
+  // //build.
+  int build_files = 0;
+  base::FileEnumerator files(temp_dir.GetPath(), true,
+                             base::FileEnumerator::FILES);
+  for (base::FilePath path = files.Next(); !path.empty(); path = files.Next()) {
+    if (path.BaseName().value() == FILE_PATH_LITERAL(".gn"))
+      continue;
+    build_files++;
+
+    InputFile file(SourceFile("//BUILD.gn"));
+    ASSERT_TRUE(file.Load(path));
+    std::vector<Token> tokens = Tokenizer::Tokenize(&file, &err);
+    ASSERT_FALSE(err.has_error()) << err.message();
+    std::unique_ptr<ParseNode> root = Parser::Parse(tokens, &err);
+    ASSERT_FALSE(err.has_error()) << err.message();
+  }
+  EXPECT_EQ(8, build_files);
+
+  // Out of range parameters are rejected.
+  params.toolchains = 0;
+  EXPECT_FALSE(WriteSyntheticBuild(temp_dir.GetPath(), params, &err));
+  EXPECT_TRUE(err.has_error());
+}
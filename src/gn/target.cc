@@ -11,13 +11,16 @@
 #include "base/stl_util.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
+#include "gn/build_settings.h"
 #include "gn/c_tool.h"
+#include "gn/config_values_cache.h"
 #include "gn/config_values_extractors.h"
 #include "gn/deps_iterator.h"
 #include "gn/filesystem_utils.h"
 #include "gn/functions.h"
 #include "gn/rust_tool.h"
 #include "gn/scheduler.h"
+#include "gn/settings.h"
 #include "gn/substitution_writer.h"
 #include "gn/tool.h"
 #include "gn/toolchain.h"
@@ -386,6 +389,22 @@ ConfigValues& Target::config_values() {
   return *config_values_;
 }
 
+const FlattenedConfigValues& Target::flattened_config_values() const {
+  const FlattenedConfigValues* flattened =
+      flattened_config_values_.load(std::memory_order_acquire);
+  if (!flattened) {
+    // Threads racing here get the same pointer from the cache.
+    std::vector<const Config*> configs;
+    configs.reserve(configs_.size());
+    for (const LabelConfigPair& config : configs_)
+      configs.push_back(config.ptr);
+    flattened = settings()->build_settings()->config_values_cache()->Get(
+        configs);
+    flattened_config_values_.store(flattened, std::memory_order_release);
+  }
+  return *flattened;
+}
+
 static const ActionValues kEmptyActionValues;
 
 const ActionValues& Target::action_values() const {
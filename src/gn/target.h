@@ -5,6 +5,7 @@
 #ifndef TOOLS_GN_TARGET_H_
 #define TOOLS_GN_TARGET_H_
 
+#include <atomic>
 #include <set>
 #include <string>
 #include <vector>
@@ -27,6 +28,7 @@
 #include "gn/unique_vector.h"
 
 class DepsIteratorRange;
+class FlattenedConfigValues;
 class Settings;
 class Target;
 class Toolchain;
@@ -270,6 +272,10 @@ class Target : public Item {
   const UniqueVector<LabelConfigPair>& configs() const { return configs_; }
   UniqueVector<LabelConfigPair>& configs() { return configs_; }
 
+  // The values of configs(), flattened and shared with the other targets
+  // using the same configs. Only valid once the target is resolved.
+  const FlattenedConfigValues& flattened_config_values() const;
+
   // List of configs that all dependencies (direct and indirect) of this
   // target get. These configs are not added to this target. Note that due
   // to the way this is computed, there may be duplicates in this list.
@@ -530,6 +536,10 @@ class Target : public Item {
   // use for this target, if precompiled headers are used.
   std::unique_ptr<ConfigValues> config_values_;
 
+  // Computed on first use from configs_, see flattened_config_values().
+  mutable std::atomic<const FlattenedConfigValues*> flattened_config_values_ =
+      nullptr;
+
   // Used for action[_foreach] targets.
   std::unique_ptr<ActionValues> action_values_;
 
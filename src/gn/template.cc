@@ -143,3 +143,19 @@ Value Template::Invoke(Scope* scope,
 LocationRange Template::GetDefinitionRange() const {
   return definition_->GetRange();
 }
+
+scoped_refptr<const Template> Template::CopyToNewContaining(
+    const Scope* old_parent,
+    const Scope* new_parent,
+    std::map<const Template*, scoped_refptr<const Template>>* copies) const {
+  if (closure_->const_containing() != old_parent)
+    return scoped_refptr<const Template>(this);
+
+  scoped_refptr<const Template>& copy = (*copies)[this];
+  if (!copy) {
+    auto closure = std::make_unique<Scope>(new_parent);
+    closure_->CopyToNewContaining(closure.get(), copies);
+    copy = base::MakeRefCounted<Template>(std::move(closure), definition_);
+  }
+  return copy;
+}
@@ -5,6 +5,7 @@
 #ifndef TOOLS_GN_TEMPLATE_H_
 #define TOOLS_GN_TEMPLATE_H_
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -46,6 +47,13 @@ class Template : public base::RefCountedThreadSafe<Template> {
   // Returns the location range where this template was defined.
   LocationRange GetDefinitionRange() const;
 
+  // Returns this template, or a copy whose closure is based on |new_parent|
+  // if it is based on |old_parent|. See Scope::CopyToNewContaining().
+  scoped_refptr<const Template> CopyToNewContaining(
+      const Scope* old_parent,
+      const Scope* new_parent,
+      std::map<const Template*, scoped_refptr<const Template>>* copies) const;
+
  private:
   friend class base::RefCountedThreadSafe<Template>;
 
@@ -78,6 +78,9 @@ class Tokenizer {
   // Increments the current location by one.
   void Advance();
 
+  // Moves the current location forward to the given offset.
+  void AdvanceTo(size_t offset);
+
   // Returns the current character in the file as a location.
   Location GetCurrentLocation() const;
 
@@ -145,6 +145,41 @@ TEST(Tokenizer, Locations) {
   ASSERT_TRUE(results[3].location() == Location(&input, 2, 3));
 }
 
+// Runs of whitespace, comments and strings longer than a vector of bytes.
+TEST(Tokenizer, LongRuns) {
+  InputFile input(SourceFile("/test"));
+  input.SetContents(
+      "a = \"0123456789abcdef0123456789\\\"abcdef\\\\\"\n"
+      "                                  b\n"
+      "\n"
+      "\n"
+      "  # A comment which is longer than sixteen characters.\n"
+      "                  \r\n"
+      "c");
+  Err err;
+  std::vector<Token> results = Tokenizer::Tokenize(&input, &err);
+  EXPECT_FALSE(err.has_error());
+
+  ASSERT_EQ(6u, results.size());
+  EXPECT_EQ("\"0123456789abcdef0123456789\\\"abcdef\\\\\"",
+            results[2].value());
+  EXPECT_TRUE(results[3].location() == Location(&input, 2, 35));
+  EXPECT_EQ(Token::BLOCK_COMMENT, results[4].type());
+  EXPECT_EQ("# A comment which is longer than sixteen characters.",
+            results[4].value());
+  EXPECT_TRUE(results[4].location() == Location(&input, 5, 3));
+  EXPECT_TRUE(results[5].location() == Location(&input, 7, 1));
+
+  // The error highlights the string up to its last newline.
+  input.SetContents("a = \"0123456789abcdef\n0123\n456789abcdef\"");
+  results = Tokenizer::Tokenize(&input, &err);
+  EXPECT_TRUE(err.has_error());
+  EXPECT_EQ("Newline in string constant.", err.message());
+  ASSERT_EQ(1u, err.ranges().size());
+  EXPECT_TRUE(err.ranges()[0].begin() == Location(&input, 1, 5));
+  EXPECT_TRUE(err.ranges()[0].end() == Location(&input, 2, 5));
+}
+
 TEST(Tokenizer, ByteOffsetOfNthLine) {
   EXPECT_EQ(0u, Tokenizer::ByteOffsetOfNthLine("foo", 1));
 
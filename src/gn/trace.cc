@@ -4,6 +4,7 @@
 
 #include "gn/trace.h"
 
+#include <inttypes.h>
 #include <stddef.h>
 
 #include <algorithm>
@@ -35,6 +36,23 @@ class TraceLog {
     events_.push_back(std::move(item));
   }
 
+  void AddCounter(const std::string& name, int64_t value) {
+    std::lock_guard<std::mutex> lock(lock_);
+    counters_[name] += value;
+  }
+
+  void MaxCounter(const std::string& name, int64_t value) {
+    std::lock_guard<std::mutex> lock(lock_);
+    int64_t& counter = counters_[name];
+    counter = std::max(counter, value);
+  }
+
+  // Returns a copy for threadsafety.
+  std::map<std::string, int64_t> counters() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return counters_;
+  }
+
   // Returns a copy for threadsafety.
   std::vector<TraceItem*> events() const {
     std::vector<TraceItem*> events;
@@ -49,6 +67,7 @@ class TraceLog {
   mutable std::mutex lock_;
 
   std::vector<std::unique_ptr<TraceItem>> events_;
+  std::map<std::string, int64_t> counters_;
 
   TraceLog(const TraceLog&) = delete;
   TraceLog& operator=(const TraceLog&) = delete;
@@ -117,6 +136,13 @@ void SummarizeScriptExecs(std::vector<const TraceItem*>& execs,
   SummarizeCoalesced(execs, out);
 }
 
+void SummarizeCounters(const std::map<std::string, int64_t>& counters,
+                       std::ostream& out) {
+  out << "Counters: (value, name)\n";
+  for (const auto& [name, value] : counters)
+    out << base::StringPrintf(" %10" PRId64 "  ", value) << name << std::endl;
+}
+
 }  // namespace
 
 TraceItem::TraceItem(Type type,
@@ -179,6 +205,27 @@ void AddTrace(std::unique_ptr<TraceItem> item) {
   trace_log->Add(std::move(item));
 }
 
+void AddTraceCounter(const std::string& name, int64_t value) {
+  if (trace_log)
+    trace_log->AddCounter(name, value);
+}
+
+void SetTraceCounterMax(const std::string& name, int64_t value) {
+  if (trace_log)
+    trace_log->MaxCounter(name, value);
+}
+
+TickDelta GetTotalTraceDuration(TraceItem::Type type) {
+  uint64_t total = 0;
+  if (trace_log) {
+    for (const TraceItem* event : trace_log->events()) {
+      if (event->type() == type)
+        total += event->delta().raw();
+    }
+  }
+  return TickDelta(total);
+}
+
 std::string SummarizeTraces() {
   if (!trace_log)
     return std::string();
@@ -213,6 +260,7 @@ std::string SummarizeTraces() {
       case TraceItem::TRACE_SETUP:
       case TraceItem::TRACE_FILE_EXECUTE_TEMPLATE:
       case TraceItem::TRACE_FILE_LOAD:
+      case TraceItem::TRACE_FILE_TOKENIZE:
       case TraceItem::TRACE_FILE_WRITE:
       case TraceItem::TRACE_FILE_WRITE_GENERATED:
       case TraceItem::TRACE_FILE_WRITE_NINJA:
@@ -244,6 +292,12 @@ std::string SummarizeTraces() {
                               headers_checked);
   }
 
+  std::map<std::string, int64_t> counters = trace_log->counters();
+  if (!counters.empty()) {
+    out << std::endl;
+    SummarizeCounters(counters, out);
+  }
+
   return out.str();
 }
 
@@ -294,6 +348,9 @@ void SaveTraces(const base::FilePath& file_name) {
       case TraceItem::TRACE_FILE_PARSE:
         out << "\"parse\"";
         break;
+      case TraceItem::TRACE_FILE_TOKENIZE:
+        out << "\"tokenize\"";
+        break;
       case TraceItem::TRACE_FILE_EXECUTE:
         out << "\"file_exec\"";
         break;
@@ -357,6 +414,21 @@ void SaveTraces(const base::FilePath& file_name) {
     out << "}";
   }
 
+  // Counters have no meaningful begin time, so they are reported as a single
+  // sample at the end of the run.
+  Ticks counters_ts = TicksNow() / kNanosecondsToMicroseconds;
+  bool needs_comma = !events.empty();
+  for (const auto& [name, value] : trace_log->counters()) {
+    quote_buffer.resize(0);
+    base::EscapeJSONString(name, true, &quote_buffer);
+    if (needs_comma)
+      out << ",";
+    needs_comma = true;
+    out << "{\"pid\":0,\"tid\":\"0\",\"ts\":" << counters_ts
+        << ",\"ph\":\"C\",\"name\":" << quote_buffer
+        << ",\"args\":{\"value\":" << value << "}}";
+  }
+
   out << "]}";
 
   std::string out_str = out.str();
@@ -5,6 +5,8 @@
 #ifndef TOOLS_GN_TRACE_H_
 #define TOOLS_GN_TRACE_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <string>
 #include <thread>
@@ -24,6 +26,7 @@ class TraceItem {
     TRACE_SETUP,
     TRACE_FILE_LOAD,
     TRACE_FILE_PARSE,
+    TRACE_FILE_TOKENIZE,  // Part of TRACE_FILE_PARSE.
     TRACE_FILE_EXECUTE,
     TRACE_FILE_EXECUTE_TEMPLATE,
     TRACE_FILE_WRITE,
@@ -98,6 +101,20 @@ bool TracingEnabled();
 // Adds a trace event to the log.
 void AddTrace(std::unique_ptr<TraceItem> item);
 
+// Adds |value| to the named counter. Counters accumulate over the whole run and
+// are listed in the summary and saved as counter events in the trace log. Does
+// nothing if tracing is not enabled.
+void AddTraceCounter(const std::string& name, int64_t value);
+
+// Raises the named counter to |value| if it's lower. Used for levels, such as
+// sizes and maximums, that would be wrong if added up over several runs of the
+// scheduler.
+void SetTraceCounterMax(const std::string& name, int64_t value);
+
+// Returns the sum of the durations of the traces of the given type so far, or
+// zero if tracing is not enabled.
+TickDelta GetTotalTraceDuration(TraceItem::Type type);
+
 // Returns a summary of the current traces, or the empty string if tracing is
 // not enabled.
 std::string SummarizeTraces();
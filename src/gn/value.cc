@@ -28,7 +28,7 @@ Value::Value(const ParseNode* origin, Type t) : type_(t), origin_(origin) {
       new (&string_value_) std::string();
       break;
     case LIST:
-      new (&list_value_) std::vector<Value>();
+      new (&list_value_) scoped_refptr<ListStorage>();
       break;
     case SCOPE:
       new (&scope_value_) std::unique_ptr<Scope>();
@@ -36,6 +36,13 @@ Value::Value(const ParseNode* origin, Type t) : type_(t), origin_(origin) {
   }
 }
 
+Value::ListStorage::ListStorage() = default;
+
+Value::ListStorage::ListStorage(const std::vector<Value>& items)
+    : items(items) {}
+
+Value::ListStorage::~ListStorage() = default;
+
 Value::Value(const ParseNode* origin, bool bool_val)
     : type_(BOOLEAN), origin_(origin), boolean_value_(bool_val) {}
 
@@ -65,7 +72,7 @@ Value::Value(const Value& other) : type_(other.type_), origin_(other.origin_) {
       new (&string_value_) std::string(other.string_value_);
       break;
     case LIST:
-      new (&list_value_) std::vector<Value>(other.list_value_);
+      new (&list_value_) scoped_refptr<ListStorage>(other.list_value_);
       break;
     case SCOPE:
       new (&scope_value_) std::unique_ptr<Scope>(
@@ -90,7 +97,8 @@ Value::Value(Value&& other) noexcept
       new (&string_value_) std::string(std::move(other.string_value_));
       break;
     case LIST:
-      new (&list_value_) std::vector<Value>(std::move(other.list_value_));
+      new (&list_value_)
+          scoped_refptr<ListStorage>(std::move(other.list_value_));
       break;
     case SCOPE:
       new (&scope_value_) std::unique_ptr<Scope>(std::move(other.scope_value_));
@@ -121,7 +129,7 @@ Value::~Value() {
       string_value_.~string();
       break;
     case LIST:
-      list_value_.~vector<Value>();
+      list_value_.~scoped_refptr<ListStorage>();
       break;
     case SCOPE:
       scope_value_.~unique_ptr<Scope>();
@@ -130,6 +138,19 @@ Value::~Value() {
   }
 }
 
+void Value::DetachList() {
+  if (list_value_)
+    list_value_ = base::MakeRefCounted<ListStorage>(list_value_->items);
+  else
+    list_value_ = base::MakeRefCounted<ListStorage>();
+}
+
+// static
+const std::vector<Value>& Value::EmptyList() {
+  static const std::vector<Value> empty;
+  return empty;
+}
+
 // static
 const char* Value::DescribeType(Type t) {
   switch (t) {
@@ -190,11 +211,12 @@ std::string Value::ToString(bool quote_string) const {
       }
       return string_value_;
     case LIST: {
+      const std::vector<Value>& list = list_value();
       std::string result = "[";
-      for (size_t i = 0; i < list_value_.size(); i++) {
+      for (size_t i = 0; i < list.size(); i++) {
         if (i > 0)
           result += ", ";
-        result += list_value_[i].ToString(true);
+        result += list[i].ToString(true);
       }
       result.push_back(']');
       return result;
@@ -9,8 +9,12 @@
 
 #include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
 #include "gn/err.h"
 
 class ParseNode;
@@ -84,14 +88,12 @@ class Value {
     return string_value_;
   }
 
-  std::vector<Value>& list_value() {
-    DCHECK(type_ == LIST);
-    return list_value_;
-  }
-  const std::vector<Value>& list_value() const {
-    DCHECK(type_ == LIST);
-    return list_value_;
-  }
+  // Lists are shared between copies of a value until one of them is
+  // modified, so copying a list is cheap. Getting the non-const list makes
+  // this value its sole owner, so don't hold on to the reference across
+  // copies of the value.
+  std::vector<Value>& list_value();
+  const std::vector<Value>& list_value() const;
 
   Scope* scope_value() {
     DCHECK(type_ == SCOPE);
@@ -121,6 +123,27 @@ class Value {
  private:
   void Deallocate();
 
+  // The items of a list, shared between the copies of a value. The reference
+  // count is intrusive so that checking for a sole owner is an acquire load,
+  // which orders this thread's writes after the reads of the other owners
+  // that have let go of the list, possibly on other threads.
+  class ListStorage : public base::RefCountedThreadSafe<ListStorage> {
+   public:
+    ListStorage();
+    explicit ListStorage(const std::vector<Value>& items);
+
+    std::vector<Value> items;
+
+   private:
+    friend class base::RefCountedThreadSafe<ListStorage>;
+    ~ListStorage();
+  };
+
+  // Gives this value its own copy of the list. Empty lists are null until
+  // modified.
+  void DetachList();
+  static const std::vector<Value>& EmptyList();
+
   Type type_ = NONE;
   const ParseNode* origin_ = nullptr;
 
@@ -128,9 +151,21 @@ class Value {
     bool boolean_value_;
     int64_t int_value_;
     std::string string_value_;
-    std::vector<Value> list_value_;
+    scoped_refptr<ListStorage> list_value_;
     std::unique_ptr<Scope> scope_value_;
   };
 };
 
+inline std::vector<Value>& Value::list_value() {
+  DCHECK(type_ == LIST);
+  if (!list_value_ || !list_value_->HasOneRef())
+    DetachList();
+  return list_value_->items;
+}
+
+inline const std::vector<Value>& Value::list_value() const {
+  DCHECK(type_ == LIST);
+  return list_value_ ? list_value_->items : EmptyList();
+}
+
 #endif  // TOOLS_GN_VALUE_H_
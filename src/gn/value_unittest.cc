@@ -58,3 +58,32 @@ TEST(Value, ToString) {
   Value nested_scopeval(nullptr, std::unique_ptr<Scope>(nested_scope));
   EXPECT_FALSE(nested_scopeval == nested_scopeval);
 }
+
+TEST(Value, ListCopyOnWrite) {
+  Value list(nullptr, Value::LIST);
+  EXPECT_TRUE(list.list_value().empty());
+  list.list_value().push_back(Value(nullptr, "a"));
+
+  // Copies share the list until modified.
+  Value copy(list);
+  const Value& const_list = list;
+  const Value& const_copy = copy;
+  EXPECT_EQ(&const_list.list_value(), &const_copy.list_value());
+
+  copy.list_value().push_back(Value(nullptr, "b"));
+  EXPECT_NE(&const_list.list_value(), &const_copy.list_value());
+  EXPECT_EQ("[\"a\"]", list.ToString(true));
+  EXPECT_EQ("[\"a\", \"b\"]", copy.ToString(true));
+
+  // Modifying the original doesn't affect later copies of it either.
+  Value assigned(nullptr, Value::LIST);
+  assigned = list;
+  list.list_value()[0] = Value(nullptr, "c");
+  EXPECT_EQ("[\"a\"]", assigned.ToString(true));
+  EXPECT_EQ("[\"c\"]", list.ToString(true));
+
+  // Moved-from lists are empty.
+  Value moved(std::move(list));
+  EXPECT_EQ("[\"c\"]", moved.ToString(true));
+  EXPECT_TRUE(list.list_value().empty());
+}
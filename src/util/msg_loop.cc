@@ -37,7 +37,7 @@ void MsgLoop::Run() {
       });
 
       if (should_quit_)
-        return;
+        break;
 
       task = std::move(task_queue_.front());
       task_queue_.pop();
@@ -45,6 +45,9 @@ void MsgLoop::Run() {
 
     task();
   }
+
+  // Allow the loop to be run again.
+  should_quit_ = false;
 }
 
 void MsgLoop::PostQuit() {
@@ -76,6 +79,15 @@ void MsgLoop::RunUntilIdleForTesting() {
   }
 }
 
+void MsgLoop::DiscardPendingTasks() {
+  std::queue<std::function<void()>> tasks;
+  {
+    std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+    task_queue_.swap(tasks);
+  }
+  // The tasks are destroyed here, outside the lock.
+}
+
 MsgLoop* MsgLoop::Current() {
   return g_current;
 }
@@ -16,6 +16,7 @@ class MsgLoop {
   ~MsgLoop();
 
   // Blocks until PostQuit() is called, processing work items posted via
+  // PostTask(). Can be called again after it returns.
   void Run();
 
   // Schedules Run() to exit, but will not happen until other outstanding tasks
@@ -29,6 +30,10 @@ class MsgLoop {
   // Run()s until the queue is empty. Should only be used (carefully) in tests.
   void RunUntilIdleForTesting();
 
+  // Drops the work items that were posted but haven't run. Used to abandon
+  // work left over when Run() was made to exit early.
+  void DiscardPendingTasks();
+
   // Gets the MsgLoop for the thread from which it's called, or nullptr if
   // there's no MsgLoop for the current thread.
   static MsgLoop* Current();
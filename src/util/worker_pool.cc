@@ -8,9 +8,25 @@
 #include "base/strings/string_number_conversions.h"
 #include "gn/switches.h"
 #include "util/sys_info.h"
+#include "util/ticks.h"
 
 namespace {
 
+// Identifies the pool and deque owned by the current thread, if the current
+// thread is a pool worker.
+struct CurrentWorker {
+  const WorkerPool* pool = nullptr;
+  size_t index = 0;
+};
+
+#if !defined(OS_ZOS)
+thread_local CurrentWorker g_current_worker;
+#else
+// TODO(gabylb) - zos: thread_local not yet supported, use zoslib's impl'n:
+__tlssim<CurrentWorker> __g_current_worker_impl(CurrentWorker{});
+#define g_current_worker (*__g_current_worker_impl.access())
+#endif
+
 int GetThreadCount() {
   std::string thread_count =
       base::CommandLine::ForCurrentProcess()->GetSwitchValueString(
@@ -41,23 +57,35 @@ int GetThreadCount() {
   return std::max(num_cores - 1, 8);
 }
 
+void UpdateMax(std::atomic<uint64_t>* max, uint64_t value) {
+  uint64_t cur = max->load(std::memory_order_relaxed);
+  while (value > cur &&
+         !max->compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+  }
+}
+
 }  // namespace
 
 WorkerPool::WorkerPool() : WorkerPool(GetThreadCount()) {}
 
-WorkerPool::WorkerPool(size_t thread_count) : should_stop_processing_(false) {
+WorkerPool::WorkerPool(size_t thread_count) {
+  CHECK(thread_count > 0);
+  queues_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i)
+    queues_.push_back(std::make_unique<WorkQueue>());
+
   threads_.reserve(thread_count);
   for (size_t i = 0; i < thread_count; ++i)
-    threads_.emplace_back([this]() { Worker(); });
+    threads_.emplace_back([this, i]() { Worker(i); });
 }
 
 WorkerPool::~WorkerPool() {
   {
-    std::unique_lock<std::mutex> queue_lock(queue_mutex_);
+    std::unique_lock<std::mutex> sleep_lock(sleep_mutex_);
     should_stop_processing_ = true;
   }
 
-  pool_notifier_.notify_all();
+  sleep_notifier_.notify_all();
 
   for (auto& task_thread : threads_) {
     task_thread.join();
@@ -65,33 +93,102 @@ WorkerPool::~WorkerPool() {
 }
 
 void WorkerPool::PostTask(std::function<void()> work) {
+  CHECK(!should_stop_processing_);
+
+  // Work produced by a worker stays on that worker's deque. Everything else
+  // is spread over the deques so that no single one becomes hot.
+  size_t index;
+  if (g_current_worker.pool == this) {
+    index = g_current_worker.index;
+  } else {
+    index = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+            queues_.size();
+  }
+
+  size_t depth;
   {
-    std::unique_lock<std::mutex> queue_lock(queue_mutex_);
-    CHECK(!should_stop_processing_);
-    task_queue_.emplace(std::move(work));
+    WorkQueue* queue = queues_[index].get();
+    std::lock_guard<std::mutex> queue_lock(queue->lock);
+    queue->tasks.emplace_back(std::move(work));
+    depth = queued_count_.fetch_add(1) + 1;
+  }
+  tasks_posted_.fetch_add(1, std::memory_order_relaxed);
+  UpdateMax(&max_queue_depth_, depth);
+
+  // The increment of |queued_count_| above and the check of
+  // |sleeping_count_| here pair with the opposite order in Worker(), so
+  // either the sleeping worker sees the new task or this thread sees the
+  // sleeper and wakes it.
+  if (sleeping_count_.load() > 0) {
+    std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+    sleep_notifier_.notify_one();
   }
+}
 
-  pool_notifier_.notify_one();
+WorkerPool::Stats WorkerPool::GetStats() const {
+  Stats stats;
+  stats.tasks_posted = tasks_posted_.load(std::memory_order_relaxed);
+  stats.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  stats.steals = steals_.load(std::memory_order_relaxed);
+  stats.idle_nanoseconds = idle_nanoseconds_.load(std::memory_order_relaxed);
+  stats.max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  return stats;
 }
 
-void WorkerPool::Worker() {
+bool WorkerPool::TakeTask(size_t index, std::function<void()>* task) {
+  // Newest task from our own deque first.
+  {
+    WorkQueue* queue = queues_[index].get();
+    std::lock_guard<std::mutex> queue_lock(queue->lock);
+    if (!queue->tasks.empty()) {
+      *task = std::move(queue->tasks.back());
+      queue->tasks.pop_back();
+      queued_count_.fetch_sub(1);
+      return true;
+    }
+  }
+
+  // Otherwise steal the oldest task from the next non-empty deque.
+  for (size_t i = 1; i < queues_.size(); ++i) {
+    WorkQueue* queue = queues_[(index + i) % queues_.size()].get();
+    std::lock_guard<std::mutex> queue_lock(queue->lock);
+    if (!queue->tasks.empty()) {
+      *task = std::move(queue->tasks.front());
+      queue->tasks.pop_front();
+      queued_count_.fetch_sub(1);
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::Worker(size_t index) {
+  g_current_worker.pool = this;
+  g_current_worker.index = index;
+
   for (;;) {
     std::function<void()> task;
+    if (TakeTask(index, &task)) {
+      task();
+      tasks_run_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
 
+    Ticks idle_begin = TicksNow();
     {
-      std::unique_lock<std::mutex> queue_lock(queue_mutex_);
-
-      pool_notifier_.wait(queue_lock, [this]() {
-        return (!task_queue_.empty()) || should_stop_processing_;
+      std::unique_lock<std::mutex> sleep_lock(sleep_mutex_);
+      sleeping_count_.fetch_add(1);
+      sleep_notifier_.wait(sleep_lock, [this]() {
+        return queued_count_.load() != 0 || should_stop_processing_;
       });
-
-      if (should_stop_processing_ && task_queue_.empty())
-        return;
-
-      task = std::move(task_queue_.front());
-      task_queue_.pop();
+      sleeping_count_.fetch_sub(1);
     }
+    idle_nanoseconds_.fetch_add(
+        TicksDelta(TicksNow(), idle_begin).InNanoseconds(),
+        std::memory_order_relaxed);
 
-    task();
+    if (should_stop_processing_ && queued_count_.load() == 0)
+      return;
   }
 }
@@ -5,30 +5,95 @@
 #ifndef UTIL_WORKER_POOL_H_
 #define UTIL_WORKER_POOL_H_
 
+#include <stdint.h>
+
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <vector>
 
 #include "base/logging.h"
 
+// A pool of worker threads, each with its own task deque.
+//
+// Tasks posted from one of the pool's own workers go on that worker's deque
+// and are popped LIFO by the owner, which keeps recently produced work (and
+// the data it touches) on the same core. Tasks posted from any other thread
+// are distributed round-robin over the deques. A worker whose deque is empty
+// steals the oldest task from another worker's deque before going to sleep.
+//
+// Each deque has its own lock, so posting and dequeueing no longer serialize
+// all threads on a single mutex. The only shared state touched on every
+// operation is an atomic count of queued tasks used to decide when idle
+// workers need to be woken up.
 class WorkerPool {
  public:
+  // Counters describing the scheduling behavior of the pool. All values are
+  // cumulative over the lifetime of the pool.
+  struct Stats {
+    uint64_t tasks_posted = 0;
+    uint64_t tasks_run = 0;
+
+    // Number of tasks a worker took from another worker's deque.
+    uint64_t steals = 0;
+
+    // Total time, summed over all workers, spent blocked with nothing to do.
+    uint64_t idle_nanoseconds = 0;
+
+    // Largest number of tasks observed waiting in the pool at once.
+    uint64_t max_queue_depth = 0;
+  };
+
   WorkerPool();
   WorkerPool(size_t thread_count);
   ~WorkerPool();
 
   void PostTask(std::function<void()> work);
 
+  size_t thread_count() const { return threads_.size(); }
+
+  // Returns a snapshot of the counters. Can be called from any thread.
+  Stats GetStats() const;
+
  private:
-  void Worker();
+  struct WorkQueue {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void Worker(size_t index);
+
+  // Takes a task from the back of the given worker's own deque or, failing
+  // that, from the front of another worker's deque. Returns false if every
+  // deque was empty.
+  bool TakeTask(size_t index, std::function<void()>* task);
 
   std::vector<std::thread> threads_;
-  std::queue<std::function<void()>> task_queue_;
-  std::mutex queue_mutex_;
-  std::condition_variable_any pool_notifier_;
-  bool should_stop_processing_;
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+
+  // Number of tasks sitting in a deque. Idle workers sleep until this is
+  // nonzero.
+  std::atomic<size_t> queued_count_ = 0;
+
+  // Round-robin cursor for tasks posted from outside the pool.
+  std::atomic<size_t> next_queue_ = 0;
+
+  // Sleeping workers wait on |sleep_notifier_|. |sleeping_count_| lets
+  // PostTask() skip taking |sleep_mutex_| when every worker is busy.
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_notifier_;
+  std::atomic<int> sleeping_count_ = 0;
+  std::atomic<bool> should_stop_processing_ = false;
+
+  std::atomic<uint64_t> tasks_posted_ = 0;
+  std::atomic<uint64_t> tasks_run_ = 0;
+  std::atomic<uint64_t> steals_ = 0;
+  std::atomic<uint64_t> idle_nanoseconds_ = 0;
+  std::atomic<uint64_t> max_queue_depth_ = 0;
 
   WorkerPool(const WorkerPool&) = delete;
   WorkerPool& operator=(const WorkerPool&) = delete;
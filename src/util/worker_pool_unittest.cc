@@ -0,0 +1,95 @@
+// Copyright 2024 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "util/worker_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "util/test/test.h"
+
+namespace {
+
+// Counts down from a given number and signals when it reaches zero.
+class Latch {
+ public:
+  explicit Latch(int count) : count_(count) {}
+
+  void CountDown() {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (--count_ == 0)
+      cv_.notify_all();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(lock_);
+    cv_.wait(lock, [this]() { return count_ == 0; });
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  int count_;
+};
+
+}  // namespace
+
+TEST(WorkerPool, RunsAllTasks) {
+  constexpr int kTaskCount = 1000;
+  std::atomic<int> run_count = 0;
+  Latch done(kTaskCount);
+  {
+    WorkerPool pool(4);
+    for (int i = 0; i < kTaskCount; i++) {
+      pool.PostTask([&run_count, &done]() {
+        run_count++;
+        done.CountDown();
+      });
+    }
+    done.Wait();
+
+    WorkerPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(static_cast<uint64_t>(kTaskCount), stats.tasks_posted);
+    EXPECT_LE(1u, stats.max_queue_depth);
+  }
+  EXPECT_EQ(kTaskCount, run_count.load());
+}
+
+// Tasks posted by tasks land on the posting worker's deque. They must still
+// all run, either by the owner or by other workers stealing them.
+TEST(WorkerPool, NestedPosts) {
+  constexpr int kOuter = 8;
+  constexpr int kInner = 100;
+  std::atomic<int> run_count = 0;
+  Latch done(kOuter * kInner);
+  {
+    WorkerPool pool(4);
+    for (int i = 0; i < kOuter; i++) {
+      pool.PostTask([&pool, &run_count, &done]() {
+        for (int j = 0; j < kInner; j++) {
+          pool.PostTask([&run_count, &done]() {
+            run_count++;
+            done.CountDown();
+          });
+        }
+      });
+    }
+    done.Wait();
+    EXPECT_EQ(static_cast<uint64_t>(kOuter + kOuter * kInner),
+              pool.GetStats().tasks_posted);
+  }
+  EXPECT_EQ(kOuter * kInner, run_count.load());
+}
+
+// Destroying the pool runs everything that is still queued.
+TEST(WorkerPool, DrainsOnDestruction) {
+  std::atomic<int> run_count = 0;
+  {
+    WorkerPool pool(2);
+    for (int i = 0; i < 50; i++)
+      pool.PostTask([&run_count]() { run_count++; });
+  }
+  EXPECT_EQ(50, run_count.load());
+}